@@ -0,0 +1,81 @@
+#ifndef ADC_SAMPLER
+#define ADC_SAMPLER
+
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+#include "common.hpp"
+
+namespace AdcSampler
+{
+    /**
+     * Produces blocks of ADC samples, so the consuming task wakes once per block rather than once per
+     * sample.
+     */
+    class BlockSource
+    {
+    public:
+        virtual ~BlockSource() = default;
+
+        virtual bool start(const int8_t pin_id, const Hertz sample_rate) = 0;
+
+        // Blocks until a full block is available or ticks_to_wait expires; returns the samples written.
+        virtual size_t read_block(uint16_t *samples, const size_t number_of_samples, const TickType_t ticks_to_wait) = 0;
+    };
+
+    /**
+     * Reads the whole block back to back through the HAL as soon as it is asked for, so it never waits:
+     * the caller's schedule sets the block rate. The sample rate is not honoured within a block - the
+     * samples are one conversion time apart - so oversampling a burst averages out conversion noise
+     * rather than the signal over the period. Works on any pin, including ADC2 pins and the simulated
+     * pins of the native build.
+     */
+    class BurstSource : public BlockSource
+    {
+    public:
+        bool start(const int8_t pin_id, const Hertz sample_rate) override;
+        size_t read_block(uint16_t *samples, const size_t number_of_samples, const TickType_t ticks_to_wait) override;
+
+    private:
+        int8_t pin_id = -1;
+    };
+
+    /**
+     * Selects the best source for the pin: the I2S DMA path for ADC1 pins on the ESP32, the burst source
+     * otherwise (ADC2 pins cannot be routed to I2S, and the native build has no DMA).
+     */
+    BlockSource &create_block_source(const int8_t pin_id, const Hertz sample_rate);
+
+    /**
+     * Block-based oversampling stage: averages every FACTOR consecutive samples into one output,
+     * carrying partial groups over from one block to the next.
+     */
+    template <size_t FACTOR>
+    class Decimator
+    {
+        static_assert(FACTOR > 0 && FACTOR <= 65536, "Decimation factor must fit a 32-bit accumulator.");
+
+    public:
+        template <typename Output>
+        void process(const uint16_t *samples, const size_t number_of_samples, Output &&output)
+        {
+            for (size_t i = 0; i < number_of_samples; i++)
+            {
+                sum += samples[i];
+                if (++count == FACTOR)
+                {
+                    output(static_cast<uint16_t>((sum + FACTOR / 2) / FACTOR));
+                    sum = 0;
+                    count = 0;
+                }
+            }
+        }
+
+    private:
+        uint32_t sum = 0;
+        size_t count = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef BACKGROUND
+#define BACKGROUND
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+namespace Background
+{
+    /**
+     * Idle accounting. The idle hook runs back to back while a core has nothing else to do, so the
+     * time between two consecutive calls is idle time unless it is long enough for something else to
+     * have run in between. On the ESP32 the hook returns false to keep the idle task spinning rather
+     * than waiting for an interrupt, which would hide that distinction. Once Power::begin() has
+     * succeeded it lets the idle task wait instead: idle time then reads low, so the executor stays
+     * near its minimum and spare CPU time goes to saving power rather than to background work.
+     */
+    bool on_idle();
+    void install_idle_hooks();
+    // Cycles the calling core has spent idle since boot; wraps like Instrumentation::cycle_count().
+    uint32_t idle_cycles();
+
+    struct Metrics
+    {
+        uint32_t units_per_period;
+        uint32_t units_per_second;  // achieved background throughput over the last period
+        uint16_t utilisation;       // of the executor's core over the last period, in 0.01 %
+        uint16_t back_offs;         // times a guarded task forced the work down
+    };
+
+    struct Settings
+    {
+        uint16_t target_utilisation; // in 0.01 %
+        uint32_t minimum_units;
+        uint32_t maximum_units;
+        std::array<uint8_t, 4> guarded_tasks; // task numbers, 0 for unused entries
+    };
+
+    /**
+     * Runs a variable amount of background work once per period and adjusts it to hold the core at the
+     * target utilisation: additive increase while below it, multiplicative decrease above it. The work
+     * is cut to the minimum when a guarded task misses a deadline and halved when one responds in more
+     * than half its period, so the background load gives way before the guarded tasks overrun.
+     */
+    class Executor
+    {
+    public:
+        using Work = void (*)(const uint32_t units);
+
+        Executor(const Settings &settings, Work work);
+
+        // One period's worth: measure, adjust, then run the work.
+        void run();
+
+        Metrics metrics() const
+        {
+            return latest;
+        }
+
+    private:
+        struct Guard
+        {
+            uint32_t deadline_misses;
+            uint32_t slow_responses;
+        };
+
+        bool guarded_task_at_risk(bool &missed);
+
+        const Settings settings;
+        const Work work;
+        uint32_t units;
+        std::array<Guard, 4> guards = {};
+        uint32_t previous_cycles;
+        uint32_t previous_idle_cycles;
+        Metrics latest = {};
+    };
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BENCHMARK
+#define BENCHMARK
+
+#include <cstdint>
+
+/**
+ * Measurements the firmware keeps about itself while it runs. The kernel micro-benchmarks are a pio
+ * test target instead: test/test_benchmark, compared on the host against
+ * benchmarks/baseline-native.json.
+ */
+namespace Benchmark
+{
+    /**
+     * End-to-end latency of the sample chain: from Task 4 capturing an ADC block to Task 7 evaluating
+     * the error code from it.
+     */
+    struct SampleLatency
+    {
+        uint32_t blocks;
+        uint32_t maximum_us;
+        uint64_t total_us;
+
+        void add(const uint32_t latency_us)
+        {
+            blocks++;
+            maximum_us = (latency_us > maximum_us) ? latency_us : maximum_us;
+            total_us += latency_us;
+        }
+
+        uint32_t mean_us() const
+        {
+            return blocks ? static_cast<uint32_t>(total_us / blocks) : 0;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef BINARY_LOG
+#define BINARY_LOG
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.hpp"
+
+namespace BinaryLog
+{
+    enum class RecordType : uint8_t
+    {
+        DigitalInput = 1,        // aux: raw edges (low 16 bits), value0: state, value1: detection latency us
+        SquareWaveFrequency = 2, // value0: millihertz
+        AnalogueReadings = 3,    // aux: count, value0/value1: up to four uint16_t readings, low half first
+        FilteredAnalogue = 4,    // value0: hundredths of an ADC count
+        ErrorCode = 5,           // value0: error code
+        Snapshot = 6,            // aux: digital input state, value0: millihertz, value1: hundredths of a count
+        DataUnavailable = 7,     // a signal the logger reads has not been published yet
+        RecordsDropped = 8,      // value0: records lost because the ring buffer was full
+        TaskTiming = 9,          // aux: deadline misses, value0: max execution us, value1: max start jitter us
+        TaskTimingMean = 10,     // aux: activations (low 16 bits), value0: mean execution us, value1: mean start jitter us
+        CoreLoad = 11,           // task: core (0xFF unpinned), aux: tasks, value0/value1: measured/budgeted load in 0.01 %
+        StackUsage = 12,         // aux: recommended bytes, value0: peak bytes, value1: allocated bytes
+        HeapUsage = 13,          // value0: free bytes, value1: minimum free bytes since boot
+        AnalogueStatistics = 14, // aux: samples in window, value0/value1: mean/standard deviation in hundredths of a count
+        AnalogueRange = 15,      // value0/value1: window minimum/maximum in hundredths of a count
+        AnaloguePercentiles = 16, // value0/value1: window median/95th percentile in hundredths of a count
+        BackgroundWork = 17,     // aux: units per period, value0: units per second, value1: core utilisation in 0.01 %
+        PowerLevels = 18,        // aux: power management active, value0/value1: time at full speed/allowed to light sleep in 0.01 %
+        WakeLatency = 19,        // aux: wakes (low 16 bits), value0: maximum us, value1: mean us
+        RecorderThroughput = 20, // aux: flash programs (low 16 bits), value0: records stored, value1: records lost
+        RecorderWear = 21,       // aux: sectors, value0: highest sector erase count, value1: sector erases this boot
+        SampleLatency = 22,      // aux: blocks (low 16 bits), value0: mean us, value1: maximum us, ADC block to error code
+        RecorderStall = 23,      // aux: records shed by the erase rate limit (low 16 bits), value0: longest sector erase us, value1: mean erase us
+        RecordsShed = 24,        // in flash only, ahead of the first record kept after a shed: value0: records shed, value1: us since the first of them
+    };
+
+    /**
+     * Fixed-size, little-endian record. Values are scaled integers so producers never format text and
+     * the decoder (tools/decode_log.py) can reproduce them exactly.
+     */
+    struct Record
+    {
+        uint32_t timestamp; // microseconds since boot
+        RecordType type;
+        uint8_t task;
+        uint16_t aux;
+        int32_t value0;
+        int32_t value1;
+    };
+    static_assert(sizeof(Record) == 16, "Records are transmitted as 16 bytes.");
+
+    /**
+     * Bounded multi-producer ring (Vyukov's per-slot sequence scheme). Producers claim a slot with one
+     * compare-exchange and never wait; when the ring is full the record is counted as dropped instead.
+     */
+    template <size_t CAPACITY>
+    class RecordRing
+    {
+        static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two.");
+
+    public:
+        RecordRing()
+        {
+            for (size_t i = 0; i < CAPACITY; i++)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bool push(const Record &record)
+        {
+            auto position = enqueue_position.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto &slot = slots[position & (CAPACITY - 1)];
+                const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0)
+                {
+                    if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        slot.record = record;
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    position = enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Single consumer.
+        bool pop(Record &record)
+        {
+            auto &slot = slots[dequeue_position & (CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+                return false;
+            record = slot.record;
+            slot.sequence.store(dequeue_position + CAPACITY, std::memory_order_release);
+            dequeue_position++;
+            return true;
+        }
+
+        uint32_t take_dropped()
+        {
+            return dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            Record record;
+        };
+
+        std::array<Slot, CAPACITY> slots;
+        std::atomic<size_t> enqueue_position{0};
+        size_t dequeue_position = 0;
+        std::atomic<uint32_t> dropped{0};
+    };
+
+    enum class Framing : uint8_t
+    {
+        Raw,  // 0xA5 0x5A, u16 length, packet
+        Cobs, // COBS-encoded packet followed by a 0x00 delimiter
+    };
+
+    constexpr size_t RING_CAPACITY = 256;
+    constexpr size_t RECORDS_PER_PACKET = 32;
+
+    // Live packets: u8 version, u8 record count, u16 packet sequence, records.
+    constexpr uint8_t LIVE_PACKET_VERSION = 1;
+    constexpr size_t LIVE_PACKET_HEADER_SIZE = 4;
+    // Exported packets add an i64 recorder time for the first record; see Recorder.
+    constexpr uint8_t EXPORT_PACKET_VERSION = 2;
+    constexpr size_t EXPORT_PACKET_HEADER_SIZE = 12;
+    constexpr size_t PACKET_CRC_SIZE = 2;
+    constexpr size_t MAXIMUM_PACKET_SIZE = EXPORT_PACKET_HEADER_SIZE + RECORDS_PER_PACKET * sizeof(Record) + PACKET_CRC_SIZE;
+
+    // Callable from any task; returns false (and counts a drop) if the ring is full.
+    bool log(const RecordType type,
+             const uint8_t task,
+             const int32_t value0 = 0,
+             const int32_t value1 = 0,
+             const uint16_t aux = 0);
+
+    // Sees every record drain() sends, e.g. to keep a persistent copy.
+    using Sink = void (*)(void *context, const Record &record);
+
+    /**
+     * Moves up to RECORDS_PER_PACKET records from the ring into one live packet and sends it, passing
+     * each record to the sink as well if there is one. Returns the number of records sent.
+     */
+    size_t drain(const Framing framing, Sink sink = nullptr, void *context = nullptr);
+
+    /**
+     * Appends a CRC-16/CCITT-FALSE of the preceding bytes to a packet the caller has assembled, frames
+     * it and writes it to the serial port. The packet buffer must have room for the CRC, and only the
+     * log drain task may call this, as the frame buffer is shared.
+     */
+    void send_packet(uint8_t *packet, size_t length, const Framing framing);
+
+    uint16_t crc16(const uint8_t *data, const size_t length);
+    size_t cobs_encode(const uint8_t *input, const size_t length, uint8_t *output);
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef BLOCK_POOL
+#define BLOCK_POOL
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+namespace BlockPool
+{
+    /**
+     * Fixed set of statically allocated blocks that are filled in place and passed between tasks by
+     * pointer. Free blocks are tracked in one atomic bitmap, so acquire() and release() never lock and
+     * are safe from any task. Each block carries a reference count: a producer that hands a block to
+     * several consumers retains it once per extra consumer, and the last release() returns it.
+     */
+    template <typename T, size_t CAPACITY>
+    class BlockPool
+    {
+        static_assert(CAPACITY > 0 && CAPACITY <= 32, "The free bitmap is 32 bits wide.");
+
+    public:
+        BlockPool() : free_blocks(CAPACITY == 32 ? UINT32_MAX : (UINT32_C(1) << CAPACITY) - 1)
+        {
+            for (auto &count : references)
+                count.store(0, std::memory_order_relaxed);
+        }
+
+        BlockPool(const BlockPool &) = delete;
+        BlockPool &operator=(const BlockPool &) = delete;
+
+        // A block with one reference, or nullptr if every block is in use.
+        T *acquire()
+        {
+            auto free = free_blocks.load(std::memory_order_relaxed);
+            while (free != 0)
+            {
+                const auto index = static_cast<size_t>(__builtin_ctz(free));
+                if (free_blocks.compare_exchange_weak(free,
+                                                      free & ~(UINT32_C(1) << index),
+                                                      std::memory_order_acquire,
+                                                      std::memory_order_relaxed))
+                {
+                    references[index].store(1, std::memory_order_relaxed);
+                    return &blocks[index];
+                }
+            }
+            return nullptr;
+        }
+
+        void retain(T *block, const uint8_t count = 1)
+        {
+            references[index_of(block)].fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void release(T *block)
+        {
+            const auto index = index_of(block);
+            if (references[index].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                free_blocks.fetch_or(UINT32_C(1) << index, std::memory_order_release);
+        }
+
+        size_t available() const
+        {
+            return static_cast<size_t>(__builtin_popcount(free_blocks.load(std::memory_order_relaxed)));
+        }
+
+    private:
+        size_t index_of(const T *block) const
+        {
+            return static_cast<size_t>(block - blocks.data());
+        }
+
+        std::array<T, CAPACITY> blocks = {};
+        std::array<std::atomic<uint8_t>, CAPACITY> references;
+        std::atomic<uint32_t> free_blocks;
+    };
+
+    /**
+     * Single-slot, latest-wins hand-over of block pointers between two tasks, backed by a statically
+     * allocated queue. publish() transfers one reference to the channel; a block that was never
+     * received is released when a newer one replaces it. receive() transfers the reference to the
+     * caller, who must release it.
+     */
+    template <typename T, size_t CAPACITY>
+    class Channel
+    {
+    public:
+        explicit Channel(BlockPool<T, CAPACITY> &pool)
+            : pool(pool),
+              queue(xQueueCreateStatic(1, sizeof(T *), storage.data(), &queue_buffer)) {}
+
+        Channel(const Channel &) = delete;
+        Channel &operator=(const Channel &) = delete;
+
+        void publish(T *block)
+        {
+            T *stale;
+            if (xQueueReceive(queue, &stale, 0) == pdPASS)
+                pool.release(stale);
+            if (xQueueSend(queue, &block, 0) != pdPASS)
+                pool.release(block);
+        }
+
+        T *receive(const TickType_t ticks_to_wait)
+        {
+            T *block;
+            return (xQueueReceive(queue, &block, ticks_to_wait) == pdPASS) ? block : nullptr;
+        }
+
+    private:
+        BlockPool<T, CAPACITY> &pool;
+        std::array<uint8_t, sizeof(T *)> storage = {};
+        StaticQueue_t queue_buffer;
+        QueueHandle_t queue;
+    };
+}
+
+#endif
@@ -1,9 +1,10 @@
 #ifndef COMMON
 #define COMMON
 
-#include <Arduino.h>
+#include "platform.hpp"
 #include <cstdint> // fixed-width integer types
 
+// Configuration values, evaluated at compile time. Run-time paths use the integer types in units.hpp.
 typedef double Microseconds;
 typedef double Milliseconds;
 typedef double Seconds;
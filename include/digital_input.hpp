@@ -0,0 +1,97 @@
+#ifndef DIGITAL_INPUT_DISPATCHER
+#define DIGITAL_INPUT_DISPATCHER
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+#include "common.hpp"
+#include "protected_types.hpp"
+
+#ifdef NATIVE
+#include <timers.h>
+#else
+#include <freertos/timers.h>
+#endif
+
+namespace DigitalInput
+{
+    constexpr size_t MAXIMUM_PINS = 8;
+    constexpr size_t MAXIMUM_SUBSCRIBERS = 4;
+
+    struct Event
+    {
+        bool level;
+        uint32_t timestamp; // Hal::micros() of the edge that caused the change
+        uint32_t changes;   // debounced changes since watching started
+        uint32_t edges;     // raw edges seen, bounces included
+    };
+
+    /**
+     * Debounces any number of input pins from their change interrupts and wakes subscribers only when
+     * a pin's debounced state changes.
+     *
+     * The first edge that leaves the stable state is accepted immediately, so detection latency is
+     * one interrupt, and its timestamp is kept. Further edges are ignored for the debounce interval;
+     * when it expires the pin is read again and a change that happened meanwhile is accepted too.
+     * Subscribers get their pin's notification bit set (eSetBits) and read the event with latest().
+     */
+    class Dispatcher
+    {
+    public:
+        Dispatcher() = default;
+        Dispatcher(const Dispatcher &) = delete;
+        Dispatcher &operator=(const Dispatcher &) = delete;
+
+        /**
+         * Subscribes a task to a pin and returns the notification bit it will receive for it, or 0 if
+         * there is no room. Watching an already watched pin adds a subscriber; the first debounce
+         * interval given for a pin is kept.
+         */
+        uint32_t watch(const int8_t pin_id, const Milliseconds debounce, const TaskHandle_t subscriber);
+
+        bool latest(const int8_t pin_id, Event &event) const;
+
+    private:
+        struct Channel
+        {
+            int8_t pin_id = -1;
+            uint32_t bit = 0;
+            std::array<TaskHandle_t, MAXIMUM_SUBSCRIBERS> subscribers = {};
+            std::atomic<bool> stable_level{false};
+            std::atomic<bool> locked{false}; // held from an accepted change until its debounce interval ends
+            std::atomic<uint32_t> changes{0};
+            std::atomic<uint32_t> edges{0};
+            ProtectedTypes::SeqLocked<Event> event;
+            StaticTimer_t timer_buffer;
+            TimerHandle_t timer = nullptr;
+#ifdef NATIVE
+            std::atomic<bool> pending{false};
+#endif
+        };
+
+        static void on_change(void *context, const uint32_t timestamp, const bool level);
+        static void on_debounce_expired(TimerHandle_t timer);
+
+        static void accept(Channel &channel, const bool level, const uint32_t timestamp);
+        static void notify_from_interrupt(Channel &channel);
+        static void notify(Channel &channel);
+
+        const Channel *find(const int8_t pin_id) const;
+
+        std::array<Channel, MAXIMUM_PINS> channels;
+        size_t number_of_channels = 0;
+#ifdef NATIVE
+        static void forward_pending(TimerHandle_t timer);
+        StaticTimer_t forwarding_timer_buffer;
+        TimerHandle_t forwarding_timer = nullptr;
+#endif
+    };
+
+    Dispatcher &dispatcher();
+}
+
+#endif
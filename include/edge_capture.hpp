@@ -0,0 +1,101 @@
+#ifndef EDGE_CAPTURE
+#define EDGE_CAPTURE
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+#include "common.hpp"
+#include "hal.hpp"
+#include "units.hpp"
+
+namespace EdgeCapture
+{
+    /**
+     * Timestamps rising edges of a pin from its interrupt handler into a lock-free single-producer ring
+     * buffer, so the frequency can be computed over several full periods without ever busy-waiting.
+     * The interrupt only stores the timestamp and publishes the new head; readers never block it.
+     * Both run in IRAM, so they keep working while a flash erase has the cache disabled.
+     */
+    template <size_t CAPACITY = 32>
+    class EdgeCapture
+    {
+        static_assert(CAPACITY >= 4 && (CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two, at least 4.");
+
+    public:
+        static constexpr size_t MAXIMUM_PERIODS = CAPACITY / 2;
+
+        void attach(const int8_t pin_id)
+        {
+            Hal::get().attach_rising_edge_interrupt(pin_id, &EdgeCapture::on_rising_edge, this);
+        }
+
+        static void IRAM_ATTR on_rising_edge(void *context, const uint32_t timestamp)
+        {
+            static_cast<EdgeCapture *>(context)->push(timestamp);
+        }
+
+        void IRAM_ATTR push(const uint32_t timestamp)
+        {
+            const auto head = edges_captured.load(std::memory_order_relaxed);
+            timestamps[head & (CAPACITY - 1)] = timestamp;
+            edges_captured.store(head + 1, std::memory_order_release);
+        }
+
+        /**
+         * Average frequency over the most recent number_of_periods full periods. Returns 0 when fewer
+         * edges than that have been seen, or when no edge arrived within two mean periods of now (the
+         * signal has stopped). An edge newer than now, captured after the caller read the clock, counts
+         * as live.
+         */
+        Units::MilliHertz frequency(size_t number_of_periods, const uint32_t now) const
+        {
+            if (number_of_periods == 0)
+                number_of_periods = 1;
+            if (number_of_periods > MAXIMUM_PERIODS)
+                number_of_periods = MAXIMUM_PERIODS;
+
+            for (;;)
+            {
+                const auto head = edges_captured.load(std::memory_order_acquire);
+                if (head <= number_of_periods)
+                    return Units::MilliHertz(0);
+
+                const auto newest = timestamps[(head - 1) & (CAPACITY - 1)];
+                const auto oldest = timestamps[(head - 1 - number_of_periods) & (CAPACITY - 1)];
+
+                // The interrupt may have lapped the slots just read; retry with the newer head if so. The
+                // fence keeps the timestamp reads before the re-load, as in SeqLocked. With `pushed` edges
+                // published, edge head + pushed may be mid-write, and that reaches the oldest slot read
+                // once pushed >= CAPACITY - number_of_periods - 1.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const auto pushed = edges_captured.load(std::memory_order_relaxed) - head;
+                if (pushed >= CAPACITY - number_of_periods - 1)
+                    continue;
+
+                const uint32_t window = newest - oldest; // unsigned arithmetic handles micros() wrap-around
+                if (window == 0)
+                    return Units::MilliHertz(0);
+                const uint32_t mean_period = window / number_of_periods;
+                if (static_cast<int32_t>(now - newest) > static_cast<int32_t>(2 * mean_period))
+                    return Units::MilliHertz(0);
+
+                return Units::frequency(static_cast<uint32_t>(number_of_periods), Units::Microseconds(window));
+            }
+        }
+
+        uint32_t edge_count() const
+        {
+            return edges_captured.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<uint32_t, CAPACITY> timestamps = {};
+        std::atomic<uint32_t> edges_captured{0};
+    };
+}
+
+#endif
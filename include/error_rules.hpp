@@ -0,0 +1,123 @@
+#ifndef ERROR_RULES
+#define ERROR_RULES
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "statistics.hpp"
+#include "units.hpp"
+
+namespace ErrorRules
+{
+    enum class Metric : uint8_t
+    {
+        Level, // the filtered input
+        Noise, // standard deviation over the statistics window
+        Drift, // distance of the filtered input from the window mean
+    };
+
+    struct Inputs
+    {
+        Units::AdcCounts level;
+        Statistics::Snapshot statistics; // samples == 0 until the first window statistics arrive
+    };
+
+    /**
+     * Raises code once the metric has been above raise_above for persistence evaluations in a row, and
+     * clears it once it has been below clear_below for as many; the band in between holds the state,
+     * so a metric hovering around one threshold cannot make the code flap.
+     */
+    struct Rule
+    {
+        uint8_t code;
+        Metric metric;
+        Units::AdcCounts raise_above;
+        Units::AdcCounts clear_below;
+        uint8_t persistence;
+    };
+
+    // False if the metric cannot be measured yet.
+    constexpr bool measure(const Metric metric, const Inputs &inputs, Units::AdcCounts &value)
+    {
+        if (metric == Metric::Level)
+        {
+            value = inputs.level;
+            return true;
+        }
+        if (inputs.statistics.samples == 0)
+            return false;
+        if (metric == Metric::Noise)
+            value = inputs.statistics.standard_deviation;
+        else
+            value = (inputs.level > inputs.statistics.mean) ? inputs.level - inputs.statistics.mean
+                                                            : inputs.statistics.mean - inputs.level;
+        return true;
+    }
+
+    template <size_t N>
+    constexpr bool is_valid(const std::array<Rule, N> &rules)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            if (rules[i].code == 0 || rules[i].persistence == 0 || rules[i].clear_below > rules[i].raise_above)
+                return false;
+            for (size_t j = 0; j < i; j++)
+                if (rules[j].code == rules[i].code)
+                    return false;
+        }
+        return true;
+    }
+
+    /**
+     * Evaluates a constexpr rule table, which is checked at compile time. Rules are in priority order:
+     * the code is that of the first active rule, or 0 when none is.
+     */
+    template <size_t N, const std::array<Rule, N> &RULES>
+    class Evaluator
+    {
+        static_assert(is_valid(RULES), "Codes must be non-zero and unique, persistence at least one and "
+                                       "clear_below no higher than raise_above.");
+
+    public:
+        uint8_t evaluate(const Inputs &inputs)
+        {
+            uint8_t code = 0;
+            for (size_t i = 0; i < N; i++)
+            {
+                update(RULES[i], states[i], inputs);
+                if (code == 0 && states[i].active)
+                    code = RULES[i].code;
+            }
+            return code;
+        }
+
+    private:
+        struct State
+        {
+            bool active;
+            uint8_t consecutive; // evaluations in a row that argue for leaving the current state
+        };
+
+        static void update(const Rule &rule, State &state, const Inputs &inputs)
+        {
+            Units::AdcCounts value = Units::AdcCounts::from_raw(0);
+            const bool leaving = measure(rule.metric, inputs, value) &&
+                                 (state.active ? value < rule.clear_below : value > rule.raise_above);
+            if (!leaving)
+            {
+                state.consecutive = 0;
+                return;
+            }
+            if (++state.consecutive >= rule.persistence)
+            {
+                state.active = !state.active;
+                state.consecutive = 0;
+            }
+        }
+
+        std::array<State, N> states = {};
+    };
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef FILTERS
+#define FILTERS
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Filters
+{
+    /**
+     * Fixed-point coefficient format with FRACTIONAL_BITS fractional bits held in Storage, e.g. Q15 holds
+     * coefficients in [-1, 1) as int16_t. Samples stay integer ADC counts; products accumulate in 64 bits.
+     */
+    template <int FRACTIONAL_BITS, typename Storage>
+    struct Fixed
+    {
+        static_assert(FRACTIONAL_BITS > 0 && FRACTIONAL_BITS < static_cast<int>(sizeof(Storage) * 8), "Invalid Q format.");
+    };
+
+    using Q15 = Fixed<15, int16_t>;
+    using Q31 = Fixed<31, int32_t>;
+    // Biquad coefficients reach magnitudes up to 2, so they need integer bits.
+    using Q2_13 = Fixed<13, int16_t>;
+    using Q2_29 = Fixed<29, int32_t>;
+
+    template <typename Coefficient>
+    struct Arithmetic;
+
+    template <>
+    struct Arithmetic<float>
+    {
+        using coefficient_type = float;
+        using sample_type = float;
+        using accumulator_type = float;
+
+        static constexpr coefficient_type coefficient(const double value) { return static_cast<float>(value); }
+        static constexpr accumulator_type multiply(const coefficient_type c, const sample_type x) { return c * x; }
+        static constexpr sample_type output(const accumulator_type acc) { return acc; }
+    };
+
+    template <int FRACTIONAL_BITS, typename Storage>
+    struct Arithmetic<Fixed<FRACTIONAL_BITS, Storage>>
+    {
+        using coefficient_type = Storage;
+        using sample_type = int32_t;
+        using accumulator_type = int64_t;
+
+        // Rounds to nearest and saturates, so out-of-range constexpr coefficients clamp rather than wrap.
+        static constexpr coefficient_type coefficient(const double value)
+        {
+            const double scaled = value * static_cast<double>(int64_t(1) << FRACTIONAL_BITS);
+            const double rounded = scaled < 0 ? scaled - 0.5 : scaled + 0.5;
+            if (rounded >= static_cast<double>(std::numeric_limits<Storage>::max()))
+                return std::numeric_limits<Storage>::max();
+            if (rounded <= static_cast<double>(std::numeric_limits<Storage>::min()))
+                return std::numeric_limits<Storage>::min();
+            return static_cast<Storage>(rounded);
+        }
+
+        static constexpr accumulator_type multiply(const coefficient_type c, const sample_type x)
+        {
+            return static_cast<accumulator_type>(c) * x;
+        }
+
+        static constexpr sample_type output(const accumulator_type acc)
+        {
+            return static_cast<sample_type>((acc + (accumulator_type(1) << (FRACTIONAL_BITS - 1))) >> FRACTIONAL_BITS);
+        }
+    };
+
+    /**
+     * Moving average over the last TAPS samples. Keeps a running sum next to the circular history, so
+     * each sample costs one add and one subtract regardless of TAPS.
+     */
+    template <size_t TAPS, typename Sample = uint16_t, typename Sum = uint32_t>
+    class MovingAverage
+    {
+        static_assert(TAPS > 0, "A moving average needs at least one tap.");
+
+    public:
+        using sample_type = Sample;
+
+        void push(const Sample sample)
+        {
+            sum += sample;
+            sum -= history[index];
+            history[index] = sample;
+            index = (index + 1 == TAPS) ? 0 : index + 1;
+        }
+
+        float output() const
+        {
+            return static_cast<float>(sum) / static_cast<float>(TAPS);
+        }
+
+        // The mean with FRACTIONAL_BITS fractional bits, in integer arithmetic only.
+        template <int FRACTIONAL_BITS>
+        int32_t mean() const
+        {
+            return static_cast<int32_t>((static_cast<uint64_t>(sum) << FRACTIONAL_BITS) / TAPS);
+        }
+
+        Sum running_sum() const
+        {
+            return sum;
+        }
+
+    private:
+        std::array<Sample, TAPS> history = {};
+        size_t index = 0;
+        Sum sum = 0;
+    };
+
+    /**
+     * Direct-form FIR filter with coefficients converted to Coefficient at construction; constructing a
+     * static instance from a constexpr table performs the conversion at compile time.
+     */
+    template <size_t TAPS, typename Coefficient = float>
+    class Fir
+    {
+        static_assert(TAPS > 0, "A FIR filter needs at least one tap.");
+        using Maths = Arithmetic<Coefficient>;
+
+    public:
+        using sample_type = typename Maths::sample_type;
+
+        constexpr explicit Fir(const std::array<double, TAPS> &taps) : coefficients(convert(taps)) {}
+
+        void push(const sample_type sample)
+        {
+            index = (index == 0) ? TAPS - 1 : index - 1;
+            history[index] = sample;
+        }
+
+        // history[index] is the newest sample; walk forwards through the ring to older ones.
+        sample_type output() const
+        {
+            typename Maths::accumulator_type acc = 0;
+            size_t h = index;
+            for (size_t k = 0; k < TAPS; k++)
+            {
+                acc += Maths::multiply(coefficients[k], history[h]);
+                h = (h + 1 == TAPS) ? 0 : h + 1;
+            }
+            return Maths::output(acc);
+        }
+
+    private:
+        static constexpr std::array<typename Maths::coefficient_type, TAPS> convert(const std::array<double, TAPS> &taps)
+        {
+            std::array<typename Maths::coefficient_type, TAPS> converted = {};
+            for (size_t k = 0; k < TAPS; k++)
+                converted[k] = Maths::coefficient(taps[k]);
+            return converted;
+        }
+
+        std::array<typename Maths::coefficient_type, TAPS> coefficients;
+        std::array<sample_type, TAPS> history = {};
+        size_t index = 0;
+    };
+
+    /**
+     * Second-order IIR section in direct form I (which keeps intermediate values in the sample range and
+     * so suits fixed point). Coefficients are normalised so that a0 == 1.
+     */
+    template <typename Coefficient = float>
+    class Biquad
+    {
+        using Maths = Arithmetic<Coefficient>;
+
+    public:
+        using sample_type = typename Maths::sample_type;
+
+        struct Coefficients
+        {
+            double b0, b1, b2, a1, a2;
+        };
+
+        constexpr explicit Biquad(const Coefficients &c)
+            : b0(Maths::coefficient(c.b0)),
+              b1(Maths::coefficient(c.b1)),
+              b2(Maths::coefficient(c.b2)),
+              a1(Maths::coefficient(c.a1)),
+              a2(Maths::coefficient(c.a2)) {}
+
+        void push(const sample_type sample)
+        {
+            const typename Maths::accumulator_type acc = Maths::multiply(b0, sample) +
+                                                         Maths::multiply(b1, x1) +
+                                                         Maths::multiply(b2, x2) -
+                                                         Maths::multiply(a1, y1) -
+                                                         Maths::multiply(a2, y2);
+            x2 = x1;
+            x1 = sample;
+            y2 = y1;
+            y1 = Maths::output(acc);
+        }
+
+        sample_type output() const
+        {
+            return y1;
+        }
+
+    private:
+        typename Maths::coefficient_type b0, b1, b2, a1, a2;
+        sample_type x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    };
+}
+
+#endif
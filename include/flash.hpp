@@ -0,0 +1,90 @@
+#ifndef FLASH
+#define FLASH
+
+#include <cstddef>
+#include <cstdint>
+#ifdef NATIVE
+#include <cstdio>
+#endif
+
+namespace Flash
+{
+    constexpr size_t SECTOR_SIZE = 4096; // erase unit
+    constexpr size_t PAGE_SIZE = 256;    // largest single program
+
+    struct Statistics
+    {
+        uint32_t sector_erases;
+        uint32_t programs;
+        uint64_t bytes_programmed;
+        uint64_t bytes_read;
+        uint32_t overwrites; // programs that tried to set a bit NOR flash can only clear; host only
+    };
+
+    /**
+     * NOR flash as the recorder sees it: erasing a sector sets every bit, programming can only clear
+     * bits, and a program must not cross a page boundary. The ESP32 backend is the "telemetry" data
+     * partition. The host backend emulates the same rules on a file, so an image survives restarts of
+     * the native build and its statistics show what the same workload would cost real flash.
+     */
+    class Flash
+    {
+    public:
+        virtual ~Flash() = default;
+
+        virtual size_t size() const = 0;
+        virtual bool read(const size_t offset, void *data, const size_t length) = 0;
+        virtual bool program(const size_t offset, const void *data, const size_t length) = 0;
+        virtual bool erase_sector(const size_t sector) = 0;
+
+        Statistics statistics() const
+        {
+            return counters;
+        }
+
+    protected:
+        Statistics counters = {};
+    };
+
+    /**
+     * The region set aside for telemetry, or nullptr if there is none: the partition table lacks the
+     * partition, or (on the host) the image file named by TELEMETRY_FLASH, default telemetry.bin,
+     * cannot be created.
+     */
+    Flash *telemetry_flash();
+
+#ifdef NATIVE
+    // The host backend, which tests also open on images of their own.
+    class FileFlash : public Flash
+    {
+    public:
+        // The same size as the partition in partitions.csv.
+        static constexpr size_t IMAGE_SIZE = 0x100000;
+
+        ~FileFlash() override;
+
+        // Opens the image, creating it erased (or extending it) as needed.
+        bool open(const char *path);
+
+        size_t size() const override
+        {
+            return IMAGE_SIZE;
+        }
+        bool read(const size_t offset, void *data, const size_t length) override;
+        bool program(const size_t offset, const void *data, const size_t length) override;
+        bool erase_sector(const size_t sector) override;
+
+        // The next count erases report failure and leave their sectors as they were.
+        void fail_erases(const uint32_t count)
+        {
+            failing_erases = count;
+        }
+
+    private:
+        FILE *file = nullptr;
+        uint32_t failing_erases = 0;
+    };
+#endif
+}
+
+#endif
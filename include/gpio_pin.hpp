@@ -0,0 +1,145 @@
+#ifndef GPIO_PIN
+#define GPIO_PIN
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "hal.hpp"
+
+#ifndef NATIVE
+#include <soc/gpio_struct.h>
+#endif
+
+namespace Gpio
+{
+    constexpr int8_t NUMBER_OF_PINS = 40;
+
+    // GPIOs 20, 24 and 28-31 are not bonded out, and 6-11 are wired to the SPI flash.
+    constexpr bool exists(const int8_t pin_id)
+    {
+        return pin_id >= 0 && pin_id < NUMBER_OF_PINS && pin_id != 20 && pin_id != 24 &&
+               !(pin_id >= 28 && pin_id <= 31) && !(pin_id >= 6 && pin_id <= 11);
+    }
+
+    // GPIOs 34-39 are input only.
+    constexpr bool can_drive(const int8_t pin_id)
+    {
+        return exists(pin_id) && pin_id < 34;
+    }
+
+    constexpr bool is_output(const Hal::PinMode mode)
+    {
+        return mode == Hal::PinMode::Output;
+    }
+
+    /**
+     * A pin fixed at compile time. On the ESP32 set() and clear() are a single store to the GPIO
+     * write-1-to-set/clear registers and read() a single load, with no pin lookup, range check or
+     * lock on the way. The native build goes through the installed HAL, whose simulated pins record
+     * every write and edge. configure() still goes through the HAL on both: pinMode() also routes the
+     * pad to the GPIO matrix, which the registers alone do not.
+     */
+    template <int8_t N, Hal::PinMode MODE>
+    struct Pin
+    {
+        static_assert(exists(N), "Not a usable ESP32 GPIO.");
+        static_assert(!is_output(MODE) || can_drive(N), "GPIOs 34-39 cannot be outputs.");
+
+        static constexpr int8_t number = N;
+        static constexpr Hal::PinMode mode = MODE;
+
+        static void configure()
+        {
+            Hal::get().pin_mode(N, MODE);
+        }
+
+        static void set()
+        {
+            static_assert(is_output(MODE), "Only outputs can be set.");
+#ifdef NATIVE
+            Hal::get().digital_write(N, true);
+#else
+            if (N < 32)
+                GPIO.out_w1ts = UINT32_C(1) << (N & 31);
+            else
+                GPIO.out1_w1ts.val = UINT32_C(1) << (N & 31);
+#endif
+        }
+
+        static void clear()
+        {
+            static_assert(is_output(MODE), "Only outputs can be cleared.");
+#ifdef NATIVE
+            Hal::get().digital_write(N, false);
+#else
+            if (N < 32)
+                GPIO.out_w1tc = UINT32_C(1) << (N & 31);
+            else
+                GPIO.out1_w1tc.val = UINT32_C(1) << (N & 31);
+#endif
+        }
+
+        static void write(const bool level)
+        {
+            if (level)
+                set();
+            else
+                clear();
+        }
+
+        static bool read()
+        {
+#ifdef NATIVE
+            return Hal::get().digital_read(N);
+#else
+            if (N < 32)
+                return (GPIO.in >> (N & 31)) & 1;
+            return (GPIO.in1.data >> (N & 31)) & 1;
+#endif
+        }
+    };
+
+    // Which task uses a pin, and how. Task 0 is setup().
+    struct Claim
+    {
+        int8_t pin_id;
+        Hal::PinMode mode;
+        uint8_t task_number;
+    };
+
+    template <typename P>
+    constexpr Claim claim(const uint8_t task_number)
+    {
+        return {P::number, P::mode, task_number};
+    }
+
+    /**
+     * A pin may be shared by any number of readers in the same mode, but an output belongs to exactly
+     * one task and is never also read as an input.
+     */
+    template <size_t N>
+    constexpr bool claims_conflict_free(const std::array<Claim, N> &claims)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            for (size_t j = i + 1; j < N; j++)
+            {
+                if (claims[i].pin_id != claims[j].pin_id)
+                    continue;
+                if (is_output(claims[i].mode) || is_output(claims[j].mode) || claims[i].mode != claims[j].mode)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(claims_conflict_free(std::array<Claim, 2>{{{4, Hal::PinMode::Input, 3}, {4, Hal::PinMode::Input, 4}}}),
+                  "Readers may share a pin.");
+    static_assert(!claims_conflict_free(std::array<Claim, 2>{{{15, Hal::PinMode::Output, 7}, {15, Hal::PinMode::Output, 8}}}),
+                  "Two tasks may not drive a pin.");
+    static_assert(!claims_conflict_free(std::array<Claim, 2>{{{19, Hal::PinMode::Input, 2}, {19, Hal::PinMode::InputPulldown, 3}}}),
+                  "A pin has one input mode.");
+}
+
+#endif
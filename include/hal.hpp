@@ -0,0 +1,59 @@
+#ifndef HARDWARE_ABSTRACTION_LAYER
+#define HARDWARE_ABSTRACTION_LAYER
+
+#include <cstddef>
+
+#include "platform.hpp"
+#include "common.hpp"
+#include "units.hpp"
+
+namespace Hal
+{
+    enum class PinMode : uint8_t
+    {
+        Input,
+        Output,
+        InputPulldown
+    };
+
+    // Called from interrupt context with the time of the edge in microseconds since boot.
+    using EdgeCallback = void (*)(void *context, uint32_t timestamp);
+    // As EdgeCallback, for both edges, with the level the pin changed to.
+    using ChangeCallback = void (*)(void *context, uint32_t timestamp, bool level);
+
+    /**
+     * Every access to pins, timing and the serial port goes through this interface. The ESP32 build
+     * installs an Arduino backed implementation, the native build installs a simulated one.
+     */
+    class Hal
+    {
+    public:
+        virtual ~Hal() = default;
+
+        virtual void pin_mode(const int8_t pin_id, const PinMode mode) = 0;
+        virtual bool digital_read(const int8_t pin_id) = 0;
+        virtual void digital_write(const int8_t pin_id, const bool level) = 0;
+        virtual uint16_t analogue_read(const int8_t pin_id) = 0;
+        // Length of the next pulse at level, or zero if none completes within timeout.
+        virtual Units::Microseconds pulse_in(const int8_t pin_id, const bool level, const Units::Microseconds timeout) = 0;
+        virtual void attach_rising_edge_interrupt(const int8_t pin_id, EdgeCallback callback, void *context) = 0;
+        virtual void attach_change_interrupt(const int8_t pin_id, ChangeCallback callback, void *context) = 0;
+
+        // Microseconds since boot. Wraps after about 71.6 minutes, as Arduino's micros() does, so only
+        // differences are meaningful; Units::Microseconds subtraction is modular.
+        virtual Units::Microseconds micros() = 0;
+        virtual void delay_microseconds(const Units::Microseconds duration) = 0;
+
+        virtual void begin_serial(const uint32_t baud_rate) = 0;
+        virtual void write_serial(const char *data, const size_t length) = 0;
+        // Never blocks: returns the bytes already received, up to length.
+        virtual size_t read_serial(char *data, const size_t length) = 0;
+    };
+
+    Hal &get();
+    void set(Hal &hal);
+
+    void print(const char *message);
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef INSTRUMENTATION
+#define INSTRUMENTATION
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.hpp"
+#include "protected_types.hpp"
+#include "units.hpp"
+
+namespace Instrumentation
+{
+    constexpr size_t MAXIMUM_TASKS = 16;
+    constexpr size_t HISTOGRAM_BUCKETS = 16; // bucket b counts response times in [2^b, 2^(b+1)) microseconds
+
+    // Free-running CPU cycle counter (CCOUNT on the ESP32, the TSC on x86 hosts). 32 bits, so only
+    // intervals shorter than one wrap (about 17 s at 240 MHz) are meaningful.
+    uint32_t cycle_count();
+    uint32_t cycles_per_microsecond();
+
+    // Monotonic microseconds since boot, 64 bits so it never wraps.
+    int64_t time_us();
+
+    struct TaskStatistics
+    {
+        uint32_t activations;
+        uint32_t deadline_misses;
+        uint32_t minimum_execution_cycles;
+        uint32_t maximum_execution_cycles;
+        uint64_t total_execution_cycles;
+        uint32_t maximum_start_jitter_us;
+        uint64_t total_start_jitter_us;
+        std::array<uint16_t, HISTOGRAM_BUCKETS> response_histogram;
+
+        uint32_t mean_execution_cycles() const
+        {
+            return activations ? static_cast<uint32_t>(total_execution_cycles / activations) : 0;
+        }
+    };
+
+    /**
+     * Wraps one task's loop body. begin() and end() read the cycle counter and clock; end() folds the
+     * activation into the task's statistics and publishes them through a seqlock, so query() never
+     * blocks the task. Start jitter and response time are measured from the release the task was
+     * scheduled for, so a late activation does not move the reference for the next; the deadline is
+     * one period after the release.
+     */
+    class TaskProbe
+    {
+    public:
+        TaskProbe(const uint8_t task_number, const Units::Microseconds period);
+
+        // For periodic tasks: release_us is the scheduled release (Periodic::Schedule::release_us()).
+        void begin(const int64_t release_us);
+        // For event-driven tasks: the activation was triggered at event_us; no start jitter is recorded.
+        void begin_event(const int64_t event_us);
+        void end();
+
+    private:
+        void start(const int64_t release_us);
+
+        const uint8_t task_number;
+        const int64_t period_us;
+        TaskStatistics statistics = {};
+        int64_t release_us = 0;
+        int64_t start_us = 0;
+        uint32_t start_cycles = 0;
+    };
+
+    // Latest published statistics for task_number; false if the task has no probe.
+    bool query(const uint8_t task_number, TaskStatistics &statistics);
+
+    // Emits TaskTiming and TaskTimingMean records for every probed task into the binary log.
+    void dump();
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef MEMORY_PROFILER
+#define MEMORY_PROFILER
+
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+/**
+ * Stack and heap high-water marks for the tasks created by TaskRegistry. FreeRTOS keeps the stack
+ * marks itself (the untouched fill pattern left at the end of each stack), so sampling is a short
+ * walk per task and the peak covers the whole run, not just the moments a report was taken.
+ */
+namespace MemoryProfiler
+{
+    constexpr uint32_t SAFETY_MARGIN_PERCENT = 25;
+    constexpr uint32_t STACK_GRANULARITY = 16; // bytes; keeps recommended sizes aligned
+
+    // Peak usage plus the margin, rounded up to the granularity.
+    constexpr uint32_t recommended_stack_bytes(const uint32_t peak_bytes,
+                                               const uint32_t margin_percent = SAFETY_MARGIN_PERCENT)
+    {
+        return ((peak_bytes + (peak_bytes * margin_percent + 99) / 100 + STACK_GRANULARITY - 1) /
+                STACK_GRANULARITY) *
+               STACK_GRANULARITY;
+    }
+
+    static_assert(recommended_stack_bytes(1000) == 1264, "1000 bytes and 25 % is 1250, rounded up.");
+    static_assert(recommended_stack_bytes(0) == 0, "An unused stack needs nothing extra.");
+
+    struct StackUsage
+    {
+        uint8_t task_number;
+        uint32_t allocated_bytes;
+        uint32_t peak_bytes;
+        uint32_t recommended_bytes;
+    };
+
+    struct HeapUsage
+    {
+        size_t free_bytes;
+        size_t minimum_free_bytes; // lowest since boot
+    };
+
+    // Usage of the index-th task TaskRegistry created; see TaskRegistry::number_of_registered_tasks().
+    // A task that has exited reports no peak and no recommendation.
+    StackUsage stack_usage(const size_t index, const uint32_t margin_percent = SAFETY_MARGIN_PERCENT);
+
+    HeapUsage heap_usage();
+
+    /**
+     * Emits one StackUsage record per running registered task and one HeapUsage record into the binary log.
+     * tools/stack_table.py turns the decoded records into a stack-size table for TASK_TABLE.
+     */
+    void report(const uint32_t margin_percent = SAFETY_MARGIN_PERCENT);
+}
+
+#endif
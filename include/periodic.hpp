@@ -0,0 +1,116 @@
+#ifndef PERIODIC
+#define PERIODIC
+
+#include <cstdint>
+
+#include "platform.hpp"
+#include "common.hpp"
+#include "power.hpp"
+
+namespace Periodic
+{
+    /**
+     * Sub-tick waits against the Instrumentation::time_us() clock. On the ESP32 waits longer than a few
+     * hundred microseconds block on an esp_timer one-shot; shorter waits, and all waits on the host,
+     * spin. The timer is created on first use and reused.
+     */
+    class FineTimer
+    {
+    public:
+        FineTimer() = default;
+        FineTimer(const FineTimer &) = delete;
+        FineTimer &operator=(const FineTimer &) = delete;
+        ~FineTimer();
+
+        void wait_until(const int64_t time_us);
+
+    private:
+        void *semaphore = nullptr;
+        void *timer = nullptr;
+    };
+
+    /**
+     * A period held as an exact fraction of microseconds, the closest with a denominator of at most
+     * MAXIMUM_DENOMINATOR: 1000 / 24 ms is held as 125000 / 3 us. Offsets are computed from the release
+     * index rather than by adding periods, so they are never more than half a microsecond from the
+     * exact multiple however many periods have passed. Integer arithmetic only after construction.
+     */
+    class Period
+    {
+    public:
+        static constexpr int64_t MAXIMUM_DENOMINATOR = 1000;
+
+        explicit Period(const Milliseconds period);
+
+        // round(index * period), in microseconds.
+        int64_t offset_us(const uint64_t index) const;
+        // The last index whose offset is at or before offset_us.
+        uint64_t index_at(const int64_t offset_us) const;
+
+        int64_t numerator_us() const { return numerator; }
+        int64_t denominator() const { return divisor; }
+
+    private:
+        int64_t numerator = 0;
+        int64_t divisor = 1;
+    };
+
+    enum class Precision : uint8_t
+    {
+        Tick,    // released on the first RTOS tick at or after the release: one wake-up, up to a tick late
+        SubTick, // a tick-resolution wait, then a FineTimer wait to the microsecond: two wake-ups
+    };
+
+    constexpr int64_t TICK_US = 1000 * portTICK_PERIOD_MS;
+
+    // Ticks from the schedule's origin to the release at offset_us: the first tick at or after it for
+    // Precision::Tick, the last tick before it otherwise.
+    constexpr TickType_t release_ticks(const int64_t offset_us, const Precision precision)
+    {
+        return static_cast<TickType_t>(precision == Precision::Tick ? (offset_us + TICK_US - 1) / TICK_US
+                                                                    : offset_us / TICK_US);
+    }
+
+    /**
+     * Absolute-time release schedule. Release n is origin + Period::offset_us(n), so fractional periods
+     * such as 41.67 ms or 24.4 ms never accumulate rounding error and the schedule cannot drift. Tick
+     * waits are computed from the same offset and the origin tick, so they do not drift either.
+     */
+    class Schedule
+    {
+    public:
+        // A power client, if given, is told each release before sleeping and woken against it.
+        explicit Schedule(const Milliseconds period,
+                          Power::Client *power = nullptr,
+                          const Precision precision = Precision::Tick);
+
+        // Anchors release 0 on the next tick. Called implicitly by the first wait_next_release().
+        void start();
+
+        /**
+         * Sleeps until the next release. If the task has overrun by whole periods, the missed releases
+         * are skipped (and counted) rather than run back to back.
+         */
+        void wait_next_release();
+
+        int64_t release_us() const;
+        uint32_t skipped_releases() const;
+
+    private:
+        int64_t release_time(const uint64_t index) const;
+        void delay_until_tick(const TickType_t tick);
+
+        const Period period;
+        const Precision precision;
+        int64_t origin_us = 0;
+        uint64_t release_index = 0;
+        bool started = false;
+        uint32_t skipped = 0;
+        TickType_t origin_tick = 0;
+        TickType_t last_wake_tick = 0;
+        FineTimer fine_timer;
+        Power::Client *power;
+    };
+}
+
+#endif
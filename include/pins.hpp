@@ -0,0 +1,26 @@
+#ifndef PINS
+#define PINS
+
+#include <cstdint>
+
+#include "gpio_pin.hpp"
+
+namespace Pins
+{
+    using AnalogueInputPin = Gpio::Pin<4, Hal::PinMode::Input>;
+    using WatchdogOutputPin = Gpio::Pin<21, Hal::PinMode::Output>;
+    using DigitalInputPin = Gpio::Pin<19, Hal::PinMode::InputPulldown>;
+    using ErrorCodeLedPin = Gpio::Pin<15, Hal::PinMode::Output>;
+    using PwmInputPin = Gpio::Pin<2, Hal::PinMode::Input>;
+    using AnalogueMonitorDisplayPin = Gpio::Pin<22, Hal::PinMode::Output>;
+
+    // For the drivers and task parameters that take a pin number at run time.
+    constexpr int8_t ANALOGUE_INPUT = AnalogueInputPin::number;
+    constexpr int8_t WATCHDOG_OUTPUT = WatchdogOutputPin::number;
+    constexpr int8_t DIGITAL_INPUT = DigitalInputPin::number;
+    constexpr int8_t ERROR_CODE_LED = ErrorCodeLedPin::number;
+    constexpr int8_t PWM_PIN = PwmInputPin::number;
+    constexpr int8_t ANALOGUE_MONITOR_DISPLAY_PIN = AnalogueMonitorDisplayPin::number;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef PLATFORM
+#define PLATFORM
+
+/**
+ * Single entry point for the RTOS and framework headers, so the same sources build both against the
+ * Arduino-ESP32 framework and against the FreeRTOS POSIX port used by the native environment.
+ */
+#ifdef NATIVE
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+// The host has no instruction RAM; what the ESP32 keeps there for interrupts is ordinary code here.
+#define IRAM_ATTR
+#else
+#include <Arduino.h>
+#endif
+
+#endif
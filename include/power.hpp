@@ -0,0 +1,112 @@
+#ifndef POWER
+#define POWER
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+#include "protected_types.hpp"
+
+namespace Power
+{
+    // What the policy lets the power manager do, from most to least power.
+    enum class Level : uint8_t
+    {
+        FullSpeed,  // a latency-sensitive task is running: CPU at the maximum frequency
+        Scaled,     // frequency scaling between releases, but no light sleep
+        LightSleep, // light sleep allowed until the next release
+    };
+    constexpr size_t NUMBER_OF_LEVELS = 3;
+
+    struct Settings
+    {
+        uint16_t maximum_mhz;
+        uint16_t minimum_mhz;
+        bool light_sleep;
+        uint32_t light_sleep_guard_us; // no light sleep if a latency-sensitive release is closer than this
+    };
+
+    /**
+     * Light sleep stops the I2S ADC DMA, the RMT watchdog waveform and the edge-capture interrupt, and
+     * their drivers hold APB locks that forbid it anyway, so by default only frequency scaling is used.
+     */
+    constexpr Settings DEFAULT_SETTINGS = {240, 80, false, 2000};
+
+    // The policy on its own, free of hardware, so it can be checked at compile time and on the host.
+    constexpr Level level(const Settings &settings,
+                          const uint32_t busy_clients,
+                          const int64_t now_us,
+                          const int64_t next_sensitive_release_us)
+    {
+        if (busy_clients > 0)
+            return Level::FullSpeed;
+        if (!settings.light_sleep || next_sensitive_release_us - now_us < settings.light_sleep_guard_us)
+            return Level::Scaled;
+        return Level::LightSleep;
+    }
+
+    static_assert(level(DEFAULT_SETTINGS, 1, 0, 100000) == Level::FullSpeed, "Busy work runs at full speed.");
+    static_assert(level(DEFAULT_SETTINGS, 0, 0, 100000) == Level::Scaled, "Light sleep is off by default.");
+    static_assert(level({240, 80, true, 2000}, 0, 0, 1999) == Level::Scaled, "Too close to a release to sleep.");
+    static_assert(level({240, 80, true, 2000}, 0, 0, 2000) == Level::LightSleep, "Far enough to sleep.");
+
+    /**
+     * Configures dynamic frequency scaling (and light sleep if enabled) through esp_pm. Tickless idle
+     * is never enabled here: it is an SDK build option (CONFIG_FREERTOS_USE_TICKLESS_IDLE), and light
+     * sleep cannot happen without it. Returns false, leaving the clock fixed, if the SDK was built
+     * without CONFIG_PM_ENABLE, as the stock Arduino-ESP32 core is: esp_pm_configure() then fails with
+     * ESP_ERR_NOT_SUPPORTED. On the host nothing is switched but the policy and its accounting run the
+     * same way.
+     */
+    bool begin(const Settings &settings = DEFAULT_SETTINGS);
+    bool active();
+
+    struct WakeLatency
+    {
+        uint32_t wakes;
+        uint32_t maximum_us;
+        uint64_t total_us;
+    };
+
+    /**
+     * One task's view of the power manager. A latency-sensitive client holds the CPU at full speed
+     * from awake() to sleep_until() and keeps light sleep away from its next release; every client
+     * records how late it woke against the release it asked for.
+     */
+    class Client
+    {
+    public:
+        Client(const uint8_t task_number, const bool latency_sensitive);
+        Client(const Client &) = delete;
+        Client &operator=(const Client &) = delete;
+
+        void awake(const int64_t release_us);
+        void sleep_until(const int64_t release_us);
+
+        // False until the first wake.
+        bool wake_latency(WakeLatency &latency) const;
+
+        bool is_busy() const { return busy.load(std::memory_order_relaxed); }
+        int64_t next_release() const { return next_release_us.load(std::memory_order_relaxed); }
+
+        const uint8_t task_number;
+        const bool latency_sensitive;
+
+    private:
+        std::atomic<bool> busy{false};
+        std::atomic<int64_t> next_release_us{INT64_MAX};
+        WakeLatency latency = {};                         // only touched by the client's task
+        ProtectedTypes::SeqLocked<WakeLatency> published; // for report()
+    };
+
+    /**
+     * Emits a PowerLevels record with the share of time the policy spent at each level, and a
+     * WakeLatency record per client, into the binary log.
+     */
+    void report();
+}
+
+#endif
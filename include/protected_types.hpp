@@ -1,90 +1,85 @@
 #ifndef PROTECTED_TYPES
 #define PROTECTED_TYPES
 
-#include "Arduino.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "platform.hpp"
 
 #include "common.hpp"
 
 namespace ProtectedTypes
 {
-
-    class DataToLog
+    /**
+     * Sequence-locked value for a single writer and any number of readers. The writer never blocks:
+     * it makes the sequence odd, stores the value and makes it even again. Readers copy the value and
+     * use the sequence to detect whether a write overlapped the copy. The value is held in 32-bit
+     * atomic words so the copy is race free on targets without 64-bit atomics.
+     */
+    template <typename T>
+    class SeqLocked
     {
+        static_assert(std::is_trivially_copyable<T>::value, "SeqLocked values must be trivially copyable.");
+
     public:
-        DataToLog(const bool digital_input_state,
-                  const Hertz square_wave_frequency,
-                  const double filtered_analogue_signal) : digital_input_state(digital_input_state),
-                                                           square_wave_frequency(square_wave_frequency),
-                                                           filtered_analogue_signal(filtered_analogue_signal) {}
-        DataToLog() : digital_input_state(false),
-                      square_wave_frequency(0.0),
-                      filtered_analogue_signal(0.0) {}
+        SeqLocked()
+        {
+            store(T{});
+        }
 
-        bool set_digital_input_state(const bool digital_in_state, const TickType_t semaphore_ticks_to_wait)
+        explicit SeqLocked(const T &initial)
         {
-            if (xSemaphoreTake(semaphore, semaphore_ticks_to_wait))
-            {
-                digital_input_state = digital_in_state;
-                xSemaphoreGive(semaphore);
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            store(initial);
         }
 
-        bool set_square_wave_frequency(const Hertz square_wave_freq, const TickType_t semaphore_ticks_to_wait)
+        // Always inlined, so an IRAM interrupt handler that writes does not call into flash.
+        __attribute__((always_inline)) void write(const T &value)
         {
-            if (xSemaphoreTake(semaphore, semaphore_ticks_to_wait))
-            {
-                square_wave_frequency = square_wave_freq;
-                xSemaphoreGive(semaphore);
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            const auto seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            store(value);
+            sequence.store(seq + 2, std::memory_order_release);
         }
 
-        bool set_filtered_analogue_signal(const double filtered_analogue_sig, const TickType_t semaphore_ticks_to_wait)
+        // Sequence value to pass to validate(); odd while a write is in progress.
+        uint32_t begin_read() const
         {
-            if (xSemaphoreTake(semaphore, semaphore_ticks_to_wait))
-            {
-                filtered_analogue_signal = filtered_analogue_sig;
-                xSemaphoreGive(semaphore);
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            return sequence.load(std::memory_order_acquire);
         }
 
-        [[no_discard]] bool get_data(bool &digital_in_state,
-                                     Hertz &square_wave_freq,
-                                     double &filtered_analogue_sig,
-                                     const TickType_t semaphore_ticks_to_wait) const
+        T read_unchecked() const
         {
-            if (xSemaphoreTake(semaphore, semaphore_ticks_to_wait))
-            {
-                digital_in_state = digital_input_state;
-                square_wave_freq = square_wave_frequency;
-                filtered_analogue_sig = filtered_analogue_signal;
-                xSemaphoreGive(semaphore);
-                return true;
-            }
-            return false;
+            std::array<uint32_t, NUMBER_OF_WORDS> copy;
+            for (size_t i = 0; i < NUMBER_OF_WORDS; i++)
+                copy[i] = words[i].load(std::memory_order_relaxed);
+            T value;
+            memcpy(static_cast<void *>(&value), copy.data(), sizeof(T));
+            return value;
+        }
+
+        bool validate(const uint32_t seq) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return ((seq & 1) == 0) && (sequence.load(std::memory_order_relaxed) == seq);
         }
 
     private:
-        bool digital_input_state;
-        Hertz square_wave_frequency;
-        double filtered_analogue_signal;
+        static constexpr size_t NUMBER_OF_WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+        __attribute__((always_inline)) void store(const T &value)
+        {
+            std::array<uint32_t, NUMBER_OF_WORDS> copy = {};
+            memcpy(copy.data(), &value, sizeof(T));
+            for (size_t i = 0; i < NUMBER_OF_WORDS; i++)
+                words[i].store(copy[i], std::memory_order_relaxed);
+        }
 
-        xSemaphoreHandle semaphore = xSemaphoreCreateMutex();
+        std::atomic<uint32_t> sequence{0};
+        std::array<std::atomic<uint32_t>, NUMBER_OF_WORDS> words;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,188 @@
+#ifndef RECORDER
+#define RECORDER
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "binary_log.hpp"
+#include "flash.hpp"
+
+/**
+ * Persistent copy of the binary log. Records are appended to a circular region of flash, one sector
+ * after another, so every sector is erased once per pass and wear is levelled by construction. Each
+ * sector starts with a header holding its sequence number, erase count and the recorder time of its
+ * first record; the rest holds records exactly as BinaryLog sends them.
+ *
+ * Recorder time is microseconds since the region was first used. It carries on from the newest
+ * record after a reset, so it orders records across boots but does not count time powered off.
+ */
+namespace Recorder
+{
+    constexpr size_t MAXIMUM_SECTORS = 256;
+    constexpr size_t SLOT_SIZE = sizeof(BinaryLog::Record);
+    constexpr size_t SLOTS_PER_SECTOR = Flash::SECTOR_SIZE / SLOT_SIZE;
+    constexpr size_t SLOTS_PER_PAGE = Flash::PAGE_SIZE / SLOT_SIZE;
+
+    struct SectorHeader
+    {
+        uint32_t magic;
+        uint32_t sequence;         // increases by one per sector written, across passes and boots
+        uint32_t erase_count;
+        uint32_t first_timestamp;  // BinaryLog timestamp of the first record
+        int64_t first_time_us;     // its recorder time
+        uint32_t reserved[2];      // left erased
+    };
+    constexpr size_t HEADER_SLOTS = sizeof(SectorHeader) / SLOT_SIZE;
+    static_assert(sizeof(SectorHeader) % SLOT_SIZE == 0, "The header fills whole record slots.");
+
+    // Record timestamps are 32-bit microseconds, so a sector is closed before they can wrap.
+    constexpr int64_t MAXIMUM_SECTOR_SPAN_US = INT64_C(1800000000);
+
+    constexpr uint32_t record_type_bit(const BinaryLog::RecordType type)
+    {
+        return UINT32_C(1) << static_cast<uint8_t>(type);
+    }
+
+    struct Settings
+    {
+        int64_t flush_interval_us;         // longest a record waits in RAM for its page to fill
+        uint32_t excluded_types;           // record_type_bit()s not worth the flash
+        int64_t minimum_erase_interval_us; // records arriving sooner after an erase than this are shed
+    };
+
+    /**
+     * Raw ADC readings arrive at hundreds of records a second and are left out; the window statistics
+     * and Task 9's snapshots summarise them. The filtered value is kept.
+     *
+     * A sector erase disables the flash cache on both cores for tens of milliseconds, longer than Task
+     * 4's 41.7 ms period, and the ESP32, unlike later chips, cannot suspend an erase to serve a cache
+     * miss. Only IRAM interrupts run meanwhile. Erases are therefore at least 30 s apart, and what
+     * would need one sooner is shed and counted as lost; RecorderStall records report the cost, and a
+     * RecordsShed record in flash marks each gap.
+     */
+    constexpr Settings DEFAULT_SETTINGS = {1000000, record_type_bit(BinaryLog::RecordType::AnalogueReadings), 30000000};
+
+    struct Metrics
+    {
+        uint32_t records_stored;
+        uint32_t records_lost;        // flash errors, no region to record into, or shed
+        uint32_t records_shed;        // of those, shed to keep erases minimum_erase_interval_us apart
+        uint32_t programs;
+        uint32_t sectors;
+        uint32_t highest_erase_count;
+        uint32_t erases;              // this boot
+        uint32_t longest_erase_us;    // the cores were stalled for this long
+        uint64_t total_erase_us;
+    };
+
+    /**
+     * Owned by the log drain task, which appends through sink() and serves exports, so nothing here
+     * is locked. Records are batched into whole pages before they are programmed, or programmed as a
+     * partial page once the oldest has waited flush_interval_us, and every boot starts a new sector.
+     */
+    class Recorder
+    {
+    public:
+        explicit Recorder(Flash::Flash *flash, const Settings &settings = DEFAULT_SETTINGS);
+
+        // Finds the newest sector and rebuilds the index. False if there is no usable region.
+        bool mount();
+
+        void append(const BinaryLog::Record &record);
+        // For BinaryLog::drain().
+        static void sink(void *context, const BinaryLog::Record &record);
+
+        void flush();
+        void flush_if_due();
+
+        /**
+         * Exports run up to maximum_records per export_step(), resuming where the last step stopped, so
+         * the caller can keep draining the live log in between. Records with recorder times in
+         * [from_us, to_us] are sent oldest first as export packets, the sectors that hold them found by
+         * binary search over the index. An export packet with no records marks the end.
+         */
+        void begin_export(const int64_t from_us, const int64_t to_us);
+        bool exporting() const
+        {
+            return export_state.active;
+        }
+        void export_step(const BinaryLog::Framing framing, const size_t maximum_records);
+
+        Metrics metrics() const;
+
+    private:
+        static constexpr size_t NO_SECTOR = SIZE_MAX;
+        static constexpr int64_t UNUSED = INT64_MIN;
+
+        struct Export
+        {
+            bool active;
+            size_t oldest;  // physical sector at logical position 0 when the export began
+            size_t next;    // logical position of the sector after the one being read
+            size_t sector;  // physical sector being read, or NO_SECTOR between sectors
+            size_t slot;    // next slot to read in it
+            SectorHeader header;
+            uint32_t last_sequence;
+            int64_t from_us;
+            int64_t to_us;
+            uint16_t packet_sequence;
+        };
+
+        int64_t recorder_time(const uint32_t timestamp);
+        bool start_sector(const uint32_t timestamp, const int64_t time);
+        void store(const BinaryLog::Record &record, const int64_t time);
+        size_t physical(const size_t oldest, const size_t logical) const;
+        size_t sectors_before(const size_t oldest, const int64_t time, const bool inclusive) const;
+        size_t first_sector_at(const size_t oldest, const int64_t time) const;
+        bool next_export_sector();
+        void send_export_packet(uint8_t *packet, const size_t records, const BinaryLog::Framing framing);
+
+        Flash::Flash *const flash;
+        const Settings settings;
+        bool mounted = false;
+        size_t sectors = 0;
+        std::array<int64_t, MAXIMUM_SECTORS> first_times;
+
+        size_t newest = NO_SECTOR;
+        size_t current = NO_SECTOR; // the sector being written this boot
+        SectorHeader header = {};
+        uint32_t next_sequence = 0;
+        int64_t last_erase_time = UNUSED; // recorder time of the last erase this boot
+        uint32_t unreported_shed = 0;     // shed since the last record stored
+        int64_t first_shed_time = 0;
+        int64_t time_offset_us = 0;
+        bool timestamps_seen = false;
+        uint32_t last_timestamp = 0;
+        int64_t since_boot_us = 0; // last_timestamp, extended past its 32-bit wrap
+
+        size_t next_slot = 0;
+        size_t programmed_slot = 0;
+        std::array<BinaryLog::Record, SLOTS_PER_PAGE> pending;
+        int64_t pending_since_us = 0;
+
+        Export export_state = {};
+        Metrics counters = {};
+    };
+
+    /**
+     * Host commands, read from the serial port by the log drain task:
+     *   'X'                            export everything
+     *   'R' <i64 from_us> <i64 to_us>  export a range of recorder time, little-endian
+     */
+    class CommandParser
+    {
+    public:
+        // True once a whole command has arrived; its range is then in from_us and to_us.
+        bool feed(const uint8_t byte);
+
+        int64_t from_us = 0;
+        int64_t to_us = 0;
+
+    private:
+        std::array<uint8_t, 17> buffer;
+        size_t length = 0;
+    };
+}
+
+#endif
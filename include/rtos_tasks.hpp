@@ -1,12 +1,60 @@
 #ifndef RTOS_TASKS
 #define RTOS_TASKS
 
-#include <Arduino.h>
+#include "platform.hpp"
+
+#include <array>
 
 #include "common.hpp"
+#include "error_rules.hpp"
+#include "filters.hpp"
 #include "protected_types.hpp"
+#include "statistics.hpp"
+#include "units.hpp"
 namespace RtosTasks
 {
+    // Task 4 captures ADC_BLOCK_SIZE samples per release and oversamples them down to analogue readings.
+    // On ADC2 pins, the analogue input among them, the block is a burst of back-to-back conversions.
+    constexpr size_t ADC_BLOCK_SIZE = 64;
+    constexpr size_t ADC_OVERSAMPLING = 16;
+    constexpr size_t READINGS_PER_BLOCK = ADC_BLOCK_SIZE / ADC_OVERSAMPLING;
+    static_assert(ADC_BLOCK_SIZE % ADC_OVERSAMPLING == 0, "Each block must produce a whole number of readings.");
+
+    /**
+     * One Task 4 block of readings. Task 4 fills it in place, Task 5 adds the filtered value and passes
+     * the same block on to Task 7, so the readings are never copied between the stages.
+     */
+    struct SampleBlock
+    {
+        std::array<uint16_t, READINGS_PER_BLOCK> readings;
+        Units::AdcCounts filtered;
+        int64_t captured_us; // when Task 4 received the ADC block, on the Instrumentation::time_us() clock
+    };
+    // One being filled, one per channel, one held by each consumer, plus one stale block in flight.
+    constexpr size_t SAMPLE_BLOCKS = 8;
+
+    // Task 5 filter; any Filters type with push()/output() can be substituted here.
+    constexpr size_t NUMBER_OF_ANALOGUE_READINGS = 4;
+    using AnalogueFilter = Filters::MovingAverage<NUMBER_OF_ANALOGUE_READINGS>;
+
+    // Task 5 also keeps statistics over the last ANALOGUE_STATISTICS_WINDOW readings.
+    constexpr size_t ANALOGUE_STATISTICS_WINDOW = 256;
+    using AnalogueStatistics = Statistics::RollingStatistics<ANALOGUE_STATISTICS_WINDOW>;
+
+    // Task 7 error codes, highest priority first. Persistence counts Task 7 periods.
+    constexpr std::array<ErrorRules::Rule, 4> ERROR_CODE_RULES = {{
+        // {code, metric, raise above, clear below, persistence}
+        {4, ErrorRules::Metric::Level, Units::AdcCounts::from_counts(3900), Units::AdcCounts::from_counts(3700), 3}, // near full scale
+        {3, ErrorRules::Metric::Noise, Units::AdcCounts::from_counts(200),  Units::AdcCounts::from_counts(150),  5},
+        {2, ErrorRules::Metric::Drift, Units::AdcCounts::from_counts(400),  Units::AdcCounts::from_counts(250),  3},
+        {1, ErrorRules::Metric::Level, Units::AdcCounts::from_counts(2147), Units::AdcCounts::from_counts(1947), 3}, // above half scale
+    }};
+    using ErrorEvaluator = ErrorRules::Evaluator<ERROR_CODE_RULES.size(), ERROR_CODE_RULES>;
+
+    // Exported records the log drain task sends per release. At 115200 baud a 50 ms period carries
+    // about 570 bytes; 16 records take half of that and leave the rest to the live log.
+    constexpr size_t EXPORT_RECORDS_PER_PERIOD = 16;
+
     void transmit_watchdog_waveform(void *params);       // Task 1
     void digital_read(void *params);                     // Task 2
     void measure_square_wave_frequency(void *params);    // Task 3
@@ -16,5 +64,6 @@ namespace RtosTasks
     void compute_error_code(void *params);               // Task 7
     void visualise_error_code(void *params);             // Task 8
     void log(void *params);                              // Task 9
+    void drain_log(void *params);                        // Log drain
 }
 #endif
\ No newline at end of file
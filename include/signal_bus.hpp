@@ -0,0 +1,257 @@
+#ifndef SIGNAL_BUS
+#define SIGNAL_BUS
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+
+#include "protected_types.hpp"
+
+namespace SignalBus
+{
+    enum class Producers : uint8_t
+    {
+        Single,   // publish() is lock-free and wait-free
+        Multiple, // publishers are serialised by a statically allocated mutex
+    };
+
+    // Copies a seqlocked value, yielding if a preempted writer keeps overlapping the copy.
+    template <typename T>
+    bool read_consistent(const ProtectedTypes::SeqLocked<T> &source, T &value, uint32_t *sequence = nullptr)
+    {
+        constexpr size_t ATTEMPTS_BEFORE_YIELDING = 4;
+        for (size_t attempt = 1;; attempt++)
+        {
+            const auto seq = source.begin_read();
+            if (seq == 0)
+                return false;
+            const auto copy = source.read_unchecked();
+            if (source.validate(seq))
+            {
+                value = copy;
+                if (sequence != nullptr)
+                    *sequence = seq;
+                return true;
+            }
+            if (attempt % ATTEMPTS_BEFORE_YIELDING == 0)
+                vTaskDelay(1);
+        }
+    }
+
+    template <typename T, Producers PRODUCERS, size_t MAXIMUM_SUBSCRIBERS>
+    class Topic;
+
+    /**
+     * Receives every value published to the one topic it is subscribed to, in the publisher's context.
+     * The value current when it subscribes is delivered at once, in the subscribing task. If a task is
+     * given, it is woken with the notification bit whenever the subscriber has something new for it.
+     */
+    template <typename T>
+    class Subscriber
+    {
+    public:
+        Subscriber(const TaskHandle_t task = nullptr, const uint32_t bit = 0) : task(task), bit(bit) {}
+        Subscriber(const Subscriber &) = delete;
+        Subscriber &operator=(const Subscriber &) = delete;
+
+        virtual void deliver(const T &value) = 0;
+
+    protected:
+        ~Subscriber() = default;
+
+        void wake()
+        {
+            if (task != nullptr)
+                xTaskNotify(task, bit, eSetBits);
+        }
+
+    private:
+        template <typename, Producers, size_t>
+        friend class Topic;
+
+        /**
+         * Delivers the topic's latest value unless it was delivered already. A caller that finds a
+         * delivery under way leaves its request to that caller, which repeats until none is left, so
+         * deliver() never runs twice at once and neither caller waits for the other. Only subscribe()
+         * ever overlaps a publisher, so only values published during that hand-over are coalesced.
+         */
+        void catch_up(const ProtectedTypes::SeqLocked<T> &latest)
+        {
+            if (requests.fetch_add(1, std::memory_order_acq_rel) != 0)
+                return;
+            uint32_t pending = 1;
+            do
+            {
+                T value;
+                uint32_t sequence;
+                if (read_consistent(latest, value, &sequence) && sequence != delivered)
+                {
+                    delivered = sequence;
+                    deliver(value);
+                }
+                pending = requests.fetch_sub(pending, std::memory_order_acq_rel) - pending;
+            } while (pending != 0);
+        }
+
+        const TaskHandle_t task;
+        const uint32_t bit;
+        std::atomic<uint32_t> requests{0};
+        uint32_t delivered = 0; // sequence of the last value delivered; only touched by catch_up()
+    };
+
+    /**
+     * Named, typed value that any task can publish to. The latest value can always be read without
+     * subscribing; subscribers attach at run time, so publishers and consumers can be created in any
+     * order and never refer to each other.
+     */
+    template <typename T, Producers PRODUCERS = Producers::Single, size_t MAXIMUM_SUBSCRIBERS = 4>
+    class Topic
+    {
+    public:
+        explicit Topic(const char *name) : name(name)
+        {
+            for (auto &slot : subscribers)
+                slot.store(nullptr, std::memory_order_relaxed);
+            if (PRODUCERS == Producers::Multiple)
+                mutex = xSemaphoreCreateMutexStatic(&mutex_buffer);
+        }
+
+        Topic(const Topic &) = delete;
+        Topic &operator=(const Topic &) = delete;
+
+        void publish(const T &value)
+        {
+            if (PRODUCERS == Producers::Multiple)
+                xSemaphoreTake(mutex, portMAX_DELAY);
+
+            latest.write(value);
+            for (auto &slot : subscribers)
+                if (const auto subscriber = slot.load(std::memory_order_acquire))
+                    subscriber->catch_up(latest);
+
+            if (PRODUCERS == Producers::Multiple)
+                xSemaphoreGive(mutex);
+        }
+
+        /**
+         * False if there is no free subscriber slot. Once a value has been published, the subscriber
+         * gets the latest one before this returns, so subscribing late misses nothing.
+         */
+        bool subscribe(Subscriber<T> &subscriber)
+        {
+            for (auto &slot : subscribers)
+            {
+                Subscriber<T> *expected = nullptr;
+                if (slot.compare_exchange_strong(expected, &subscriber, std::memory_order_acq_rel))
+                {
+                    subscriber.catch_up(latest);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Latest-value semantics. False until the first publication. The sequence increases with every
+         * publication, so a reader can tell whether the value is new since it last looked.
+         */
+        bool read(T &value, uint32_t *sequence = nullptr) const
+        {
+            return read_consistent(latest, value, sequence);
+        }
+
+        const char *const name;
+
+    private:
+        ProtectedTypes::SeqLocked<T> latest;
+        std::array<std::atomic<Subscriber<T> *>, MAXIMUM_SUBSCRIBERS> subscribers;
+        StaticSemaphore_t mutex_buffer;
+        SemaphoreHandle_t mutex = nullptr;
+    };
+
+    /**
+     * Bounded-FIFO semantics: every published value is queued in order. Deliveries never overlap, so
+     * the ring has one producer and the subscribing task as its only consumer, and needs no lock.
+     * When full the new value is dropped and counted.
+     */
+    template <typename T, size_t DEPTH>
+    class Fifo : public Subscriber<T>
+    {
+        static_assert(DEPTH >= 2 && (DEPTH & (DEPTH - 1)) == 0, "Depth must be a power of two.");
+
+    public:
+        using Subscriber<T>::Subscriber;
+
+        void deliver(const T &value) override
+        {
+            const auto head = written.load(std::memory_order_relaxed);
+            if (head - consumed.load(std::memory_order_acquire) == DEPTH)
+            {
+                overflows.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            values[head & (DEPTH - 1)] = value;
+            written.store(head + 1, std::memory_order_release);
+            this->wake();
+        }
+
+        bool pop(T &value)
+        {
+            const auto tail = consumed.load(std::memory_order_relaxed);
+            if (tail == written.load(std::memory_order_acquire))
+                return false;
+            value = values[tail & (DEPTH - 1)];
+            consumed.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        uint32_t dropped() const
+        {
+            return overflows.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<T, DEPTH> values = {};
+        std::atomic<uint32_t> written{0};
+        std::atomic<uint32_t> consumed{0};
+        std::atomic<uint32_t> overflows{0};
+    };
+
+    /**
+     * Notify-on-change semantics: only values that differ from the previous one are passed on, and the
+     * task is woken only then. take() returns the latest changed value once.
+     */
+    template <typename T>
+    class OnChange : public Subscriber<T>
+    {
+    public:
+        using Subscriber<T>::Subscriber;
+
+        void deliver(const T &value) override
+        {
+            if (has_previous && value == previous)
+                return;
+            previous = value;
+            has_previous = true;
+            changed.write(value);
+            pending.store(true, std::memory_order_release);
+            this->wake();
+        }
+
+        bool take(T &value)
+        {
+            return pending.exchange(false, std::memory_order_acquire) && read_consistent(changed, value);
+        }
+
+    private:
+        T previous = {}; // only touched by deliver(), which never overlaps itself
+        bool has_previous = false;
+        ProtectedTypes::SeqLocked<T> changed;
+        std::atomic<bool> pending{false};
+    };
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef SIGNALS
+#define SIGNALS
+
+#include "platform.hpp"
+
+#include "common.hpp"
+#include "background.hpp"
+#include "benchmark.hpp"
+#include "recorder.hpp"
+#include "signal_bus.hpp"
+#include "statistics.hpp"
+#include "units.hpp"
+
+/**
+ * Topics shared between tasks. Each has a single publishing task, so publishing is lock-free.
+ */
+namespace Signals
+{
+    extern SignalBus::Topic<bool> digital_input;          // Task 2, debounced state
+    extern SignalBus::Topic<Units::MilliHertz> square_wave_frequency; // Task 3
+    extern SignalBus::Topic<Units::AdcCounts> filtered_analogue;      // Task 5
+    extern SignalBus::Topic<Statistics::Snapshot> analogue_statistics; // Task 5
+    extern SignalBus::Topic<uint8_t> error_code;          // Task 7
+    extern SignalBus::Topic<Benchmark::SampleLatency> sample_latency; // Task 7
+    extern SignalBus::Topic<Background::Metrics> background_work; // Task 6
+    extern SignalBus::Topic<Recorder::Metrics> telemetry_recorder; // Log drain
+}
+
+#endif
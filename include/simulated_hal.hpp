@@ -0,0 +1,111 @@
+#ifndef SIMULATED_HAL
+#define SIMULATED_HAL
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "hal.hpp"
+
+namespace Hal
+{
+    /**
+     * Host-side stand-in for the ESP32 pins. Inputs are driven by signal sources (functions of time
+     * since start-up) and outputs are latched so they can be inspected. Time is taken from the host's
+     * monotonic clock so blocking calls such as pulse_in() cost real CPU time, as they do on target.
+     * Sources and recorded edges see that time in microseconds as a double, which never wraps;
+     * micros() reduces the same clock to the target's wrapping 32-bit count.
+     */
+    class SimulatedHal : public Hal
+    {
+    public:
+        static constexpr size_t NUMBER_OF_PINS = 40;
+        static constexpr uint16_t MAXIMUM_ANALOGUE_VALUE = 4095;
+        static constexpr uint32_t INTERRUPT_POLL_INTERVAL = 10; // microseconds
+
+        static constexpr size_t MAXIMUM_RECORDED_EDGES = 4096;
+
+        struct Edge
+        {
+            int8_t pin_id;
+            bool level;
+            Microseconds time; // host time since start-up
+        };
+
+        using DigitalSource = std::function<bool(Microseconds)>;
+        using AnalogueSource = std::function<uint16_t(Microseconds)>;
+
+        SimulatedHal();
+        ~SimulatedHal() override;
+
+        void set_digital_source(const int8_t pin_id, DigitalSource source);
+        void set_analogue_source(const int8_t pin_id, AnalogueSource source);
+        void set_square_wave(const int8_t pin_id, const Hertz frequency);
+
+        bool output_level(const int8_t pin_id) const;
+        uint32_t write_count(const int8_t pin_id) const;
+        // Output transitions in time order, oldest first; only the last MAXIMUM_RECORDED_EDGES are kept.
+        std::deque<Edge> recorded_edges() const;
+        void clear_recorded_edges();
+        void set_serial_output(FILE *stream);
+        // Queues bytes for read_serial(), as if the host had sent them.
+        void inject_serial_input(const char *data, const size_t length);
+
+        void pin_mode(const int8_t pin_id, const PinMode mode) override;
+        bool digital_read(const int8_t pin_id) override;
+        void digital_write(const int8_t pin_id, const bool level) override;
+        uint16_t analogue_read(const int8_t pin_id) override;
+        Units::Microseconds pulse_in(const int8_t pin_id, const bool level, const Units::Microseconds timeout) override;
+        void attach_rising_edge_interrupt(const int8_t pin_id, EdgeCallback callback, void *context) override;
+        void attach_change_interrupt(const int8_t pin_id, ChangeCallback callback, void *context) override;
+
+        Units::Microseconds micros() override;
+        void delay_microseconds(const Units::Microseconds duration) override;
+
+        void begin_serial(const uint32_t baud_rate) override;
+        void write_serial(const char *data, const size_t length) override;
+        size_t read_serial(char *data, const size_t length) override;
+
+    private:
+        struct Pin
+        {
+            PinMode mode = PinMode::Input;
+            bool level = false;
+            uint32_t writes = 0;
+            DigitalSource digital_source;
+            AnalogueSource analogue_source;
+            EdgeCallback edge_callback = nullptr;
+            void *edge_context = nullptr;
+            ChangeCallback change_callback = nullptr;
+            void *change_context = nullptr;
+            bool last_sampled_level = false;
+        };
+
+        static bool valid(const int8_t pin_id);
+        static Microseconds host_time();
+        void sample_interrupt_pins();
+        void start_interrupt_thread();
+
+        std::array<Pin, NUMBER_OF_PINS> pins;
+        FILE *serial_output;
+
+        mutable std::mutex output_mutex; // outputs are also driven from the simulated peripherals' threads
+        std::deque<Edge> edges;
+
+        std::mutex serial_input_mutex;
+        std::deque<char> serial_input;
+
+        // Stands in for the GPIO interrupt controller: polls pins with attached handlers for edges.
+        std::mutex interrupt_mutex;
+        std::thread interrupt_thread;
+        std::atomic<bool> interrupts_running{false};
+    };
+
+    SimulatedHal &simulated();
+}
+
+#endif
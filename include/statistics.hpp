@@ -0,0 +1,211 @@
+#ifndef STATISTICS
+#define STATISTICS
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "units.hpp"
+
+namespace Statistics
+{
+    // Floor of the square root, bit by bit, so it needs neither floating point nor a divide.
+    constexpr uint32_t integer_square_root(uint64_t value)
+    {
+        uint64_t root = 0;
+        uint64_t bit = uint64_t(1) << 62;
+        while (bit > value)
+            bit >>= 2;
+        while (bit != 0)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return static_cast<uint32_t>(root);
+    }
+
+    static_assert(integer_square_root(0) == 0 && integer_square_root(15) == 3 && integer_square_root(16) == 4,
+                  "Square roots round down.");
+
+    // Summary of a window, in the same Q23.8 counts as the filter output.
+    struct Snapshot
+    {
+        uint16_t samples;
+        Units::AdcCounts minimum;
+        Units::AdcCounts maximum;
+        Units::AdcCounts mean;
+        Units::AdcCounts standard_deviation;
+        Units::AdcCounts median;
+        Units::AdcCounts percentile_95;
+    };
+
+    /**
+     * Statistics of the last WINDOW samples, updated in O(1) per sample with fixed storage:
+     *  - minimum and maximum from monotonic deques of sample positions (amortised O(1));
+     *  - mean and variance from exact integer sums, so unlike floating-point running sums they cannot
+     *    lose precision to cancellation (the problem Welford's update solves) and never drift;
+     *  - percentiles from a histogram of BINS equal bins over [0, MAXIMUM_SAMPLE], interpolated within
+     *    a bin, so they are approximate to the bin width.
+     * No raw samples are kept beyond the window itself, which eviction needs.
+     */
+    template <size_t WINDOW, size_t BINS = 64, uint16_t MAXIMUM_SAMPLE = 4095>
+    class RollingStatistics
+    {
+        static_assert(WINDOW >= 2 && WINDOW <= 32768 && (WINDOW & (WINDOW - 1)) == 0,
+                      "Positions are 16 bits, so the window must be a power of two no larger than 2^15.");
+        static_assert((MAXIMUM_SAMPLE + 1u) % BINS == 0, "Bins must divide the sample range evenly.");
+        static_assert(static_cast<uint64_t>(WINDOW) * MAXIMUM_SAMPLE < (uint64_t(1) << 24),
+                      "The scaled variance must fit in 64 bits.");
+
+    public:
+        void push(const uint16_t sample)
+        {
+            const auto value = (sample > MAXIMUM_SAMPLE) ? MAXIMUM_SAMPLE : sample;
+            if (count == WINDOW)
+            {
+                const auto evicted = history[slot(next)];
+                sum -= evicted;
+                sum_of_squares -= static_cast<uint64_t>(evicted) * evicted;
+                histogram[bin(evicted)]--;
+                // Positions that have left the window sit at the front of a deque, if anywhere.
+                const uint16_t oldest = next - WINDOW;
+                minima.drop_front_if(oldest);
+                maxima.drop_front_if(oldest);
+            }
+            else
+            {
+                count++;
+            }
+
+            history[slot(next)] = value;
+            sum += value;
+            sum_of_squares += static_cast<uint64_t>(value) * value;
+            histogram[bin(value)]++;
+            minima.push_back(next, history, [](const uint16_t kept, const uint16_t added) { return kept < added; });
+            maxima.push_back(next, history, [](const uint16_t kept, const uint16_t added) { return kept > added; });
+            next++;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        Units::AdcCounts minimum() const
+        {
+            return Units::AdcCounts::from_counts(count ? history[slot(minima.front())] : 0);
+        }
+
+        Units::AdcCounts maximum() const
+        {
+            return Units::AdcCounts::from_counts(count ? history[slot(maxima.front())] : 0);
+        }
+
+        Units::AdcCounts mean() const
+        {
+            return count ? Units::AdcCounts::from_raw(static_cast<int32_t>((sum << FRACTIONAL_BITS) / count))
+                         : Units::AdcCounts::from_raw(0);
+        }
+
+        // Population variance of the window, then its root, both in integers.
+        Units::AdcCounts standard_deviation() const
+        {
+            if (count < 2)
+                return Units::AdcCounts::from_raw(0);
+            const uint64_t n = count;
+            const uint64_t spread = n * sum_of_squares - sum * sum; // n^2 times the variance
+            return Units::AdcCounts::from_raw(static_cast<int32_t>(
+                integer_square_root((spread << (2 * FRACTIONAL_BITS)) / (n * n))));
+        }
+
+        // The value below which percent of the window lies.
+        Units::AdcCounts percentile(const uint8_t percent) const
+        {
+            if (count == 0)
+                return Units::AdcCounts::from_raw(0);
+            const uint32_t rank = (static_cast<uint32_t>(count) * percent + 99) / 100;
+            uint32_t below = 0;
+            for (size_t b = 0; b < BINS; b++)
+            {
+                const uint32_t in_bin = histogram[b];
+                if (below + in_bin >= rank && in_bin != 0)
+                {
+                    const int32_t lower = static_cast<int32_t>(b * BIN_WIDTH) << FRACTIONAL_BITS;
+                    const int32_t offset = static_cast<int32_t>(((BIN_WIDTH << FRACTIONAL_BITS) * (rank - below)) / in_bin);
+                    return Units::AdcCounts::from_raw(lower + offset);
+                }
+                below += in_bin;
+            }
+            return maximum();
+        }
+
+        Snapshot snapshot() const
+        {
+            return {static_cast<uint16_t>(count),
+                    minimum(),
+                    maximum(),
+                    mean(),
+                    standard_deviation(),
+                    percentile(50),
+                    percentile(95)};
+        }
+
+    private:
+        static constexpr int FRACTIONAL_BITS = Units::AdcCounts::FRACTIONAL_BITS;
+        static constexpr uint32_t BIN_WIDTH = (MAXIMUM_SAMPLE + 1u) / BINS;
+
+        static constexpr size_t slot(const uint16_t position) { return position & (WINDOW - 1); }
+        static constexpr size_t bin(const uint16_t value) { return value / BIN_WIDTH; }
+
+        // Positions whose samples are ordered by the comparison, front first; a ring of WINDOW entries.
+        class MonotonicDeque
+        {
+        public:
+            uint16_t front() const
+            {
+                return positions[head & (WINDOW - 1)];
+            }
+
+            void drop_front_if(const uint16_t position)
+            {
+                if (head != tail && positions[head & (WINDOW - 1)] == position)
+                    head++;
+            }
+
+            // Drops every position the new sample supersedes, then appends it.
+            template <typename Keeps>
+            void push_back(const uint16_t position, const std::array<uint16_t, WINDOW> &samples, Keeps keeps)
+            {
+                const auto value = samples[slot(position)];
+                while (head != tail && !keeps(samples[slot(positions[(tail - 1) & (WINDOW - 1)])], value))
+                    tail--;
+                positions[tail & (WINDOW - 1)] = position;
+                tail++;
+            }
+
+        private:
+            std::array<uint16_t, WINDOW> positions = {};
+            size_t head = 0;
+            size_t tail = 0;
+        };
+
+        std::array<uint16_t, WINDOW> history = {};
+        std::array<uint16_t, BINS> histogram = {};
+        MonotonicDeque minima;
+        MonotonicDeque maxima;
+        uint64_t sum = 0;
+        uint64_t sum_of_squares = 0;
+        size_t count = 0;
+        uint16_t next = 0; // position of the next sample; wraps, which WINDOW divides
+    };
+}
+
+#endif
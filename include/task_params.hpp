@@ -1,10 +1,12 @@
 #ifndef TASK_PARAMS
 #define TASK_PARAMS
 
-#include <Arduino.h>
-#include <set>
+#include "platform.hpp"
+#include <array>
 
+#include "binary_log.hpp"
 #include "common.hpp"
+#include "units.hpp"
 
 namespace TaskParams
 {
@@ -12,34 +14,67 @@ namespace TaskParams
     {
         const int8_t pin_id;
         const Milliseconds task_period;
+        const Units::Microseconds task_period_us; // converted here, at compile time, for run-time use
 
         constexpr TaskParams(const int8_t pin_id, const Milliseconds task_period)
-            : pin_id(pin_id), task_period(task_period) {}
+            : pin_id(pin_id), task_period(task_period), task_period_us(Units::microseconds(task_period)) {}
 
         constexpr TaskParams(const Milliseconds task_period)
-            : pin_id(0), task_period(task_period) {}
+            : TaskParams(0, task_period) {}
 
         TaskParams() = delete;
     };
 
-    struct TaskParamsWithMailbox : public TaskParams
+    struct TaskParamsWithMeasurementWindow : public TaskParams
     {
-        const std::set<TaskHandle_t> tasks;
+        const size_t number_of_periods;
 
-        TaskParamsWithMailbox(const uint8_t pin_id,
-                              const Milliseconds task_period,
-                              const std::set<TaskHandle_t> tasks)
+        constexpr TaskParamsWithMeasurementWindow(const uint8_t pin_id,
+                                                  const Milliseconds task_period,
+                                                  const size_t number_of_periods)
             : TaskParams(pin_id, task_period),
-              tasks(tasks) {}
+              number_of_periods(number_of_periods) {}
+    };
+
+    struct TaskParamsWithDebounce : public TaskParams
+    {
+        const Milliseconds debounce;
+
+        constexpr TaskParamsWithDebounce(const uint8_t pin_id,
+                                         const Milliseconds task_period,
+                                         const Milliseconds debounce)
+            : TaskParams(pin_id, task_period),
+              debounce(debounce) {}
+    };
+
+    struct TaskParamsWithSampleRate : public TaskParams
+    {
+        const Hertz sample_rate;
+
+        constexpr TaskParamsWithSampleRate(const uint8_t pin_id,
+                                           const Milliseconds task_period,
+                                           const Hertz sample_rate)
+            : TaskParams(pin_id, task_period),
+              sample_rate(sample_rate) {}
+    };
+
+    struct TaskParamsWithFraming : public TaskParams
+    {
+        const BinaryLog::Framing framing;
+
+        constexpr TaskParamsWithFraming(const Milliseconds task_period,
+                                        const BinaryLog::Framing framing)
+            : TaskParams(task_period),
+              framing(framing) {}
     };
 
     struct TaskParamsWithPulseDuration : public TaskParams
     {
-        const Milliseconds pulse_duration;
+        const Units::Microseconds pulse_duration;
 
         constexpr TaskParamsWithPulseDuration(const uint8_t pin_id,
                                               const Milliseconds task_period,
-                                              const Milliseconds pulse_duration)
+                                              const Units::Microseconds pulse_duration)
             : TaskParams(pin_id, task_period),
               pulse_duration(pulse_duration) {}
     };
@@ -0,0 +1,292 @@
+#ifndef TASK_REGISTRY
+#define TASK_REGISTRY
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.hpp"
+#include "common.hpp"
+
+namespace TaskRegistry
+{
+    constexpr BaseType_t ANY_CORE = -1;  // not pinned; the scheduler may run the task on either core
+    constexpr BaseType_t AUTO_CORE = -2; // pinned to a core chosen by partition()
+
+#ifdef NATIVE
+    constexpr BaseType_t NUMBER_OF_CORES = 1; // the POSIX port is single-core; placement is ignored
+#else
+    constexpr BaseType_t NUMBER_OF_CORES = portNUM_PROCESSORS;
+#endif
+    // Wi-Fi, Bluetooth, esp_timer and the UART driver's work live on the protocol core (0), so
+    // time-critical tasks get the application core to themselves.
+    constexpr BaseType_t BLOCKING_CORE = 0;
+    constexpr BaseType_t TIME_CRITICAL_CORE = NUMBER_OF_CORES - 1;
+
+    enum class Scheduling : uint8_t
+    {
+        RateMonotonic, // priority derived from the period, shortest period highest
+        Background,    // runs below every rate-monotonic task
+    };
+
+    enum class Role : uint8_t
+    {
+        TimeCritical, // sampling and watchdog work; kept away from blocking work
+        General,      // placed by utilisation
+        Blocking,     // busy-waits, serial I/O or heavy interrupt load
+    };
+
+    /**
+     * One row of the task table. Everything is known at compile time: stacks and TCBs are carved out
+     * of static storage sized from the table, and priorities are computed from the periods.
+     */
+    struct TaskDefinition
+    {
+        uint8_t task_number; // the number its Instrumentation::TaskProbe reports under
+        TaskFunction_t function;
+        const char *name;
+        const void *params;
+        Milliseconds period;
+        Microseconds wcet_budget; // worst-case execution time assumed by the utilisation check
+        uint32_t stack_size;      // bytes
+        Scheduling scheduling;
+        Role role;
+        BaseType_t core; // a core number, ANY_CORE or AUTO_CORE
+        TaskHandle_t *handle; // optional, filled in at creation for late-bound consumers
+    };
+
+    constexpr UBaseType_t BACKGROUND_PRIORITY = 1;
+    constexpr UBaseType_t LOWEST_RATE_MONOTONIC_PRIORITY = BACKGROUND_PRIORITY + 1;
+
+    // Stack depth in StackType_t units. The ESP32 port counts bytes; the POSIX port counts words and
+    // runs each task on a host thread, which needs far more than the target does.
+    constexpr uint32_t stack_depth(const uint32_t stack_size)
+    {
+#ifdef NATIVE
+        return (stack_size / sizeof(StackType_t) < configMINIMAL_STACK_SIZE) ? configMINIMAL_STACK_SIZE
+                                                                             : stack_size / sizeof(StackType_t);
+#else
+        return stack_size / sizeof(StackType_t);
+#endif
+    }
+
+    template <size_t N>
+    constexpr size_t total_stack_depth(const std::array<TaskDefinition, N> &table)
+    {
+        size_t total = 0;
+        for (const auto &task : table)
+            total += stack_depth(task.stack_size);
+        return total;
+    }
+
+    // Rate-monotonic rank: one priority level above the lowest for every distinct longer period.
+    template <size_t N>
+    constexpr UBaseType_t priority(const std::array<TaskDefinition, N> &table, const size_t index)
+    {
+        if (table[index].scheduling == Scheduling::Background)
+            return BACKGROUND_PRIORITY;
+
+        UBaseType_t rank = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            if (table[i].scheduling != Scheduling::RateMonotonic || table[i].period <= table[index].period)
+                continue;
+            bool counted = false;
+            for (size_t j = 0; j < i; j++)
+                if (table[j].scheduling == Scheduling::RateMonotonic && table[j].period == table[i].period)
+                    counted = true;
+            if (!counted)
+                rank++;
+        }
+        return LOWEST_RATE_MONOTONIC_PRIORITY + rank;
+    }
+
+    template <size_t N>
+    constexpr bool is_rate_monotonic(const std::array<TaskDefinition, N> &table)
+    {
+        for (size_t i = 0; i < N; i++)
+            for (size_t j = 0; j < N; j++)
+                if (table[i].scheduling == Scheduling::RateMonotonic &&
+                    table[j].scheduling == Scheduling::RateMonotonic &&
+                    table[i].period < table[j].period &&
+                    priority(table, i) <= priority(table, j))
+                    return false;
+        return true;
+    }
+
+    constexpr double utilisation(const TaskDefinition &task)
+    {
+        return task.scheduling == Scheduling::RateMonotonic ? task.wcet_budget / (task.period * 1000.0) : 0.0;
+    }
+
+    /**
+     * Resolves every AUTO_CORE entry to a core. Time-critical and blocking tasks go to their dedicated
+     * cores; general tasks are then placed worst-fit in decreasing order of utilisation, which keeps
+     * the cores balanced. Explicit cores and ANY_CORE are left as declared.
+     */
+    template <size_t N>
+    constexpr std::array<BaseType_t, N> partition(const std::array<TaskDefinition, N> &table)
+    {
+        std::array<BaseType_t, N> cores = {};
+        std::array<double, NUMBER_OF_CORES> load = {};
+        std::array<bool, N> placed = {};
+
+        for (size_t i = 0; i < N; i++)
+        {
+            cores[i] = table[i].core;
+            if (cores[i] == AUTO_CORE && table[i].role == Role::TimeCritical)
+                cores[i] = TIME_CRITICAL_CORE;
+            else if (cores[i] == AUTO_CORE && table[i].role == Role::Blocking)
+                cores[i] = BLOCKING_CORE;
+            placed[i] = cores[i] != AUTO_CORE;
+            if (cores[i] >= 0 && cores[i] < NUMBER_OF_CORES)
+                load[cores[i]] += utilisation(table[i]);
+        }
+
+        for (;;)
+        {
+            size_t heaviest = N;
+            for (size_t i = 0; i < N; i++)
+                if (!placed[i] && (heaviest == N || utilisation(table[i]) > utilisation(table[heaviest])))
+                    heaviest = i;
+            if (heaviest == N)
+                break;
+
+            BaseType_t lightest = 0;
+            for (BaseType_t core = 1; core < NUMBER_OF_CORES; core++)
+                if (load[core] < load[lightest])
+                    lightest = core;
+            cores[heaviest] = lightest;
+            load[lightest] += utilisation(table[heaviest]);
+            placed[heaviest] = true;
+        }
+        return cores;
+    }
+
+    // Unpinned tasks may run on any core, so they are counted against every core.
+    template <size_t N>
+    constexpr bool runs_on(const std::array<BaseType_t, N> &cores, const size_t index, const BaseType_t core)
+    {
+        return cores[index] == core || cores[index] == ANY_CORE;
+    }
+
+    template <size_t N>
+    constexpr size_t number_of_rate_monotonic_tasks(const std::array<TaskDefinition, N> &table, const BaseType_t core)
+    {
+        const auto cores = partition(table);
+        size_t count = 0;
+        for (size_t i = 0; i < N; i++)
+            if (table[i].scheduling == Scheduling::RateMonotonic && runs_on(cores, i, core))
+                count++;
+        return count;
+    }
+
+    template <size_t N>
+    constexpr double utilisation(const std::array<TaskDefinition, N> &table, const BaseType_t core)
+    {
+        const auto cores = partition(table);
+        double total = 0.0;
+        for (size_t i = 0; i < N; i++)
+            if (runs_on(cores, i, core))
+                total += utilisation(table[i]);
+        return total;
+    }
+
+    // Liu & Layland bound n(2^(1/n) - 1); the root is found by bisection so it can be evaluated at compile time.
+    constexpr double liu_layland_bound(const size_t n)
+    {
+        if (n == 0)
+            return 1.0;
+        double low = 1.0, high = 2.0;
+        for (int iteration = 0; iteration < 64; iteration++)
+        {
+            const double middle = (low + high) / 2.0;
+            double power = 1.0;
+            for (size_t i = 0; i < n; i++)
+                power *= middle;
+            (power < 2.0 ? low : high) = middle;
+        }
+        return static_cast<double>(n) * (low - 1.0);
+    }
+
+    // Partitioned rate-monotonic test: each core must be within the bound for the tasks it may run.
+    template <size_t N>
+    constexpr bool is_schedulable(const std::array<TaskDefinition, N> &table)
+    {
+        for (BaseType_t core = 0; core < NUMBER_OF_CORES; core++)
+            if (utilisation(table, core) > liu_layland_bound(number_of_rate_monotonic_tasks(table, core)))
+                return false;
+        return true;
+    }
+
+    template <size_t N>
+    constexpr bool has_valid_cores(const std::array<TaskDefinition, N> &table)
+    {
+        for (const auto &task : table)
+            if (task.core != ANY_CORE && task.core != AUTO_CORE && (task.core < 0 || task.core >= NUMBER_OF_CORES))
+                return false;
+        return true;
+    }
+
+    // What create_task() recorded about each task, for run-time reports.
+    struct RegisteredTask
+    {
+        uint8_t task_number;
+        const char *name;
+        uint32_t stack_bytes; // as allocated, which on the host may exceed the table's size
+        Milliseconds period;
+        double budgeted_utilisation;
+        BaseType_t core;
+    };
+
+    size_t number_of_registered_tasks();
+    const RegisteredTask &registered_task(const size_t index);
+    // The index-th task's handle, or nullptr once it has left through exit_current_task().
+    TaskHandle_t handle(const size_t index);
+
+    /**
+     * Deletes the calling task after clearing its handle, so reports skip it from then on. Tasks must
+     * leave through here rather than vTaskDelete(): a deleted task's handle is no longer valid. Its
+     * stack and TCB are static, so a report already holding the handle reads stale memory, not freed.
+     */
+    void exit_current_task();
+
+    TaskHandle_t create_task(const TaskDefinition &task,
+                             const UBaseType_t priority,
+                             const BaseType_t core,
+                             StackType_t *stack,
+                             StaticTask_t *tcb);
+
+    /**
+     * Emits one CoreLoad record per core (and one for unpinned tasks, as core 0xFF) into the binary
+     * log: the measured load from the tasks' probes alongside the budgeted load from the table.
+     */
+    void report_core_load();
+
+    /**
+     * Creates every task in TABLE from static stacks and TCBs; nothing is taken from the heap. The
+     * table must have static storage duration so that it can be a template argument.
+     */
+    template <size_t N, const std::array<TaskDefinition, N> &TABLE>
+    void create_tasks()
+    {
+        static_assert(is_rate_monotonic(TABLE), "Task priorities are not rate monotonic.");
+        static_assert(has_valid_cores(TABLE), "Task pinned to a core that does not exist.");
+        static_assert(is_schedulable(TABLE), "A core exceeds the rate-monotonic utilisation bound.");
+        constexpr auto cores = partition(TABLE);
+
+        static StackType_t stacks[total_stack_depth(TABLE)];
+        static StaticTask_t tcbs[N];
+
+        size_t offset = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            const auto handle = create_task(TABLE[i], priority(TABLE, i), cores[i], &stacks[offset], &tcbs[i]);
+            if (TABLE[i].handle != nullptr)
+                *TABLE[i].handle = handle;
+            offset += stack_depth(TABLE[i].stack_size);
+        }
+    }
+}
+
+#endif
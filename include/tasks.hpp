@@ -3,26 +3,116 @@
 
 #include <array>
 
+#include "adc_sampler.hpp"
 #include "common.hpp"
+#include "edge_capture.hpp"
+#include "error_rules.hpp"
+#include "filters.hpp"
+#include "statistics.hpp"
+#include "units.hpp"
+#include "waveform.hpp"
 
 namespace Tasks
 {
-    constexpr size_t NUMBER_OF_ANALOGUE_READINGS = 4;
-    static constexpr Microseconds TIMEOUT = 4000;
+    using SquareWaveCapture = EdgeCapture::EdgeCapture<32>;
 
-    void start_pulse(const int8_t output_pin_id);
-    void stop_pulse(const int8_t output_pin_id);
+    template <typename OutputPin>
+    void start_pulse();
+    template <typename OutputPin>
+    void stop_pulse();
 
     void toggle_digital_out(const int8_t output_pin_id);                                      // Task 1
-    bool digital_read(const int8_t input_pin_id);                                             // Task 2
-    Hertz measure_square_wave_frequency(const int8_t input_pin_id);                           // Task 3
-    uint16_t analogue_read(const int8_t input_pin_id);                                        // Task 4
-    double compute_filtered_analogue_signal(const std::array<uint16_t, 4> analogue_readings); // Task 5
+    template <typename InputPin>                                                              // Task 2
+    bool digital_read();
+    Units::MilliHertz measure_square_wave_frequency(const SquareWaveCapture &capture,         // Task 3
+                                                    const size_t number_of_periods);
+    size_t analogue_read(AdcSampler::BlockSource &source,                                     // Task 4
+                         uint16_t *samples,
+                         const size_t number_of_samples,
+                         const TickType_t ticks_to_wait);
+    template <typename Filter, size_t NUMBER_OF_READINGS>                                     // Task 5
+    Units::AdcCounts compute_filtered_analogue_signal(Filter &filter, const std::array<uint16_t, NUMBER_OF_READINGS> &new_readings);
     void execute_no_op_instruction(const size_t number_of_times);                             // Task 6
-    uint8_t compute_error_code(const double average_analogue_in);                             // Task 7
-    void visualise_error_code(const uint8_t error_code, const int8_t output_pin_id);          // Task 8
+    template <typename Evaluator>                                                             // Task 7
+    uint8_t compute_error_code(Evaluator &evaluator,
+                               const Units::AdcCounts average_analogue_in,
+                               const Statistics::Snapshot &analogue_statistics);
+    template <typename OutputPin>                                                             // Task 8
+    void visualise_error_code(const uint8_t error_code, Waveform::Generator &indicator);
     void log(const bool digital_input_state,                                                  // Task 9
-             const Hertz square_wave_frequency,
-             const double filtered_analogue_signal);
+             const Units::MilliHertz square_wave_frequency,
+             const Units::AdcCounts filtered_analogue_signal);
+    void log_analogue_statistics(const Statistics::Snapshot &analogue_statistics);
+
+    // Error code N is shown as N flashes, then a pause, so it can be counted by eye.
+    constexpr Units::Microseconds BLINK_FLASH = Units::Microseconds(150000);
+    constexpr Units::Microseconds BLINK_PERIOD = Units::Microseconds(400000);
+    constexpr Units::Microseconds BLINK_PAUSE = Units::Microseconds(1200000);
+    constexpr Waveform::Pattern blink_pattern(const uint8_t error_code)
+    {
+        return {BLINK_PERIOD, BLINK_FLASH, error_code, BLINK_PAUSE};
+    }
+
+    // Filter output in ADC counts. Moving averages are read in fixed point; other filters output
+    // integer counts (fixed-point coefficients) or float.
+    template <typename Filter>
+    Units::AdcCounts filter_output(const Filter &filter)
+    {
+        return Units::AdcCounts::from_counts(filter.output());
+    }
+
+    template <size_t TAPS, typename Sample, typename Sum>
+    Units::AdcCounts filter_output(const Filters::MovingAverage<TAPS, Sample, Sum> &filter)
+    {
+        return Units::AdcCounts::from_raw(filter.template mean<Units::AdcCounts::FRACTIONAL_BITS>());
+    }
+
+    // Typed pins compile to single GPIO register accesses; see Gpio::Pin.
+    template <typename OutputPin>
+    void start_pulse()
+    {
+        OutputPin::set();
+    }
+
+    template <typename OutputPin>
+    void stop_pulse()
+    {
+        OutputPin::clear();
+    }
+
+    template <typename InputPin>
+    bool digital_read()
+    {
+        return InputPin::read();
+    }
+
+    // The pattern runs in the generator, so this is only called when the code changes.
+    template <typename OutputPin>
+    void visualise_error_code(const uint8_t error_code, Waveform::Generator &indicator)
+    {
+        if (error_code != 0 && indicator.start(OutputPin::number, blink_pattern(error_code)))
+            return;
+        // Off, or a code the generator cannot blink: fall back to a steady level.
+        indicator.stop();
+        OutputPin::write(error_code != 0);
+    }
+
+    // The evaluator keeps each rule's hysteresis state between calls.
+    template <typename Evaluator>
+    uint8_t compute_error_code(Evaluator &evaluator,
+                               const Units::AdcCounts average_analogue_in,
+                               const Statistics::Snapshot &analogue_statistics)
+    {
+        return evaluator.evaluate({average_analogue_in, analogue_statistics});
+    }
+
+    // The filter keeps its own history, so only the readings taken since the last call are fed in.
+    template <typename Filter, size_t NUMBER_OF_READINGS>
+    Units::AdcCounts compute_filtered_analogue_signal(Filter &filter, const std::array<uint16_t, NUMBER_OF_READINGS> &new_readings)
+    {
+        for (const auto reading : new_readings)
+            filter.push(reading);
+        return filter_output(filter);
+    }
 }
 #endif
\ No newline at end of file
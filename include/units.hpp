@@ -0,0 +1,105 @@
+#ifndef UNITS
+#define UNITS
+
+#include <cstdint>
+
+#include "platform.hpp"
+#include "common.hpp"
+
+/**
+ * Strongly typed integer quantities for run-time paths. The ESP32 has no double-precision FPU, so the
+ * double typedefs in common.hpp are kept for configuration only and converted here, at compile time
+ * wherever the input is constexpr.
+ */
+namespace Units
+{
+    // Tag keeps otherwise identical representations from being mixed up.
+    template <typename Tag, typename Rep>
+    class Quantity
+    {
+    public:
+        using rep = Rep;
+
+        Quantity() = default; // trivial, so quantities can live in seqlocks; Quantity{} is zero
+        constexpr explicit Quantity(const Rep value) : value(value) {}
+
+        constexpr Rep count() const { return value; }
+
+        constexpr Quantity operator+(const Quantity other) const { return Quantity(value + other.value); }
+        constexpr Quantity operator-(const Quantity other) const { return Quantity(value - other.value); }
+
+        constexpr bool operator==(const Quantity other) const { return value == other.value; }
+        constexpr bool operator!=(const Quantity other) const { return value != other.value; }
+        constexpr bool operator<(const Quantity other) const { return value < other.value; }
+        constexpr bool operator<=(const Quantity other) const { return value <= other.value; }
+        constexpr bool operator>(const Quantity other) const { return value > other.value; }
+        constexpr bool operator>=(const Quantity other) const { return value >= other.value; }
+
+    private:
+        Rep value;
+    };
+
+    using Microseconds = Quantity<struct MicrosecondsTag, uint32_t>; // wraps after about 71 minutes
+    using MilliHertz = Quantity<struct MilliHertzTag, uint32_t>;
+
+    /**
+     * ADC reading in signed Q23.8: whole counts in the integer part, so filter outputs keep 1/256 of
+     * a count of precision without floating point.
+     */
+    class AdcCounts : public Quantity<struct AdcCountsTag, int32_t>
+    {
+    public:
+        static constexpr int FRACTIONAL_BITS = 8;
+
+        using Quantity::Quantity;
+        AdcCounts() = default;
+        constexpr AdcCounts(const Quantity &quantity) : Quantity(quantity) {}
+
+        static constexpr AdcCounts from_raw(const int32_t raw) { return AdcCounts(raw); }
+        static constexpr AdcCounts from_counts(const int32_t counts) { return AdcCounts(counts * (1 << FRACTIONAL_BITS)); }
+        // For filters with floating-point output; single precision is in hardware on the ESP32.
+        static constexpr AdcCounts from_counts(const float counts)
+        {
+            return AdcCounts(static_cast<int32_t>(counts * (1 << FRACTIONAL_BITS) + (counts < 0 ? -0.5f : 0.5f)));
+        }
+
+        constexpr int32_t whole_counts() const { return count() >> FRACTIONAL_BITS; }
+        // Scaled as the binary log expects.
+        constexpr int32_t hundredths() const
+        {
+            return static_cast<int32_t>((static_cast<int64_t>(count()) * 100 + (1 << (FRACTIONAL_BITS - 1))) >> FRACTIONAL_BITS);
+        }
+    };
+
+    constexpr MilliHertz millihertz(const Hertz frequency)
+    {
+        return MilliHertz(static_cast<uint32_t>(frequency * 1000.0 + 0.5));
+    }
+
+    constexpr Microseconds microseconds(const Milliseconds duration)
+    {
+        return Microseconds(static_cast<uint32_t>(duration * 1000.0 + 0.5));
+    }
+
+    // Rounds down, as period_to_number_of_ticks_to_sleep() does.
+    constexpr TickType_t ticks(const Microseconds duration)
+    {
+        return static_cast<TickType_t>(duration.count() / (1000u * portTICK_PERIOD_MS));
+    }
+
+    // Mean frequency of number_of_periods periods spanning window; integer throughout.
+    constexpr MilliHertz frequency(const uint32_t number_of_periods, const Microseconds window)
+    {
+        return window.count() == 0
+                   ? MilliHertz(0)
+                   : MilliHertz(static_cast<uint32_t>((static_cast<uint64_t>(number_of_periods) * 1000000000u +
+                                                       window.count() / 2) /
+                                                      window.count()));
+    }
+
+    static_assert(frequency(8, Microseconds(16000)) == MilliHertz(500000), "8 periods in 16 ms is 500 Hz.");
+    static_assert(AdcCounts::from_counts(2047).hundredths() == 204700, "Whole counts convert exactly.");
+    static_assert(AdcCounts::from_raw(384).hundredths() == 150, "1.5 counts.");
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef WAVEFORM
+#define WAVEFORM
+
+#include <cstdint>
+
+#include "units.hpp"
+
+namespace Waveform
+{
+    /**
+     * A burst of `pulses` pulses, one every period, then the pin held low for `pause` beyond the last
+     * period, repeated. One pulse and no pause is a plain pulse train.
+     */
+    struct Pattern
+    {
+        Units::Microseconds period;
+        Units::Microseconds pulse_width;
+        uint8_t pulses;
+        Units::Microseconds pause;
+    };
+
+    /**
+     * Drives a repeating pulse pattern on a pin without any task involvement once started: the RMT
+     * peripheral in loop mode on the ESP32, a simulated peripheral thread writing through the
+     * simulated HAL (which records every edge) on the host.
+     */
+    class Generator
+    {
+    public:
+        virtual ~Generator() = default;
+
+        // Returns false if the backend cannot produce the requested waveform.
+        virtual bool start(const int8_t pin_id, const Pattern &pattern) = 0;
+        virtual void stop() = 0;
+
+        bool start(const int8_t pin_id, const Units::Microseconds period, const Units::Microseconds pulse_width)
+        {
+            return start(pin_id, Pattern{period, pulse_width, 1, Units::Microseconds(0)});
+        }
+    };
+
+    Generator &create_generator();
+
+    /**
+     * A second generator for slow indicator patterns: another RMT channel on the ESP32, on a coarser
+     * clock so that phases of seconds fit in its item memory.
+     */
+    Generator &create_indicator_generator();
+}
+
+#endif
@@ -0,0 +1,35 @@
+# Builds the FreeRTOS kernel with the GCC POSIX port for the native environment.
+# The kernel repository has no PlatformIO manifest, so it is fetched through lib_deps, ignored by the
+# library dependency finder and compiled here with only the sources the POSIX port needs.
+import os
+
+Import("env")
+
+kernel_dir = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"), "FreeRTOS-Kernel")
+port_dir = os.path.join(kernel_dir, "portable", "ThirdParty", "GCC", "Posix")
+
+env.Append(
+    CPPPATH=[
+        os.path.join(kernel_dir, "include"),
+        port_dir,
+        os.path.join(port_dir, "utils"),
+    ],
+    LIBS=["pthread"],
+)
+
+env.BuildSources(
+    os.path.join("$BUILD_DIR", "FreeRTOS-Kernel"),
+    kernel_dir,
+    src_filter=[
+        "-<*>",
+        "+<tasks.c>",
+        "+<queue.c>",
+        "+<list.c>",
+        "+<timers.c>",
+        "+<event_groups.c>",
+        "+<stream_buffer.c>",
+        "+<portable/MemMang/heap_4.c>",
+        "+<portable/ThirdParty/GCC/Posix/port.c>",
+        "+<portable/ThirdParty/GCC/Posix/utils/wait_for_event.c>",
+    ],
+)
@@ -0,0 +1,90 @@
+#include "adc_sampler.hpp"
+#include "hal.hpp"
+
+#ifndef NATIVE
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#endif
+
+namespace AdcSampler
+{
+    bool BurstSource::start(const int8_t pin, const Hertz)
+    {
+        pin_id = pin;
+        return true;
+    }
+
+    size_t BurstSource::read_block(uint16_t *samples, const size_t number_of_samples, const TickType_t)
+    {
+        auto &hal = Hal::get();
+        for (size_t i = 0; i < number_of_samples; i++)
+            samples[i] = hal.analogue_read(pin_id);
+        return number_of_samples;
+    }
+
+#ifndef NATIVE
+    /**
+     * Continuous ADC1 sampling through the I2S peripheral's built-in ADC mode; the DMA engine fills
+     * its buffers without CPU involvement and i2s_read() hands them over a block at a time.
+     */
+    class I2sDmaSource : public BlockSource
+    {
+    public:
+        bool start(const int8_t pin_id, const Hertz sample_rate) override
+        {
+            const auto channel = digitalPinToAnalogChannel(pin_id);
+            if (channel < 0 || channel >= ADC1_CHANNEL_MAX)
+                return false;
+
+            i2s_config_t config = {};
+            config.mode = static_cast<i2s_mode_t>(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+            config.sample_rate = static_cast<uint32_t>(sample_rate);
+            config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+            config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+            config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+            config.dma_buf_count = DMA_BUFFER_COUNT;
+            config.dma_buf_len = DMA_BUFFER_LENGTH;
+
+            if (i2s_driver_install(PORT, &config, 0, nullptr) != ESP_OK)
+                return false;
+            if (i2s_set_adc_mode(ADC_UNIT_1, static_cast<adc1_channel_t>(channel)) != ESP_OK ||
+                adc1_config_channel_atten(static_cast<adc1_channel_t>(channel), ADC_ATTEN_DB_11) != ESP_OK ||
+                i2s_adc_enable(PORT) != ESP_OK)
+            {
+                i2s_driver_uninstall(PORT);
+                return false;
+            }
+            return true;
+        }
+
+        size_t read_block(uint16_t *samples, const size_t number_of_samples, const TickType_t ticks_to_wait) override
+        {
+            size_t bytes_read = 0;
+            i2s_read(PORT, samples, number_of_samples * sizeof(uint16_t), &bytes_read, ticks_to_wait);
+
+            const auto samples_read = bytes_read / sizeof(uint16_t);
+            for (size_t i = 0; i < samples_read; i++)
+                samples[i] &= ADC_RESULT_MASK; // upper nibble holds the channel number
+            return samples_read;
+        }
+
+    private:
+        static constexpr i2s_port_t PORT = I2S_NUM_0;
+        static constexpr int DMA_BUFFER_COUNT = 4;
+        static constexpr int DMA_BUFFER_LENGTH = 256;
+        static constexpr uint16_t ADC_RESULT_MASK = 0x0FFF;
+    };
+#endif
+
+    BlockSource &create_block_source(const int8_t pin_id, const Hertz sample_rate)
+    {
+#ifndef NATIVE
+        static I2sDmaSource dma_source;
+        if (dma_source.start(pin_id, sample_rate))
+            return dma_source;
+#endif
+        static BurstSource burst_source;
+        burst_source.start(pin_id, sample_rate);
+        return burst_source;
+    }
+}
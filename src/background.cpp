@@ -0,0 +1,154 @@
+#include "background.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "instrumentation.hpp"
+#include "power.hpp"
+#include "task_registry.hpp"
+
+#ifndef NATIVE
+#include <esp_freertos_hooks.h>
+#endif
+
+namespace Background
+{
+    namespace
+    {
+        // Longer gaps between idle-hook calls mean a task or interrupt ran in between.
+        constexpr uint32_t IDLE_GAP_US = 20;
+
+        struct IdleCounter
+        {
+            std::atomic<uint32_t> cycles{0};
+            uint32_t previous_call = 0; // only touched by the core's own idle task
+            bool started = false;
+        };
+
+        std::array<IdleCounter, TaskRegistry::NUMBER_OF_CORES> idle_counters;
+
+        size_t current_core()
+        {
+#ifdef NATIVE
+            return 0;
+#else
+            return static_cast<size_t>(xPortGetCoreID());
+#endif
+        }
+
+        // Responses in this histogram bucket or above took at least half the period.
+        size_t slow_response_bucket(const uint8_t task_number)
+        {
+            for (size_t i = 0; i < TaskRegistry::number_of_registered_tasks(); i++)
+            {
+                const auto &task = TaskRegistry::registered_task(i);
+                if (task.task_number != task_number)
+                    continue;
+                const auto half_period_us = static_cast<uint32_t>(task.period * 500.0);
+                size_t bucket = 0;
+                while (bucket + 1 < Instrumentation::HISTOGRAM_BUCKETS && (UINT32_C(1) << bucket) < half_period_us)
+                    bucket++;
+                return bucket;
+            }
+            return Instrumentation::HISTOGRAM_BUCKETS - 1;
+        }
+    }
+
+    bool on_idle()
+    {
+        auto &counter = idle_counters[current_core()];
+        const auto now = Instrumentation::cycle_count();
+        const auto gap = now - counter.previous_call;
+        if (counter.started && gap < IDLE_GAP_US * Instrumentation::cycles_per_microsecond())
+            counter.cycles.fetch_add(gap, std::memory_order_relaxed);
+        counter.previous_call = now;
+        counter.started = true;
+        // With power management the idle task must be free to wait for interrupts and scale down.
+        return Power::active();
+    }
+
+    void install_idle_hooks()
+    {
+#ifndef NATIVE
+        // The native build calls on_idle() from vApplicationIdleHook() instead.
+        for (BaseType_t core = 0; core < TaskRegistry::NUMBER_OF_CORES; core++)
+            esp_register_freertos_idle_hook_for_cpu(&on_idle, static_cast<UBaseType_t>(core));
+#endif
+    }
+
+    uint32_t idle_cycles()
+    {
+        return idle_counters[current_core()].cycles.load(std::memory_order_relaxed);
+    }
+
+    Executor::Executor(const Settings &settings, Work work)
+        : settings(settings),
+          work(work),
+          units(settings.minimum_units),
+          previous_cycles(Instrumentation::cycle_count()),
+          previous_idle_cycles(idle_cycles())
+    {
+        bool missed;
+        guarded_task_at_risk(missed); // takes the guarded tasks' starting counts
+    }
+
+    void Executor::run()
+    {
+        const auto now = Instrumentation::cycle_count();
+        const auto idle = idle_cycles();
+        const auto elapsed = now - previous_cycles;
+        const auto idle_elapsed = std::min(idle - previous_idle_cycles, elapsed);
+        previous_cycles = now;
+        previous_idle_cycles = idle;
+
+        const auto utilisation = (elapsed == 0) ? 0
+                                                : static_cast<uint16_t>((static_cast<uint64_t>(elapsed - idle_elapsed) * 10000) /
+                                                                        elapsed);
+        const auto elapsed_us = elapsed / Instrumentation::cycles_per_microsecond();
+        latest.units_per_second = (elapsed_us == 0) ? 0
+                                                    : static_cast<uint32_t>(static_cast<uint64_t>(latest.units_per_period) *
+                                                                            1000000 / elapsed_us);
+        latest.utilisation = utilisation;
+
+        bool missed = false;
+        if (guarded_task_at_risk(missed))
+        {
+            units = missed ? settings.minimum_units : std::max(settings.minimum_units, units / 2);
+            latest.back_offs++;
+        }
+        else if (utilisation < settings.target_utilisation)
+        {
+            units = std::min(settings.maximum_units, units + std::max<uint32_t>(1, units / 16));
+        }
+        else
+        {
+            units = std::max(settings.minimum_units, units - units / 4);
+        }
+
+        work(units);
+        latest.units_per_period = units;
+    }
+
+    bool Executor::guarded_task_at_risk(bool &missed)
+    {
+        bool at_risk = false;
+        missed = false;
+        for (size_t i = 0; i < settings.guarded_tasks.size(); i++)
+        {
+            Instrumentation::TaskStatistics statistics;
+            const auto task_number = settings.guarded_tasks[i];
+            if (task_number == 0 || !Instrumentation::query(task_number, statistics))
+                continue;
+
+            uint32_t slow = 0;
+            for (size_t b = slow_response_bucket(task_number); b < Instrumentation::HISTOGRAM_BUCKETS; b++)
+                slow += statistics.response_histogram[b];
+
+            auto &guard = guards[i];
+            missed = missed || statistics.deadline_misses != guard.deadline_misses;
+            at_risk = at_risk || slow != guard.slow_responses;
+            guard = {statistics.deadline_misses, slow};
+        }
+        return at_risk || missed;
+    }
+}
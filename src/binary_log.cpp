@@ -0,0 +1,130 @@
+#include <cstring>
+
+#include "binary_log.hpp"
+#include "hal.hpp"
+
+namespace BinaryLog
+{
+    // COBS adds one byte per 254 bytes plus the leading code byte; raw framing adds four bytes.
+    static constexpr size_t MAXIMUM_FRAME_SIZE = MAXIMUM_PACKET_SIZE + MAXIMUM_PACKET_SIZE / 254 + 2;
+
+    static RecordRing<RING_CAPACITY> ring;
+
+    bool log(const RecordType type,
+             const uint8_t task,
+             const int32_t value0,
+             const int32_t value1,
+             const uint16_t aux)
+    {
+        const Record record = {Hal::get().micros().count(), type, task, aux, value0, value1};
+        return ring.push(record);
+    }
+
+    uint16_t crc16(const uint8_t *data, const size_t length)
+    {
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= static_cast<uint16_t>(data[i]) << 8;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+        return crc;
+    }
+
+    size_t cobs_encode(const uint8_t *input, const size_t length, uint8_t *output)
+    {
+        size_t code_index = 0;
+        size_t write_index = 1;
+        uint8_t code = 1;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (input[i] == 0)
+            {
+                output[code_index] = code;
+                code_index = write_index++;
+                code = 1;
+                continue;
+            }
+            output[write_index++] = input[i];
+            if (++code == 0xFF)
+            {
+                output[code_index] = code;
+                code_index = write_index++;
+                code = 1;
+            }
+        }
+        output[code_index] = code;
+        return write_index;
+    }
+
+    void send_packet(uint8_t *packet, size_t length, const Framing framing)
+    {
+        static uint8_t frame[MAXIMUM_FRAME_SIZE + 1];
+
+        const auto crc = crc16(packet, length);
+        packet[length++] = static_cast<uint8_t>(crc);
+        packet[length++] = static_cast<uint8_t>(crc >> 8);
+
+        size_t frame_length;
+        if (framing == Framing::Cobs)
+        {
+            frame_length = cobs_encode(packet, length, frame);
+            frame[frame_length++] = 0x00;
+        }
+        else
+        {
+            frame[0] = 0xA5;
+            frame[1] = 0x5A;
+            frame[2] = static_cast<uint8_t>(length);
+            frame[3] = static_cast<uint8_t>(length >> 8);
+            memcpy(&frame[4], packet, length);
+            frame_length = length + 4;
+        }
+
+        Hal::get().write_serial(reinterpret_cast<const char *>(frame), frame_length);
+    }
+
+    size_t drain(const Framing framing, Sink sink, void *context)
+    {
+        static uint8_t packet[MAXIMUM_PACKET_SIZE];
+        static uint16_t packet_sequence = 0;
+
+        size_t number_of_records = 0;
+        size_t offset = LIVE_PACKET_HEADER_SIZE;
+
+        // Losses are reported in-band, ahead of the records that survived.
+        const auto dropped = ring.take_dropped();
+        if (dropped > 0)
+        {
+            const Record record = {Hal::get().micros().count(), RecordType::RecordsDropped, 0, 0, static_cast<int32_t>(dropped), 0};
+            memcpy(&packet[offset], &record, sizeof(record));
+            if (sink != nullptr)
+                sink(context, record);
+            offset += sizeof(record);
+            number_of_records++;
+        }
+
+        Record record;
+        while (number_of_records < RECORDS_PER_PACKET && ring.pop(record))
+        {
+            memcpy(&packet[offset], &record, sizeof(record));
+            if (sink != nullptr)
+                sink(context, record);
+            offset += sizeof(record);
+            number_of_records++;
+        }
+        if (number_of_records == 0)
+            return 0;
+
+        packet[0] = LIVE_PACKET_VERSION;
+        packet[1] = static_cast<uint8_t>(number_of_records);
+        packet[2] = static_cast<uint8_t>(packet_sequence);
+        packet[3] = static_cast<uint8_t>(packet_sequence >> 8);
+        packet_sequence++;
+
+        send_packet(packet, offset, framing);
+        return number_of_records;
+    }
+}
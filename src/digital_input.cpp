@@ -0,0 +1,166 @@
+#include "digital_input.hpp"
+#include "hal.hpp"
+
+namespace DigitalInput
+{
+    uint32_t Dispatcher::watch(const int8_t pin_id, const Milliseconds debounce, const TaskHandle_t subscriber)
+    {
+        for (size_t i = 0; i < number_of_channels; i++)
+        {
+            auto &channel = channels[i];
+            if (channel.pin_id != pin_id)
+                continue;
+            for (auto &slot : channel.subscribers)
+                if (slot == nullptr)
+                {
+                    slot = subscriber;
+                    return channel.bit;
+                }
+            return 0;
+        }
+        if (number_of_channels == channels.size())
+            return 0;
+
+        auto &channel = channels[number_of_channels];
+        const auto level = Hal::get().digital_read(pin_id);
+        const auto period = pdMS_TO_TICKS(debounce);
+        channel.timer = xTimerCreateStatic("debounce",
+                                           period > 0 ? period : 1,
+                                           pdFALSE,
+                                           &channel,
+                                           &Dispatcher::on_debounce_expired,
+                                           &channel.timer_buffer);
+        if (channel.timer == nullptr)
+            return 0;
+
+        channel.pin_id = pin_id;
+        channel.bit = UINT32_C(1) << number_of_channels;
+        channel.subscribers[0] = subscriber;
+        channel.stable_level.store(level, std::memory_order_relaxed);
+        channel.event.write({level, Hal::get().micros().count(), 0, 0});
+        number_of_channels++;
+
+#ifdef NATIVE
+        if (forwarding_timer == nullptr)
+        {
+            forwarding_timer = xTimerCreateStatic("inputs", 1, pdTRUE, this, &Dispatcher::forward_pending, &forwarding_timer_buffer);
+            xTimerStart(forwarding_timer, 0);
+        }
+#endif
+        Hal::get().attach_change_interrupt(pin_id, &Dispatcher::on_change, &channel);
+        return channel.bit;
+    }
+
+    bool Dispatcher::latest(const int8_t pin_id, Event &event) const
+    {
+        const auto channel = find(pin_id);
+        if (channel == nullptr)
+            return false;
+        // The writer is an interrupt or the timer task and never stalls mid-write, so just retry.
+        for (;;)
+        {
+            const auto seq = channel->event.begin_read();
+            event = channel->event.read_unchecked();
+            if (channel->event.validate(seq))
+                return true;
+        }
+    }
+
+    const Dispatcher::Channel *Dispatcher::find(const int8_t pin_id) const
+    {
+        for (size_t i = 0; i < number_of_channels; i++)
+            if (channels[i].pin_id == pin_id)
+                return &channels[i];
+        return nullptr;
+    }
+
+    // The interrupt path, on_change() to notify_from_interrupt(), is in IRAM.
+    void IRAM_ATTR Dispatcher::on_change(void *context, const uint32_t timestamp, const bool level)
+    {
+        auto &channel = *static_cast<Channel *>(context);
+        channel.edges.fetch_add(1, std::memory_order_relaxed);
+
+        if (channel.locked.exchange(true, std::memory_order_acquire))
+            return; // bouncing within the debounce interval
+        if (level == channel.stable_level.load(std::memory_order_relaxed))
+        {
+            channel.locked.store(false, std::memory_order_release);
+            return;
+        }
+        accept(channel, level, timestamp);
+        notify_from_interrupt(channel);
+    }
+
+    void Dispatcher::on_debounce_expired(TimerHandle_t timer)
+    {
+        auto &channel = *static_cast<Channel *>(pvTimerGetTimerID(timer));
+        auto &hal = Hal::get();
+
+        // Still holding the lock: a pin that settled at the other level is a change of its own.
+        auto level = hal.digital_read(channel.pin_id);
+        if (level == channel.stable_level.load(std::memory_order_relaxed))
+        {
+            channel.locked.store(false, std::memory_order_release);
+            // An edge in the gap before unlocking was ignored, so look once more.
+            level = hal.digital_read(channel.pin_id);
+            if (level == channel.stable_level.load(std::memory_order_relaxed) ||
+                channel.locked.exchange(true, std::memory_order_acquire))
+                return;
+        }
+        accept(channel, level, hal.micros().count());
+        notify(channel);
+        xTimerStart(timer, 0);
+    }
+
+    void IRAM_ATTR Dispatcher::accept(Channel &channel, const bool level, const uint32_t timestamp)
+    {
+        channel.stable_level.store(level, std::memory_order_relaxed);
+        const auto changes = channel.changes.fetch_add(1, std::memory_order_relaxed) + 1;
+        channel.event.write({level, timestamp, changes, channel.edges.load(std::memory_order_relaxed)});
+    }
+
+    void Dispatcher::notify(Channel &channel)
+    {
+        for (const auto subscriber : channel.subscribers)
+            if (subscriber != nullptr)
+                xTaskNotify(subscriber, channel.bit, eSetBits);
+    }
+
+#ifdef NATIVE
+    // Simulated interrupts are raised on a host thread, which must not call into the kernel, so they
+    // are forwarded from a one-tick timer instead.
+    void Dispatcher::notify_from_interrupt(Channel &channel)
+    {
+        channel.pending.store(true, std::memory_order_release);
+    }
+
+    void Dispatcher::forward_pending(TimerHandle_t timer)
+    {
+        auto &self = *static_cast<Dispatcher *>(pvTimerGetTimerID(timer));
+        for (size_t i = 0; i < self.number_of_channels; i++)
+        {
+            auto &channel = self.channels[i];
+            if (!channel.pending.exchange(false, std::memory_order_acquire))
+                continue;
+            notify(channel);
+            xTimerStart(channel.timer, 0);
+        }
+    }
+#else
+    void IRAM_ATTR Dispatcher::notify_from_interrupt(Channel &channel)
+    {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        for (const auto subscriber : channel.subscribers)
+            if (subscriber != nullptr)
+                xTaskNotifyFromISR(subscriber, channel.bit, eSetBits, &higher_priority_task_woken);
+        xTimerStartFromISR(channel.timer, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+#endif
+
+    Dispatcher &dispatcher()
+    {
+        static Dispatcher dispatcher;
+        return dispatcher;
+    }
+}
@@ -0,0 +1,157 @@
+#include "flash.hpp"
+
+#include <array>
+
+#ifdef NATIVE
+#include <cstdlib>
+#else
+#include <esp_partition.h>
+#endif
+
+namespace Flash
+{
+    namespace
+    {
+        bool within_page(const size_t offset, const size_t length)
+        {
+            return length > 0 && length <= PAGE_SIZE && offset / PAGE_SIZE == (offset + length - 1) / PAGE_SIZE;
+        }
+    }
+
+#ifdef NATIVE
+    namespace
+    {
+        const std::array<uint8_t, SECTOR_SIZE> &erased_sector()
+        {
+            static const auto erased = [] {
+                std::array<uint8_t, SECTOR_SIZE> sector;
+                sector.fill(0xFF);
+                return sector;
+            }();
+            return erased;
+        }
+    }
+
+    FileFlash::~FileFlash()
+    {
+        if (file != nullptr)
+            fclose(file);
+    }
+
+    bool FileFlash::open(const char *path)
+    {
+        file = fopen(path, "r+b");
+        if (file == nullptr)
+            file = fopen(path, "w+b");
+        if (file == nullptr || fseek(file, 0, SEEK_END) != 0)
+            return false;
+        const auto existing = static_cast<size_t>(ftell(file));
+        for (auto length = existing; length < IMAGE_SIZE; length += erased_sector().size())
+            fwrite(erased_sector().data(), 1, erased_sector().size(), file);
+        return fflush(file) == 0;
+    }
+
+    bool FileFlash::read(const size_t offset, void *data, const size_t length)
+    {
+        if (offset + length > IMAGE_SIZE || fseek(file, static_cast<long>(offset), SEEK_SET) != 0)
+            return false;
+        counters.bytes_read += length;
+        return fread(data, 1, length, file) == length;
+    }
+
+    bool FileFlash::program(const size_t offset, const void *data, const size_t length)
+    {
+        std::array<uint8_t, PAGE_SIZE> page;
+        if (offset + length > IMAGE_SIZE || !within_page(offset, length) || !read(offset, page.data(), length))
+            return false;
+        counters.bytes_read -= length; // the read-back is part of the emulation, not the workload
+
+        const auto bytes = static_cast<const uint8_t *>(data);
+        bool overwrite = false;
+        for (size_t i = 0; i < length; i++)
+        {
+            overwrite = overwrite || (bytes[i] & ~page[i]) != 0;
+            page[i] &= bytes[i];
+        }
+        counters.overwrites += overwrite;
+        counters.programs++;
+        counters.bytes_programmed += length;
+        return fseek(file, static_cast<long>(offset), SEEK_SET) == 0 &&
+               fwrite(page.data(), 1, length, file) == length && fflush(file) == 0;
+    }
+
+    bool FileFlash::erase_sector(const size_t sector)
+    {
+        if ((sector + 1) * SECTOR_SIZE > IMAGE_SIZE || fseek(file, static_cast<long>(sector * SECTOR_SIZE), SEEK_SET) != 0)
+            return false;
+        counters.sector_erases++;
+        if (failing_erases > 0)
+        {
+            failing_erases--;
+            return false;
+        }
+        return fwrite(erased_sector().data(), 1, SECTOR_SIZE, file) == SECTOR_SIZE && fflush(file) == 0;
+    }
+
+    Flash *telemetry_flash()
+    {
+        static FileFlash flash;
+        static const bool opened = [] {
+            const auto path = getenv("TELEMETRY_FLASH");
+            return flash.open(path != nullptr ? path : "telemetry.bin");
+        }();
+        return opened ? &flash : nullptr;
+    }
+#else
+    /**
+     * Goes through the SPI flash driver, which suspends the flash cache on both cores for the
+     * duration of each program and erase: about a millisecond per page and tens of milliseconds per
+     * sector, during which only code and data in IRAM and DRAM run. The ESP32 has no flash auto-suspend
+     * (CONFIG_SPI_FLASH_AUTO_SUSPEND is for later chips), so an erase is never interrupted to let
+     * flash code run.
+     */
+    class PartitionFlash : public Flash
+    {
+    public:
+        explicit PartitionFlash(const esp_partition_t *partition) : partition(partition) {}
+
+        size_t size() const override
+        {
+            return partition->size;
+        }
+
+        bool read(const size_t offset, void *data, const size_t length) override
+        {
+            counters.bytes_read += length;
+            return esp_partition_read(partition, offset, data, length) == ESP_OK;
+        }
+
+        bool program(const size_t offset, const void *data, const size_t length) override
+        {
+            if (!within_page(offset, length))
+                return false;
+            counters.programs++;
+            counters.bytes_programmed += length;
+            return esp_partition_write(partition, offset, data, length) == ESP_OK;
+        }
+
+        bool erase_sector(const size_t sector) override
+        {
+            counters.sector_erases++;
+            return esp_partition_erase_range(partition, sector * SECTOR_SIZE, SECTOR_SIZE) == ESP_OK;
+        }
+
+    private:
+        const esp_partition_t *const partition;
+    };
+
+    Flash *telemetry_flash()
+    {
+        const auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "telemetry");
+        if (partition == nullptr)
+            return nullptr;
+        static PartitionFlash flash(partition);
+        return &flash;
+    }
+#endif
+}
@@ -0,0 +1,27 @@
+#include <cstring>
+
+#include "hal.hpp"
+
+namespace Hal
+{
+    Hal &default_hal(); // Provided by the backend selected at build time.
+
+    static Hal *active_hal = nullptr;
+
+    Hal &get()
+    {
+        if (active_hal == nullptr)
+            active_hal = &default_hal();
+        return *active_hal;
+    }
+
+    void set(Hal &hal)
+    {
+        active_hal = &hal;
+    }
+
+    void print(const char *message)
+    {
+        get().write_serial(message, strlen(message));
+    }
+}
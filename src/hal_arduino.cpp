@@ -0,0 +1,149 @@
+#ifndef NATIVE
+
+#include <Arduino.h>
+#include <algorithm>
+#include <array>
+#include <esp_timer.h>
+#include <soc/gpio_struct.h>
+
+#include "hal.hpp"
+
+namespace Hal
+{
+    class ArduinoHal : public Hal
+    {
+    public:
+        void pin_mode(const int8_t pin_id, const PinMode mode) override
+        {
+            switch (mode)
+            {
+            case PinMode::Input:
+                pinMode(pin_id, INPUT);
+                break;
+            case PinMode::Output:
+                pinMode(pin_id, OUTPUT);
+                break;
+            case PinMode::InputPulldown:
+                pinMode(pin_id, INPUT_PULLDOWN);
+                break;
+            }
+        }
+
+        bool digital_read(const int8_t pin_id) override
+        {
+            return (digitalRead(pin_id) == HIGH);
+        }
+
+        void digital_write(const int8_t pin_id, const bool level) override
+        {
+            digitalWrite(pin_id, level ? HIGH : LOW);
+        }
+
+        uint16_t analogue_read(const int8_t pin_id) override
+        {
+            return analogRead(pin_id);
+        }
+
+        Units::Microseconds pulse_in(const int8_t pin_id, const bool level, const Units::Microseconds timeout) override
+        {
+            return Units::Microseconds(static_cast<uint32_t>(pulseIn(pin_id, level ? HIGH : LOW, timeout.count())));
+        }
+
+        void attach_rising_edge_interrupt(const int8_t pin_id, EdgeCallback callback, void *context) override
+        {
+            if (pin_id < 0 || static_cast<size_t>(pin_id) >= edge_handlers.size())
+                return;
+            edge_handlers[pin_id] = {callback, context};
+            attachInterruptArg(digitalPinToInterrupt(pin_id), &ArduinoHal::on_edge, &edge_handlers[pin_id], RISING);
+        }
+
+        void attach_change_interrupt(const int8_t pin_id, ChangeCallback callback, void *context) override
+        {
+            if (pin_id < 0 || static_cast<size_t>(pin_id) >= change_handlers.size())
+                return;
+            change_handlers[pin_id] = {callback, context, static_cast<uint8_t>(pin_id)};
+            attachInterruptArg(digitalPinToInterrupt(pin_id), &ArduinoHal::on_change, &change_handlers[pin_id], CHANGE);
+        }
+
+        Units::Microseconds micros() override
+        {
+            return Units::Microseconds(static_cast<uint32_t>(::micros()));
+        }
+
+        void delay_microseconds(const Units::Microseconds duration) override
+        {
+            delayMicroseconds(duration.count());
+        }
+
+        void begin_serial(const uint32_t baud_rate) override
+        {
+            Serial.begin(baud_rate);
+        }
+
+        void write_serial(const char *data, const size_t length) override
+        {
+            Serial.write(reinterpret_cast<const uint8_t *>(data), length);
+        }
+
+        size_t read_serial(char *data, const size_t length) override
+        {
+            const auto available = static_cast<size_t>(Serial.available());
+            return Serial.readBytes(data, std::min(length, available));
+        }
+
+    private:
+        /**
+         * Everything an interrupt calls must be in IRAM, as flash code cannot run while an erase or
+         * program has the cache disabled. Arduino's micros() and digitalRead() are only placed there
+         * when the core is built with CONFIG_ARDUINO_ISR_IRAM, so the handlers read the timer and the
+         * GPIO input registers directly.
+         */
+        static uint32_t IRAM_ATTR interrupt_micros()
+        {
+            return static_cast<uint32_t>(esp_timer_get_time());
+        }
+
+        static bool IRAM_ATTR interrupt_read(const uint8_t pin_id)
+        {
+            if (pin_id < 32)
+                return (GPIO.in >> pin_id) & 1;
+            return (GPIO.in1.data >> (pin_id - 32)) & 1;
+        }
+
+        struct EdgeHandler
+        {
+            EdgeCallback callback;
+            void *context;
+        };
+
+        static void IRAM_ATTR on_edge(void *handler)
+        {
+            const auto &h = *static_cast<EdgeHandler *>(handler);
+            h.callback(h.context, interrupt_micros());
+        }
+
+        struct ChangeHandler
+        {
+            ChangeCallback callback;
+            void *context;
+            uint8_t pin_id;
+        };
+
+        static void IRAM_ATTR on_change(void *handler)
+        {
+            const auto &h = *static_cast<ChangeHandler *>(handler);
+            h.callback(h.context, interrupt_micros(), interrupt_read(h.pin_id));
+        }
+
+        std::array<EdgeHandler, 40> edge_handlers = {};
+        std::array<ChangeHandler, 40> change_handlers = {};
+    };
+
+    Hal &default_hal()
+    {
+        static ArduinoHal hal;
+        return hal;
+    }
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifdef NATIVE
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "simulated_hal.hpp"
+
+namespace Hal
+{
+    static const auto start_time = std::chrono::steady_clock::now();
+
+    SimulatedHal::SimulatedHal() : serial_output(stdout) {}
+
+    SimulatedHal::~SimulatedHal()
+    {
+        interrupts_running = false;
+        if (interrupt_thread.joinable())
+            interrupt_thread.join();
+    }
+
+    bool SimulatedHal::valid(const int8_t pin_id)
+    {
+        return (pin_id >= 0) && (static_cast<size_t>(pin_id) < NUMBER_OF_PINS);
+    }
+
+    void SimulatedHal::set_digital_source(const int8_t pin_id, DigitalSource source)
+    {
+        if (valid(pin_id))
+            pins[pin_id].digital_source = std::move(source);
+    }
+
+    void SimulatedHal::set_analogue_source(const int8_t pin_id, AnalogueSource source)
+    {
+        if (valid(pin_id))
+            pins[pin_id].analogue_source = std::move(source);
+    }
+
+    void SimulatedHal::set_square_wave(const int8_t pin_id, const Hertz frequency)
+    {
+        if (frequency <= 0.0)
+        {
+            set_digital_source(pin_id, [](Microseconds) { return false; });
+            return;
+        }
+        const Microseconds period = 1000000.0 / frequency;
+        set_digital_source(pin_id, [period](const Microseconds now) {
+            return std::fmod(now, period) < (period / 2.0);
+        });
+    }
+
+    bool SimulatedHal::output_level(const int8_t pin_id) const
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        return valid(pin_id) && pins[pin_id].level;
+    }
+
+    uint32_t SimulatedHal::write_count(const int8_t pin_id) const
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        return valid(pin_id) ? pins[pin_id].writes : 0;
+    }
+
+    std::deque<SimulatedHal::Edge> SimulatedHal::recorded_edges() const
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        return edges;
+    }
+
+    void SimulatedHal::clear_recorded_edges()
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        edges.clear();
+    }
+
+    void SimulatedHal::set_serial_output(FILE *stream)
+    {
+        serial_output = stream;
+    }
+
+    void SimulatedHal::inject_serial_input(const char *data, const size_t length)
+    {
+        std::lock_guard<std::mutex> lock(serial_input_mutex);
+        serial_input.insert(serial_input.end(), data, data + length);
+    }
+
+    void SimulatedHal::pin_mode(const int8_t pin_id, const PinMode mode)
+    {
+        if (valid(pin_id))
+            pins[pin_id].mode = mode;
+    }
+
+    bool SimulatedHal::digital_read(const int8_t pin_id)
+    {
+        if (!valid(pin_id))
+            return false;
+        const auto &pin = pins[pin_id];
+        return pin.digital_source ? pin.digital_source(host_time()) : pin.level;
+    }
+
+    void SimulatedHal::digital_write(const int8_t pin_id, const bool level)
+    {
+        if (!valid(pin_id))
+            return;
+        const auto now = host_time();
+        std::lock_guard<std::mutex> lock(output_mutex);
+        auto &pin = pins[pin_id];
+        if (pin.level != level)
+        {
+            if (edges.size() == MAXIMUM_RECORDED_EDGES)
+                edges.pop_front();
+            edges.push_back({pin_id, level, now});
+        }
+        pin.level = level;
+        pin.writes++;
+    }
+
+    uint16_t SimulatedHal::analogue_read(const int8_t pin_id)
+    {
+        if (!valid(pin_id) || !pins[pin_id].analogue_source)
+            return 0;
+        const auto value = pins[pin_id].analogue_source(host_time());
+        return (value > MAXIMUM_ANALOGUE_VALUE) ? MAXIMUM_ANALOGUE_VALUE : value;
+    }
+
+    /**
+     * Mirrors Arduino's pulseIn(): wait for any pulse in progress to end, wait for the next pulse
+     * to start, then time it. Busy-waits like the real implementation so CPU cost is representative.
+     */
+    Units::Microseconds SimulatedHal::pulse_in(const int8_t pin_id, const bool level, const Units::Microseconds timeout)
+    {
+        const auto start = micros();
+        const auto timed_out = [&]() { return micros() - start >= timeout; };
+
+        while (digital_read(pin_id) == level)
+            if (timed_out())
+                return Units::Microseconds(0);
+        while (digital_read(pin_id) != level)
+            if (timed_out())
+                return Units::Microseconds(0);
+
+        const auto pulse_start = micros();
+        while (digital_read(pin_id) == level)
+            if (timed_out())
+                return Units::Microseconds(0);
+        return micros() - pulse_start;
+    }
+
+    void SimulatedHal::attach_rising_edge_interrupt(const int8_t pin_id, EdgeCallback callback, void *context)
+    {
+        if (!valid(pin_id))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(interrupt_mutex);
+            pins[pin_id].edge_callback = callback;
+            pins[pin_id].edge_context = context;
+            pins[pin_id].last_sampled_level = digital_read(pin_id);
+        }
+        start_interrupt_thread();
+    }
+
+    void SimulatedHal::attach_change_interrupt(const int8_t pin_id, ChangeCallback callback, void *context)
+    {
+        if (!valid(pin_id))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(interrupt_mutex);
+            pins[pin_id].change_callback = callback;
+            pins[pin_id].change_context = context;
+            pins[pin_id].last_sampled_level = digital_read(pin_id);
+        }
+        start_interrupt_thread();
+    }
+
+    void SimulatedHal::start_interrupt_thread()
+    {
+        if (!interrupts_running.exchange(true))
+            interrupt_thread = std::thread([this]() {
+                while (interrupts_running)
+                {
+                    sample_interrupt_pins();
+                    std::this_thread::sleep_for(std::chrono::microseconds(INTERRUPT_POLL_INTERVAL));
+                }
+            });
+    }
+
+    void SimulatedHal::sample_interrupt_pins()
+    {
+        std::lock_guard<std::mutex> lock(interrupt_mutex);
+        for (size_t pin_id = 0; pin_id < NUMBER_OF_PINS; pin_id++)
+        {
+            auto &pin = pins[pin_id];
+            if (pin.edge_callback == nullptr && pin.change_callback == nullptr)
+                continue;
+            const auto now = micros().count();
+            const auto level = digital_read(static_cast<int8_t>(pin_id));
+            if (level && !pin.last_sampled_level && pin.edge_callback != nullptr)
+                pin.edge_callback(pin.edge_context, now);
+            if (level != pin.last_sampled_level && pin.change_callback != nullptr)
+                pin.change_callback(pin.change_context, now, level);
+            pin.last_sampled_level = level;
+        }
+    }
+
+    Microseconds SimulatedHal::host_time()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start_time;
+        return std::chrono::duration<Microseconds, std::micro>(elapsed).count();
+    }
+
+    // Truncated to 32 bits in integers, so it wraps like the target's counter instead of overflowing.
+    Units::Microseconds SimulatedHal::micros()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start_time;
+        const auto count = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        return Units::Microseconds(static_cast<uint32_t>(static_cast<uint64_t>(count)));
+    }
+
+    void SimulatedHal::delay_microseconds(const Units::Microseconds duration)
+    {
+        const auto start = micros();
+        while (micros() - start < duration)
+        {
+        }
+    }
+
+    void SimulatedHal::begin_serial(const uint32_t) {}
+
+    void SimulatedHal::write_serial(const char *data, const size_t length)
+    {
+        fwrite(data, 1, length, serial_output);
+        fflush(serial_output);
+    }
+
+    size_t SimulatedHal::read_serial(char *data, const size_t length)
+    {
+        std::lock_guard<std::mutex> lock(serial_input_mutex);
+        const auto count = std::min(length, serial_input.size());
+        std::copy_n(serial_input.begin(), count, data);
+        serial_input.erase(serial_input.begin(), serial_input.begin() + count);
+        return count;
+    }
+
+    SimulatedHal &simulated()
+    {
+        static SimulatedHal hal;
+        return hal;
+    }
+
+    Hal &default_hal()
+    {
+        return simulated();
+    }
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include "instrumentation.hpp"
+#include "binary_log.hpp"
+
+#ifdef NATIVE
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#else
+#include <esp_timer.h>
+#endif
+
+namespace Instrumentation
+{
+    // A sequence of zero means the task has never published.
+    static std::array<ProtectedTypes::SeqLocked<TaskStatistics>, MAXIMUM_TASKS> published;
+
+#ifdef NATIVE
+    static int64_t host_time_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    uint32_t cycle_count()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return static_cast<uint32_t>(__rdtsc());
+#else
+        return static_cast<uint32_t>(host_time_ns());
+#endif
+    }
+
+    // The TSC rate is not exposed to user space, so it is measured once against the monotonic clock.
+    uint32_t cycles_per_microsecond()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        static const uint32_t rate = []() {
+            const auto start_ns = host_time_ns();
+            const auto start_cycles = __rdtsc();
+            while (host_time_ns() - start_ns < 10000000)
+            {
+            }
+            const auto cycles = __rdtsc() - start_cycles;
+            const auto rate = static_cast<uint32_t>(cycles * 1000 / (host_time_ns() - start_ns));
+            return rate ? rate : 1;
+        }();
+        return rate;
+#else
+        return 1000;
+#endif
+    }
+
+    int64_t time_us()
+    {
+        return host_time_ns() / 1000;
+    }
+#else
+    uint32_t cycle_count()
+    {
+        return ESP.getCycleCount();
+    }
+
+    uint32_t cycles_per_microsecond()
+    {
+        return ESP.getCpuFreqMHz();
+    }
+
+    int64_t time_us()
+    {
+        return esp_timer_get_time();
+    }
+#endif
+
+    static size_t histogram_bucket(const uint32_t microseconds)
+    {
+        if (microseconds == 0)
+            return 0;
+        const size_t bucket = 31 - __builtin_clz(microseconds);
+        return (bucket < HISTOGRAM_BUCKETS) ? bucket : HISTOGRAM_BUCKETS - 1;
+    }
+
+    TaskProbe::TaskProbe(const uint8_t task_number, const Units::Microseconds period)
+        : task_number(task_number),
+          period_us(period.count())
+    {
+        statistics.minimum_execution_cycles = UINT32_MAX;
+    }
+
+    void TaskProbe::start(const int64_t release)
+    {
+        start_us = time_us();
+        start_cycles = cycle_count();
+        release_us = (release < start_us) ? release : start_us;
+    }
+
+    void TaskProbe::begin(const int64_t release)
+    {
+        start(release);
+        const auto jitter = static_cast<uint32_t>(start_us - release_us);
+        statistics.total_start_jitter_us += jitter;
+        if (jitter > statistics.maximum_start_jitter_us)
+            statistics.maximum_start_jitter_us = jitter;
+    }
+
+    void TaskProbe::begin_event(const int64_t event_us)
+    {
+        start(event_us);
+    }
+
+    void TaskProbe::end()
+    {
+        const auto execution_cycles = cycle_count() - start_cycles;
+        const auto response_us = time_us() - release_us;
+
+        statistics.activations++;
+        statistics.total_execution_cycles += execution_cycles;
+        if (execution_cycles < statistics.minimum_execution_cycles)
+            statistics.minimum_execution_cycles = execution_cycles;
+        if (execution_cycles > statistics.maximum_execution_cycles)
+            statistics.maximum_execution_cycles = execution_cycles;
+        if (response_us > period_us)
+            statistics.deadline_misses++;
+
+        auto &bucket = statistics.response_histogram[histogram_bucket(static_cast<uint32_t>(response_us))];
+        if (bucket < UINT16_MAX)
+            bucket++;
+
+        if (task_number < MAXIMUM_TASKS)
+            published[task_number].write(statistics);
+    }
+
+    bool query(const uint8_t task_number, TaskStatistics &statistics)
+    {
+        if (task_number >= MAXIMUM_TASKS)
+            return false;
+
+        // As in SignalBus::read_consistent(), yield if a preempted writer keeps overlapping the copy.
+        constexpr size_t ATTEMPTS_BEFORE_YIELDING = 4;
+        const auto &source = published[task_number];
+        for (size_t attempt = 1;; attempt++)
+        {
+            const auto seq = source.begin_read();
+            if (seq == 0)
+                return false;
+            statistics = source.read_unchecked();
+            if (source.validate(seq))
+                return true;
+            if (attempt % ATTEMPTS_BEFORE_YIELDING == 0)
+                vTaskDelay(1);
+        }
+    }
+
+    void dump()
+    {
+        const auto rate = cycles_per_microsecond();
+        for (uint8_t task = 0; task < MAXIMUM_TASKS; task++)
+        {
+            TaskStatistics statistics;
+            if (!query(task, statistics) || statistics.activations == 0)
+                continue;
+
+            const auto misses = statistics.deadline_misses;
+            BinaryLog::log(BinaryLog::RecordType::TaskTiming,
+                           task,
+                           static_cast<int32_t>(statistics.maximum_execution_cycles / rate),
+                           static_cast<int32_t>(statistics.maximum_start_jitter_us),
+                           static_cast<uint16_t>(misses > UINT16_MAX ? UINT16_MAX : misses));
+            BinaryLog::log(BinaryLog::RecordType::TaskTimingMean,
+                           task,
+                           static_cast<int32_t>(statistics.mean_execution_cycles() / rate),
+                           static_cast<int32_t>(statistics.total_start_jitter_us / statistics.activations),
+                           static_cast<uint16_t>(statistics.activations));
+        }
+    }
+}
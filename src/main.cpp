@@ -1,22 +1,20 @@
-#include <Arduino.h>
-#include <Ticker.h>
+#include "platform.hpp"
 
 #include "common.hpp"
+#include "hal.hpp"
+#include "pins.hpp"
+#include "power.hpp"
 #include "tasks.hpp"
 #include "rtos_tasks.hpp"
 #include "task_params.hpp"
+#include "task_registry.hpp"
 
 // Function forward declarations
 void create_rtos_tasks();
 
 // Constant expressions
-// Pins
-constexpr int8_t ANALOGUE_INPUT = 4;
-constexpr int8_t WATCHDOG_OUTPUT = 21;
-constexpr int8_t DIGITAL_INPUT = 19;
-constexpr int8_t ERROR_CODE_LED = 15;
-constexpr int8_t PWM_PIN = 2;
-constexpr int8_t ANALOGUE_MONITOR_DISPLAY_PIN = 22;
+using namespace Pins;
+
 // Task Frequency
 constexpr Hertz DEBUG_RATE_AMPLIFIER = 1;
 constexpr Hertz TASK_2_RATE = 5.0 * DEBUG_RATE_AMPLIFIER;
@@ -28,11 +26,7 @@ constexpr Hertz TASK_7_RATE = 3.0 * DEBUG_RATE_AMPLIFIER;
 constexpr Hertz TASK_8_RATE = 3.0 * DEBUG_RATE_AMPLIFIER;
 constexpr Hertz TASK_9_RATE = 0.2 * DEBUG_RATE_AMPLIFIER;
 
-constexpr int8_t LOW_PRIORITY = 1;
-constexpr int8_t MEDIUM_PRIORITY = 2;
-constexpr int8_t HIGH_PRIORITY = 3;
-
-constexpr Milliseconds TASK_1_PERIOD = 24.4 * DEBUG_RATE_AMPLIFIER;
+constexpr Milliseconds TASK_1_PERIOD = 24.4 / DEBUG_RATE_AMPLIFIER;
 constexpr Milliseconds TASK_2_PERIOD = calculateCyclePeriodMs(TASK_2_RATE);
 constexpr Milliseconds TASK_3_PERIOD = calculateCyclePeriodMs(TASK_3_RATE);
 constexpr Milliseconds TASK_4_PERIOD = calculateCyclePeriodMs(TASK_4_RATE);
@@ -42,98 +36,101 @@ constexpr Milliseconds TASK_7_PERIOD = calculateCyclePeriodMs(TASK_7_RATE);
 constexpr Milliseconds TASK_8_PERIOD = calculateCyclePeriodMs(TASK_8_RATE);
 constexpr Milliseconds TASK_9_PERIOD = calculateCyclePeriodMs(TASK_9_RATE);
 
+constexpr Milliseconds LOG_DRAIN_PERIOD = 50.0;
+
+// Tasks 2 and 8 react to changes instead of polling; their periods are their deadlines.
+constexpr Milliseconds BUTTON_DEBOUNCE = 10.0;
+constexpr size_t SQUARE_WAVE_PERIODS_TO_AVERAGE = 8;
+// One ADC block per Task 4 period. Only the I2S DMA source (ADC1 pins) converts at this rate; the burst
+// source takes its block back to back at each release.
+constexpr Hertz ADC_SAMPLE_RATE = TASK_4_RATE * RtosTasks::ADC_BLOCK_SIZE;
+
+// Task parameters; static so they outlive setup().
+static constexpr TaskParams::TaskParamsWithPulseDuration watchdog_params = {WATCHDOG_OUTPUT, TASK_1_PERIOD, Units::Microseconds(50)};
+static constexpr TaskParams::TaskParamsWithDebounce button_read_params = {DIGITAL_INPUT, TASK_2_PERIOD, BUTTON_DEBOUNCE};
+static constexpr TaskParams::TaskParamsWithMeasurementWindow measure_square_wave_freq_params = {PWM_PIN, TASK_3_PERIOD, SQUARE_WAVE_PERIODS_TO_AVERAGE};
+static constexpr TaskParams::TaskParamsWithSampleRate analogue_read_params = {ANALOGUE_INPUT, TASK_4_PERIOD, ADC_SAMPLE_RATE};
+static constexpr TaskParams::TaskParams filter_analogue_signal_params = {TASK_5_PERIOD};
+static constexpr TaskParams::TaskParams no_op_params = {TASK_6_PERIOD};
+static constexpr TaskParams::TaskParams compute_error_code_params = {TASK_7_PERIOD};
+static constexpr TaskParams::TaskParams visualise_error_code_params = {ERROR_CODE_LED, TASK_8_PERIOD};
+static constexpr TaskParams::TaskParams log_params = {TASK_9_PERIOD};
+static constexpr TaskParams::TaskParamsWithFraming log_drain_params = {LOG_DRAIN_PERIOD, BinaryLog::Framing::Cobs};
+
+// Task table. Priorities are assigned rate-monotonically from the periods and AUTO_CORE tasks are
+// partitioned across the cores by role and utilisation; WCET budgets feed the compile-time per-core
+// utilisation check in TaskRegistry::create_tasks(). Background tasks have no budget: Task 6 sizes its
+// work to the idle time it finds. Task 1's budget and stack are for its software fallback: when the
+// waveform generator starts, the task exits at start-up and drops out of the run-time reports.
+//
+// Stack sizes are estimates, not measurements: no board run has produced high-water marks for this
+// build yet. Each is MemoryProfiler::recommended_stack_bytes() of the deepest call chain from the task
+// function through src/ (GCC -fcallgraph-info=su at -Os on the host; indirect calls not followed) plus
+// 904 bytes for what that cannot see: the Xtensa context frame and coprocessor save area (392) and the
+// deepest FreeRTOS or driver call (512). The log drain adds 1024 for the SPI flash write path. Replace
+// them with tools/stack_table.py output from an ESP32 capture.
+using TaskRegistry::AUTO_CORE;
+using TaskRegistry::Role;
+using TaskRegistry::Scheduling;
+static constexpr std::array<TaskRegistry::TaskDefinition, 10> TASK_TABLE = {{
+    // #  function                                   name         params                             period            WCET(us) stack scheduling                   role                core       handle
+    {1,  RtosTasks::transmit_watchdog_waveform,       "Task 1",    &watchdog_params,                  TASK_1_PERIOD,    100,     1696, Scheduling::RateMonotonic, Role::TimeCritical, AUTO_CORE, nullptr},
+    {2,  RtosTasks::digital_read,                     "Task 2",    &button_read_params,               TASK_2_PERIOD,    50,      1680, Scheduling::RateMonotonic, Role::General,      AUTO_CORE, nullptr},
+    {3,  RtosTasks::measure_square_wave_frequency,    "Task 3",    &measure_square_wave_freq_params,  TASK_3_PERIOD,    50,      1760, Scheduling::RateMonotonic, Role::Blocking,     AUTO_CORE, nullptr},
+    {4,  RtosTasks::analogue_read,                    "Task 4",    &analogue_read_params,             TASK_4_PERIOD,    2000,    1776, Scheduling::RateMonotonic, Role::TimeCritical, AUTO_CORE, nullptr},
+    {5,  RtosTasks::compute_filtered_analogue_signal, "Task 5",    &filter_analogue_signal_params,    TASK_5_PERIOD,    100,     1840, Scheduling::RateMonotonic, Role::General,      AUTO_CORE, nullptr},
+    {6,  RtosTasks::execute_no_op_instruction,        "Task 6",    &no_op_params,                     TASK_6_PERIOD,    0,       2176, Scheduling::Background,    Role::General,      AUTO_CORE, nullptr},
+    {7,  RtosTasks::compute_error_code,               "Task 7",    &compute_error_code_params,        TASK_7_PERIOD,    50,      1856, Scheduling::RateMonotonic, Role::General,      AUTO_CORE, nullptr},
+    {8,  RtosTasks::visualise_error_code,             "Task 8",    &visualise_error_code_params,      TASK_8_PERIOD,    50,      1520, Scheduling::RateMonotonic, Role::General,      AUTO_CORE, nullptr},
+    {9,  RtosTasks::log,                              "Task 9",    &log_params,                       TASK_9_PERIOD,    500,     2144, Scheduling::RateMonotonic, Role::Blocking,     AUTO_CORE, nullptr},
+    {10, RtosTasks::drain_log,                        "Log drain", &log_drain_params,                 LOG_DRAIN_PERIOD, 0,       3568, Scheduling::Background,    Role::Blocking,     AUTO_CORE, nullptr},
+}};
+
+// Pin ownership across the task table, checked at compile time: each output has one owner and no
+// pin is both read and driven. The tasks drive their outputs through the typed pins directly, so the
+// parameters must name the same pins.
+static constexpr std::array<Gpio::Claim, 6> PIN_CLAIMS = {{
+    Gpio::claim<WatchdogOutputPin>(1),
+    Gpio::claim<DigitalInputPin>(2),
+    Gpio::claim<AnalogueMonitorDisplayPin>(2),
+    Gpio::claim<PwmInputPin>(3),
+    Gpio::claim<AnalogueInputPin>(4),
+    Gpio::claim<ErrorCodeLedPin>(8),
+}};
+static_assert(Gpio::claims_conflict_free(PIN_CLAIMS), "Two tasks claim the same pin.");
+static_assert(watchdog_params.pin_id == WatchdogOutputPin::number, "Task 1 drives WatchdogOutputPin.");
+static_assert(button_read_params.pin_id == DigitalInputPin::number, "Task 2 reads DigitalInputPin.");
+static_assert(visualise_error_code_params.pin_id == ErrorCodeLedPin::number, "Task 8 drives ErrorCodeLedPin.");
+
+// Unit tests supply their own setup() and loop(), or main() on the host.
+#ifndef PIO_UNIT_TESTING
 void setup()
 {
-    pinMode(ANALOGUE_INPUT, INPUT);
-    pinMode(WATCHDOG_OUTPUT, OUTPUT);
-    pinMode(DIGITAL_INPUT, INPUT_PULLDOWN);
-    pinMode(PWM_PIN, INPUT);
-    pinMode(ERROR_CODE_LED, OUTPUT);
-    pinMode(ANALOGUE_MONITOR_DISPLAY_PIN, OUTPUT);
+    AnalogueInputPin::configure();
+    WatchdogOutputPin::configure();
+    DigitalInputPin::configure();
+    PwmInputPin::configure();
+    ErrorCodeLedPin::configure();
+    AnalogueMonitorDisplayPin::configure();
 
-    Serial.begin(115200);
+    Hal::get().begin_serial(115200);
+
+    // The stock Arduino-ESP32 core is built without CONFIG_PM_ENABLE, so this fails there and the clock
+    // simply stays fixed; the PowerLevels records say which.
+    Power::begin();
 
     create_rtos_tasks();
 }
+#endif
 
 void create_rtos_tasks()
 {
-    constexpr TaskParams::TaskParamsWithPulseDuration watchdog_params = {WATCHDOG_OUTPUT, TASK_1_PERIOD, 50};
-    xTaskCreate(RtosTasks::transmit_watchdog_waveform,
-                "Task 1",
-                1648,
-                (void *)&watchdog_params,
-                LOW_PRIORITY,
-                NULL);
-
-    constexpr TaskParams::TaskParams button_read_params = {DIGITAL_INPUT, TASK_2_PERIOD};
-    xTaskCreate(RtosTasks::digital_read,
-                "Task 2",
-                1548,
-                (void *)&button_read_params,
-                LOW_PRIORITY,
-                NULL);
-
-    constexpr TaskParams::TaskParams measure_square_wave_freq_params = {PWM_PIN, TASK_3_PERIOD};
-    xTaskCreate(RtosTasks::measure_square_wave_frequency,
-                "Task 3",
-                1900,
-                (void *)&measure_square_wave_freq_params,
-                10,
-                NULL);
-
-    constexpr TaskParams::TaskParams analogue_read_params = {ANALOGUE_INPUT, TASK_4_PERIOD};
-    xTaskCreate(RtosTasks::analogue_read,
-                "Task 4",
-                1450,
-                (void *)&analogue_read_params,
-                LOW_PRIORITY,
-                NULL);
-
-    constexpr TaskParams::TaskParams filter_analogue_signal_params = {TASK_5_PERIOD};
-    xTaskCreate(RtosTasks::compute_filtered_analogue_signal,
-                "Task 5",
-                1448,
-                (void *)&filter_analogue_signal_params,
-                LOW_PRIORITY,
-                NULL);
-
-    constexpr TaskParams::TaskParams no_op_params = {TASK_6_PERIOD};
-    xTaskCreate(RtosTasks::execute_no_op_instruction,
-                "Task 6",
-                1450,
-                (void *)&no_op_params,
-                LOW_PRIORITY,
-                NULL);
-
-    // As Task 7 relies on Task 8's handle being instantiated, Task 7 must be created first.
-    constexpr TaskParams::TaskParams visualise_error_code_params = {ERROR_CODE_LED, TASK_8_PERIOD};
-    TaskHandle_t visualiseHandle = NULL;
-    xTaskCreate(RtosTasks::visualise_error_code,
-                "Task 8",
-                1548,
-                (void *)&visualise_error_code_params,
-                4,
-                &visualiseHandle);
-
-    TaskParams::TaskParamsWithMailbox compute_error_code_params = {ERROR_CODE_LED, TASK_7_PERIOD, {visualiseHandle}};
-    xTaskCreate(RtosTasks::compute_error_code,
-                "Task 7",
-                1500,
-                (void *)&compute_error_code_params,
-                5,
-                NULL);
-
-    constexpr TaskParams::TaskParams log_params = {TASK_9_PERIOD};
-    xTaskCreate(RtosTasks::log,
-                "Task 9",
-                1548,
-                (void *)&log_params,
-                MEDIUM_PRIORITY,
-                NULL);
+    TaskRegistry::create_tasks<TASK_TABLE.size(), TASK_TABLE>();
 }
 
+#if !defined(NATIVE) && !defined(PIO_UNIT_TESTING)
 void loop()
 {
     vTaskDelete(nullptr); // delete Arduino loop(). FreeRTOS tasks are used instead.
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "memory_profiler.hpp"
+
+#include <algorithm>
+
+#include "binary_log.hpp"
+#include "task_registry.hpp"
+
+namespace MemoryProfiler
+{
+    StackUsage stack_usage(const size_t index, const uint32_t margin_percent)
+    {
+        const auto &task = TaskRegistry::registered_task(index);
+        const auto handle = TaskRegistry::handle(index);
+        if (handle == nullptr)
+            return {task.task_number, task.stack_bytes, 0, 0};
+        // The high-water mark is the least free stack ever seen, in words (bytes on the ESP32).
+        const auto never_used = static_cast<uint32_t>(uxTaskGetStackHighWaterMark(handle) * sizeof(StackType_t));
+        const auto peak = task.stack_bytes - std::min(never_used, task.stack_bytes);
+        return {task.task_number, task.stack_bytes, peak, recommended_stack_bytes(peak, margin_percent)};
+    }
+
+    HeapUsage heap_usage()
+    {
+        // Both the ESP-IDF allocator and heap_4 on the host keep these counters.
+        return {xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize()};
+    }
+
+    void report(const uint32_t margin_percent)
+    {
+        for (size_t i = 0; i < TaskRegistry::number_of_registered_tasks(); i++)
+        {
+            if (TaskRegistry::handle(i) == nullptr)
+                continue;
+            const auto usage = stack_usage(i, margin_percent);
+            BinaryLog::log(BinaryLog::RecordType::StackUsage,
+                           usage.task_number,
+                           static_cast<int32_t>(usage.peak_bytes),
+                           static_cast<int32_t>(usage.allocated_bytes),
+                           static_cast<uint16_t>(std::min<uint32_t>(usage.recommended_bytes, UINT16_MAX)));
+        }
+
+        const auto heap = heap_usage();
+        BinaryLog::log(BinaryLog::RecordType::HeapUsage,
+                       0,
+                       static_cast<int32_t>(heap.free_bytes),
+                       static_cast<int32_t>(heap.minimum_free_bytes));
+    }
+}
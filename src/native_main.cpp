@@ -0,0 +1,81 @@
+#ifdef NATIVE
+
+#include <cmath>
+
+#include "platform.hpp"
+
+#include "background.hpp"
+#include "simulated_hal.hpp"
+#include "pins.hpp"
+
+void setup();
+
+#ifndef PIO_UNIT_TESTING
+
+// Stimulus for the simulated board: a push button held for one second in every four that bounces for
+// 2 ms on press and release, a 500 Hz square wave on the PWM input and a slow sine sweep across the
+// full ADC range on the analogue input.
+static void connect_simulated_inputs(Hal::SimulatedHal &hal)
+{
+    constexpr Microseconds BUTTON_CYCLE = 4000000.0;
+    constexpr Microseconds BUTTON_HELD = 1000000.0;
+    constexpr Microseconds BUTTON_BOUNCE = 2000.0;
+    constexpr Microseconds BOUNCE_PERIOD = 250.0;
+    constexpr Hertz SQUARE_WAVE_FREQUENCY = 500.0;
+    constexpr Hertz ANALOGUE_SWEEP_FREQUENCY = 0.1;
+
+    hal.set_digital_source(Pins::DIGITAL_INPUT, [](const Microseconds now) {
+        const auto phase = std::fmod(now, BUTTON_CYCLE);
+        const auto pressed = phase < BUTTON_HELD;
+        const auto since_transition = pressed ? phase : phase - BUTTON_HELD;
+        if (since_transition < BUTTON_BOUNCE && std::fmod(since_transition, BOUNCE_PERIOD) >= BOUNCE_PERIOD / 2.0)
+            return !pressed;
+        return pressed;
+    });
+    hal.set_square_wave(Pins::PWM_PIN, SQUARE_WAVE_FREQUENCY);
+    hal.set_analogue_source(Pins::ANALOGUE_INPUT, [](const Microseconds now) {
+        const auto phase = 2.0 * M_PI * ANALOGUE_SWEEP_FREQUENCY * microsecondsToSeconds(now);
+        const auto half_scale = Hal::SimulatedHal::MAXIMUM_ANALOGUE_VALUE / 2.0;
+        return static_cast<uint16_t>(half_scale + half_scale * std::sin(phase));
+    });
+}
+
+#endif
+
+// Static allocation requires the application to supply the idle and timer task memory.
+extern "C" void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_depth)
+{
+    static StaticTask_t idle_tcb;
+    static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *stack_depth = configMINIMAL_STACK_SIZE;
+}
+
+extern "C" void vApplicationGetTimerTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_depth)
+{
+    static StaticTask_t timer_tcb;
+    static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+    *tcb = &timer_tcb;
+    *stack = timer_stack;
+    *stack_depth = configTIMER_TASK_STACK_DEPTH;
+}
+
+extern "C" void vApplicationIdleHook()
+{
+    Background::on_idle();
+}
+
+// Unit tests supply their own main() and link against everything else in src/.
+#ifndef PIO_UNIT_TESTING
+int main()
+{
+    connect_simulated_inputs(Hal::simulated());
+
+    setup();
+    vTaskStartScheduler();
+    return 0;
+}
+#endif
+
+#endif
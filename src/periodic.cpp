@@ -0,0 +1,190 @@
+#include <cmath>
+
+#include "periodic.hpp"
+#include "instrumentation.hpp"
+
+#ifndef NATIVE
+#include <esp_timer.h>
+#endif
+
+namespace Periodic
+{
+    // Below this the cost of arming a timer and switching tasks exceeds the wait itself.
+    static constexpr int64_t MINIMUM_BLOCKING_WAIT_US = 200;
+
+    static void spin_until(const int64_t time_us)
+    {
+        while (Instrumentation::time_us() < time_us)
+        {
+        }
+    }
+
+#ifdef NATIVE
+    // A POSIX-port task that blocks in the host kernel stalls the whole scheduler, so spin instead.
+    FineTimer::~FineTimer() {}
+
+    void FineTimer::wait_until(const int64_t time_us)
+    {
+        spin_until(time_us);
+    }
+#else
+    static void give_semaphore(void *semaphore)
+    {
+        xSemaphoreGive(static_cast<SemaphoreHandle_t>(semaphore));
+    }
+
+    FineTimer::~FineTimer()
+    {
+        if (timer != nullptr)
+            esp_timer_delete(static_cast<esp_timer_handle_t>(timer));
+        if (semaphore != nullptr)
+            vSemaphoreDelete(static_cast<SemaphoreHandle_t>(semaphore));
+    }
+
+    /**
+     * esp_timer callbacks run in the esp_timer task, which is free to call FreeRTOS APIs. A semaphore
+     * rather than a task notification is used because tasks already use their notification value.
+     */
+    void FineTimer::wait_until(const int64_t time_us)
+    {
+        const auto remaining = time_us - Instrumentation::time_us();
+        if (remaining < MINIMUM_BLOCKING_WAIT_US)
+        {
+            spin_until(time_us);
+            return;
+        }
+
+        if (timer == nullptr)
+        {
+            semaphore = xSemaphoreCreateBinary();
+            esp_timer_create_args_t arguments = {};
+            arguments.callback = &give_semaphore;
+            arguments.arg = semaphore;
+            arguments.name = "fine_wait";
+            esp_timer_handle_t handle;
+            if (semaphore == nullptr || esp_timer_create(&arguments, &handle) != ESP_OK)
+            {
+                if (semaphore != nullptr)
+                    vSemaphoreDelete(static_cast<SemaphoreHandle_t>(semaphore));
+                semaphore = nullptr;
+                spin_until(time_us);
+                return;
+            }
+            timer = handle;
+        }
+
+        esp_timer_start_once(static_cast<esp_timer_handle_t>(timer), static_cast<uint64_t>(remaining));
+        xSemaphoreTake(static_cast<SemaphoreHandle_t>(semaphore), portMAX_DELAY);
+        spin_until(time_us); // absorbs timer dispatch granularity
+    }
+#endif
+
+    // Continued-fraction convergents of the period in microseconds, stopping at the first that is exact
+    // to within a picosecond or before the denominator outgrows MAXIMUM_DENOMINATOR.
+    Period::Period(const Milliseconds period)
+    {
+        const double target = period * 1000.0;
+        if (!(target > 0.0))
+            return;
+
+        int64_t previous_numerator = 1, previous_denominator = 0;
+        numerator = static_cast<int64_t>(std::floor(target));
+        divisor = 1;
+        double remainder = target - std::floor(target);
+        while (remainder > 0.0 && std::fabs(static_cast<double>(numerator) / divisor - target) > 1e-6)
+        {
+            const double next = 1.0 / remainder;
+            const auto term = static_cast<int64_t>(std::floor(next));
+            const auto next_numerator = term * numerator + previous_numerator;
+            const auto next_denominator = term * divisor + previous_denominator;
+            if (next_denominator > MAXIMUM_DENOMINATOR)
+                break;
+            previous_numerator = numerator;
+            previous_denominator = divisor;
+            numerator = next_numerator;
+            divisor = next_denominator;
+            remainder = next - std::floor(next);
+        }
+    }
+
+    int64_t Period::offset_us(const uint64_t index) const
+    {
+        return static_cast<int64_t>((index * static_cast<uint64_t>(numerator) + static_cast<uint64_t>(divisor / 2)) /
+                                    static_cast<uint64_t>(divisor));
+    }
+
+    uint64_t Period::index_at(const int64_t offset) const
+    {
+        if (offset <= 0 || numerator == 0)
+            return 0;
+        auto index = static_cast<uint64_t>(offset) * static_cast<uint64_t>(divisor) / static_cast<uint64_t>(numerator);
+        while (offset_us(index + 1) <= offset) // rounding in offset_us() can put the next one half a microsecond early
+            index++;
+        while (index > 0 && offset_us(index) > offset)
+            index--;
+        return index;
+    }
+
+    Schedule::Schedule(const Milliseconds period, Power::Client *power, const Precision precision)
+        : period(period), precision(precision), power(power) {}
+
+    // Release 0 is put on a tick edge, so the tick a Precision::Tick release waits for is never early.
+    void Schedule::start()
+    {
+        vTaskDelay(1);
+        origin_us = Instrumentation::time_us();
+        origin_tick = xTaskGetTickCount();
+        last_wake_tick = origin_tick;
+        release_index = 0;
+        started = true;
+    }
+
+    int64_t Schedule::release_time(const uint64_t index) const
+    {
+        return origin_us + period.offset_us(index);
+    }
+
+    void Schedule::delay_until_tick(const TickType_t tick)
+    {
+        if (static_cast<int32_t>(tick - last_wake_tick) > 0 && static_cast<int32_t>(tick - xTaskGetTickCount()) > 0)
+            vTaskDelayUntil(&last_wake_tick, tick - last_wake_tick);
+        else
+            last_wake_tick = xTaskGetTickCount();
+    }
+
+    void Schedule::wait_next_release()
+    {
+        if (!started)
+            start();
+
+        release_index++;
+        const auto now = Instrumentation::time_us();
+        if (now >= release_time(release_index + 1))
+        {
+            // Overran by at least one whole period: resynchronise to the latest release in the past.
+            const auto behind = period.index_at(now - origin_us);
+            skipped += static_cast<uint32_t>(behind - release_index);
+            release_index = behind;
+        }
+
+        const auto release = release_time(release_index);
+        if (power != nullptr)
+            power->sleep_until(release);
+
+        delay_until_tick(origin_tick + release_ticks(release - origin_us, precision));
+        if (precision == Precision::SubTick)
+            fine_timer.wait_until(release);
+        if (power != nullptr)
+            power->awake(release);
+    }
+
+    int64_t Schedule::release_us() const
+    {
+        return release_time(release_index);
+    }
+
+    uint32_t Schedule::skipped_releases() const
+    {
+        return skipped;
+    }
+}
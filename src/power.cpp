@@ -0,0 +1,202 @@
+#include "power.hpp"
+
+#include <algorithm>
+
+#include "binary_log.hpp"
+#include "instrumentation.hpp"
+
+#ifndef NATIVE
+#include <esp_pm.h>
+#endif
+
+namespace Power
+{
+    namespace
+    {
+        constexpr size_t MAXIMUM_CLIENTS = 8;
+
+        Settings settings = DEFAULT_SETTINGS;
+        std::atomic<bool> enabled{false};
+        std::array<std::atomic<Client *>, MAXIMUM_CLIENTS> clients;
+
+        // Policy state, serialised by the mutex, as clients on both cores change it.
+        StaticSemaphore_t mutex_buffer;
+        SemaphoreHandle_t mutex = nullptr;
+        Level current_level = Level::Scaled;
+        int64_t level_since_us = 0;
+        std::array<uint64_t, NUMBER_OF_LEVELS> time_at_level_us = {};
+
+#ifndef NATIVE
+        esp_pm_lock_handle_t full_speed_lock = nullptr;
+        esp_pm_lock_handle_t no_light_sleep_lock = nullptr;
+        bool holding_full_speed = false;
+        bool holding_no_light_sleep = false;
+
+        void hold(const esp_pm_lock_handle_t lock, bool &holding, const bool wanted)
+        {
+            if (wanted == holding)
+                return;
+            if (wanted)
+                esp_pm_lock_acquire(lock);
+            else
+                esp_pm_lock_release(lock);
+            holding = wanted;
+        }
+#endif
+
+        void switch_to(const Level level)
+        {
+#ifdef NATIVE
+            static_cast<void>(level); // the host clock cannot be changed; only the accounting runs
+#else
+            hold(full_speed_lock, holding_full_speed, level == Level::FullSpeed);
+            hold(no_light_sleep_lock, holding_no_light_sleep, level != Level::LightSleep);
+#endif
+        }
+
+        // Called with the mutex held.
+        void account(const int64_t now_us)
+        {
+            time_at_level_us[static_cast<size_t>(current_level)] += static_cast<uint64_t>(now_us - level_since_us);
+            level_since_us = now_us;
+        }
+
+        void apply()
+        {
+            if (!enabled.load(std::memory_order_acquire))
+                return;
+
+            // The scan is inside the mutex too: a client on the other core that changes between the scan
+            // and the switch would otherwise have its change overwritten by this stale view.
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            uint32_t busy_clients = 0;
+            int64_t next_sensitive_release_us = INT64_MAX;
+            for (const auto &slot : clients)
+            {
+                const auto client = slot.load(std::memory_order_acquire);
+                if (client == nullptr || !client->latency_sensitive)
+                    continue;
+                if (client->is_busy())
+                    busy_clients++;
+                else
+                    next_sensitive_release_us = std::min(next_sensitive_release_us, client->next_release());
+            }
+            const auto now = Instrumentation::time_us();
+            const auto wanted = level(settings, busy_clients, now, next_sensitive_release_us);
+            account(now);
+            if (wanted != current_level)
+            {
+                switch_to(wanted);
+                current_level = wanted;
+            }
+            xSemaphoreGive(mutex);
+        }
+    }
+
+    bool begin(const Settings &new_settings)
+    {
+        settings = new_settings;
+#ifndef NATIVE
+        esp_pm_config_esp32_t config = {};
+        config.max_freq_mhz = settings.maximum_mhz;
+        config.min_freq_mhz = settings.minimum_mhz;
+        config.light_sleep_enable = settings.light_sleep;
+        if (esp_pm_configure(&config) != ESP_OK ||
+            esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "sensitive", &full_speed_lock) != ESP_OK ||
+            esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "release", &no_light_sleep_lock) != ESP_OK)
+            return false;
+#endif
+        mutex = xSemaphoreCreateMutexStatic(&mutex_buffer);
+        current_level = Level::Scaled;
+        switch_to(current_level);
+        level_since_us = Instrumentation::time_us();
+        enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    bool active()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    Client::Client(const uint8_t task_number, const bool latency_sensitive)
+        : task_number(task_number), latency_sensitive(latency_sensitive)
+    {
+        for (auto &slot : clients)
+        {
+            Client *expected = nullptr;
+            if (slot.compare_exchange_strong(expected, this, std::memory_order_release))
+                return;
+        }
+    }
+
+    void Client::awake(const int64_t release_us)
+    {
+        const auto late = std::max<int64_t>(0, Instrumentation::time_us() - release_us);
+        latency.wakes++;
+        latency.maximum_us = std::max(latency.maximum_us, static_cast<uint32_t>(late));
+        latency.total_us += static_cast<uint64_t>(late);
+        published.write(latency);
+
+        if (!latency_sensitive)
+            return;
+        busy.store(true, std::memory_order_relaxed);
+        apply();
+    }
+
+    void Client::sleep_until(const int64_t release_us)
+    {
+        if (!latency_sensitive)
+            return;
+        next_release_us.store(release_us, std::memory_order_relaxed);
+        busy.store(false, std::memory_order_relaxed);
+        apply();
+    }
+
+    bool Client::wake_latency(WakeLatency &latency_out) const
+    {
+        for (;;)
+        {
+            const auto seq = published.begin_read();
+            latency_out = published.read_unchecked();
+            if (published.validate(seq))
+                return latency_out.wakes > 0;
+        }
+    }
+
+    void report()
+    {
+        std::array<uint64_t, NUMBER_OF_LEVELS> time_us = {};
+        if (enabled.load(std::memory_order_acquire))
+        {
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            account(Instrumentation::time_us());
+            time_us = time_at_level_us;
+            xSemaphoreGive(mutex);
+        }
+        uint64_t total_us = 0;
+        for (const auto time : time_us)
+            total_us += time;
+        const auto share = [total_us](const uint64_t time) {
+            return total_us ? static_cast<int32_t>(time * 10000 / total_us) : 0;
+        };
+        BinaryLog::log(BinaryLog::RecordType::PowerLevels,
+                       0,
+                       share(time_us[static_cast<size_t>(Level::FullSpeed)]),
+                       share(time_us[static_cast<size_t>(Level::LightSleep)]),
+                       active());
+
+        for (const auto &slot : clients)
+        {
+            const auto client = slot.load(std::memory_order_acquire);
+            WakeLatency latency;
+            if (client == nullptr || !client->wake_latency(latency))
+                continue;
+            BinaryLog::log(BinaryLog::RecordType::WakeLatency,
+                           client->task_number,
+                           static_cast<int32_t>(latency.maximum_us),
+                           static_cast<int32_t>(latency.total_us / latency.wakes),
+                           static_cast<uint16_t>(latency.wakes));
+        }
+    }
+}
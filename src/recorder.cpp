@@ -0,0 +1,414 @@
+#include "recorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "hal.hpp"
+
+namespace Recorder
+{
+    namespace
+    {
+        constexpr uint32_t MAGIC = 0x314D4C54; // "TLM1"
+        constexpr uint8_t ERASED_TYPE = 0xFF;
+
+        constexpr size_t header_offset(const size_t sector)
+        {
+            return sector * Flash::SECTOR_SIZE;
+        }
+
+        void put_time(uint8_t *destination, const int64_t time)
+        {
+            for (size_t i = 0; i < sizeof(time); i++)
+                destination[i] = static_cast<uint8_t>(static_cast<uint64_t>(time) >> (8 * i));
+        }
+
+        int64_t get_time(const uint8_t *source)
+        {
+            uint64_t time = 0;
+            for (size_t i = 0; i < sizeof(time); i++)
+                time |= static_cast<uint64_t>(source[i]) << (8 * i);
+            return static_cast<int64_t>(time);
+        }
+    }
+
+    Recorder::Recorder(Flash::Flash *flash, const Settings &settings) : flash(flash), settings(settings)
+    {
+        first_times.fill(UNUSED);
+    }
+
+    bool Recorder::mount()
+    {
+        if (flash == nullptr)
+            return false;
+        sectors = std::min(flash->size() / Flash::SECTOR_SIZE, MAXIMUM_SECTORS);
+        if (sectors < 2)
+            return false;
+
+        SectorHeader newest_header = {};
+        for (size_t sector = 0; sector < sectors; sector++)
+        {
+            SectorHeader candidate;
+            if (!flash->read(header_offset(sector), &candidate, sizeof(candidate)) || candidate.magic != MAGIC)
+                continue;
+            first_times[sector] = candidate.first_time_us;
+            counters.highest_erase_count = std::max(counters.highest_erase_count, candidate.erase_count);
+            if (newest == NO_SECTOR || candidate.sequence > newest_header.sequence)
+            {
+                newest = sector;
+                newest_header = candidate;
+            }
+        }
+
+        // Carry recorder time on from the newest record.
+        if (newest != NO_SECTOR)
+        {
+            int64_t end_us = newest_header.first_time_us;
+            std::array<BinaryLog::Record, SLOTS_PER_PAGE> page;
+            for (size_t slot = 0; slot < SLOTS_PER_SECTOR; slot += SLOTS_PER_PAGE)
+            {
+                if (!flash->read(header_offset(newest) + slot * SLOT_SIZE, page.data(), Flash::PAGE_SIZE))
+                    break;
+                const auto first = (slot == 0) ? HEADER_SLOTS : 0;
+                const auto end = std::find_if(page.begin() + first, page.end(), [](const BinaryLog::Record &record) {
+                    return static_cast<uint8_t>(record.type) == ERASED_TYPE;
+                });
+                if (end != page.begin() + first)
+                    end_us = newest_header.first_time_us + static_cast<int32_t>((end - 1)->timestamp - newest_header.first_timestamp);
+                if (end != page.end())
+                    break;
+            }
+            time_offset_us = end_us + 1;
+            next_sequence = newest_header.sequence + 1;
+
+            // Sequences rise from the oldest sector to the newest. A sector out of step, or without a
+            // header, is one whose erase or header program failed; it becomes a hole.
+            uint32_t previous_sequence = 0;
+            int64_t previous_time = UNUSED;
+            for (size_t logical = 0; logical < sectors; logical++)
+            {
+                const auto sector = physical((newest + 1) % sectors, logical);
+                SectorHeader candidate;
+                if (first_times[sector] != UNUSED && flash->read(header_offset(sector), &candidate, sizeof(candidate)) &&
+                    (previous_time == UNUSED || candidate.sequence > previous_sequence))
+                {
+                    previous_sequence = candidate.sequence;
+                    previous_time = first_times[sector];
+                }
+                else
+                {
+                    first_times[sector] = previous_time;
+                }
+            }
+        }
+
+        counters.sectors = static_cast<uint32_t>(sectors);
+        mounted = true;
+        return true;
+    }
+
+    int64_t Recorder::recorder_time(const uint32_t timestamp)
+    {
+        since_boot_us = timestamps_seen ? since_boot_us + static_cast<int32_t>(timestamp - last_timestamp) : timestamp;
+        last_timestamp = timestamp;
+        timestamps_seen = true;
+        return time_offset_us + since_boot_us;
+    }
+
+    bool Recorder::start_sector(const uint32_t timestamp, const int64_t time)
+    {
+        // The next sector is the oldest, so erasing it drops the oldest records.
+        const auto sector = (newest == NO_SECTOR) ? 0 : (newest + 1) % sectors;
+        SectorHeader previous;
+        const auto erase_count = (flash->read(header_offset(sector), &previous, sizeof(previous)) && previous.magic == MAGIC)
+                                     ? previous.erase_count + 1
+                                     : 1;
+
+        // Until its header is written the sector is a hole, which takes the previous sector's first
+        // time so the index stays sorted. A sector that fails is left as one and the next is used.
+        first_times[sector] = (newest == NO_SECTOR) ? UNUSED : first_times[newest];
+        newest = sector;
+        current = NO_SECTOR;
+        counters.erases++;
+        counters.highest_erase_count = std::max(counters.highest_erase_count, erase_count);
+        last_erase_time = time;
+        const auto erase_start = Hal::get().micros();
+        const auto erased = flash->erase_sector(sector);
+        const auto erase_us = (Hal::get().micros() - erase_start).count();
+        counters.longest_erase_us = std::max(counters.longest_erase_us, erase_us);
+        counters.total_erase_us += erase_us;
+        if (!erased)
+            return false;
+
+        header = {MAGIC, next_sequence++, erase_count, timestamp, time, {UINT32_MAX, UINT32_MAX}};
+        if (!flash->program(header_offset(sector), &header, sizeof(header)))
+            return false;
+
+        first_times[sector] = time;
+        current = sector;
+        next_slot = HEADER_SLOTS;
+        programmed_slot = HEADER_SLOTS;
+        return true;
+    }
+
+    void Recorder::append(const BinaryLog::Record &record)
+    {
+        if (!mounted)
+        {
+            counters.records_lost++;
+            return;
+        }
+        const auto time = recorder_time(record.timestamp);
+        if (settings.excluded_types & record_type_bit(record.type))
+            return;
+
+        if (current == NO_SECTOR || next_slot == SLOTS_PER_SECTOR || time - header.first_time_us >= MAXIMUM_SECTOR_SPAN_US)
+        {
+            flush();
+            if (last_erase_time != UNUSED && time - last_erase_time < settings.minimum_erase_interval_us)
+            {
+                if (unreported_shed++ == 0)
+                    first_shed_time = time;
+                counters.records_lost++;
+                counters.records_shed++;
+                return;
+            }
+            if (!start_sector(record.timestamp, time))
+            {
+                counters.records_lost++;
+                return;
+            }
+        }
+
+        // A fresh sector has room for both, so exports show the gap where it happened.
+        if (unreported_shed > 0)
+        {
+            const auto span = std::min<int64_t>(time - first_shed_time, INT32_MAX);
+            store({record.timestamp, BinaryLog::RecordType::RecordsShed, 10, 0, static_cast<int32_t>(unreported_shed), static_cast<int32_t>(span)},
+                  time);
+            unreported_shed = 0;
+        }
+        store(record, time);
+    }
+
+    void Recorder::store(const BinaryLog::Record &record, const int64_t time)
+    {
+        if (next_slot == programmed_slot)
+            pending_since_us = time;
+        pending[next_slot - programmed_slot] = record;
+        next_slot++;
+
+        if (next_slot % SLOTS_PER_PAGE == 0 || time - pending_since_us >= settings.flush_interval_us)
+            flush();
+    }
+
+    void Recorder::sink(void *context, const BinaryLog::Record &record)
+    {
+        static_cast<Recorder *>(context)->append(record);
+    }
+
+    void Recorder::flush()
+    {
+        if (current == NO_SECTOR || next_slot == programmed_slot)
+            return;
+        // Pending records never cross a page, and NOR flash lets the rest of a partly programmed page
+        // be programmed later.
+        const auto count = static_cast<uint32_t>(next_slot - programmed_slot);
+        if (flash->program(header_offset(current) + programmed_slot * SLOT_SIZE, pending.data(), count * SLOT_SIZE))
+            counters.records_stored += count;
+        else
+            counters.records_lost += count;
+        programmed_slot = next_slot;
+    }
+
+    void Recorder::flush_if_due()
+    {
+        if (next_slot == programmed_slot)
+            return;
+        // Measured on the clock BinaryLog stamps records with.
+        const auto now = Hal::get().micros().count();
+        const auto now_us = time_offset_us + since_boot_us + static_cast<int32_t>(now - last_timestamp);
+        if (now_us - pending_since_us >= settings.flush_interval_us)
+            flush();
+    }
+
+    size_t Recorder::physical(const size_t oldest, const size_t logical) const
+    {
+        return (oldest + logical) % sectors;
+    }
+
+    // The number of logical positions, from the start, with a first time before time (or at it, if
+    // inclusive).
+    size_t Recorder::sectors_before(const size_t oldest, const int64_t time, const bool inclusive) const
+    {
+        size_t low = 0;
+        size_t high = sectors;
+        while (low < high)
+        {
+            const auto middle = low + (high - low) / 2;
+            const auto first_time = first_times[physical(oldest, middle)];
+            if (first_time < time || (inclusive && first_time == time))
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    // The logical position of the last sector starting at or before time, or 0. Sectors never written
+    // are all at the start, marked UNUSED, and holes repeat the first time of the sector before them,
+    // so the first times are sorted; the first of a run of equal times is the sector itself.
+    size_t Recorder::first_sector_at(const size_t oldest, const int64_t time) const
+    {
+        const auto after = sectors_before(oldest, time, true);
+        return (after == 0) ? 0 : sectors_before(oldest, first_times[physical(oldest, after - 1)], false);
+    }
+
+    void Recorder::begin_export(const int64_t from_us, const int64_t to_us)
+    {
+        flush();
+        export_state = {};
+        export_state.sector = NO_SECTOR;
+        if (!mounted || newest == NO_SECTOR)
+        {
+            export_state.active = true;
+            export_state.next = sectors; // straight to the end marker
+            return;
+        }
+        export_state.active = true;
+        export_state.oldest = (newest + 1) % sectors;
+        export_state.next = first_sector_at(export_state.oldest, from_us);
+        export_state.last_sequence = next_sequence - 1;
+        export_state.from_us = from_us;
+        export_state.to_us = to_us;
+    }
+
+    void Recorder::send_export_packet(uint8_t *packet, const size_t records, const BinaryLog::Framing framing)
+    {
+        packet[0] = BinaryLog::EXPORT_PACKET_VERSION;
+        packet[1] = static_cast<uint8_t>(records);
+        packet[2] = static_cast<uint8_t>(export_state.packet_sequence);
+        packet[3] = static_cast<uint8_t>(export_state.packet_sequence >> 8);
+        export_state.packet_sequence++;
+        BinaryLog::send_packet(packet, BinaryLog::EXPORT_PACKET_HEADER_SIZE + records * SLOT_SIZE, framing);
+    }
+
+    // Moves the export on to the next sector it covers, false once there is none. Skips sectors never
+    // written and holes, whose headers are missing or do not match the index; stops at one started
+    // after the export began, which means the writer has come round to where the export is.
+    bool Recorder::next_export_sector()
+    {
+        auto &header = export_state.header;
+        for (; export_state.next < sectors; export_state.next++)
+        {
+            const auto sector = physical(export_state.oldest, export_state.next);
+            if (first_times[sector] == UNUSED || !flash->read(header_offset(sector), &header, sizeof(header)) ||
+                header.magic != MAGIC || header.first_time_us != first_times[sector])
+                continue;
+            if (header.sequence > export_state.last_sequence || header.first_time_us > export_state.to_us)
+                return false;
+            export_state.next++;
+            export_state.sector = sector;
+            export_state.slot = HEADER_SLOTS;
+            return true;
+        }
+        return false;
+    }
+
+    void Recorder::export_step(const BinaryLog::Framing framing, const size_t maximum_records)
+    {
+        static uint8_t packet[BinaryLog::MAXIMUM_PACKET_SIZE];
+        if (!export_state.active)
+            return;
+
+        const auto &header = export_state.header;
+        size_t records = 0;
+        size_t remaining = maximum_records;
+        std::array<BinaryLog::Record, SLOTS_PER_PAGE> page;
+        while (remaining > 0)
+        {
+            // The decoder extends a packet's timestamps from its first, so a packet holds one sector's.
+            if (export_state.sector == NO_SECTOR && records > 0)
+            {
+                send_export_packet(packet, records, framing);
+                records = 0;
+            }
+            // A sector restarted since the last step has been overwritten under the export.
+            const auto overwritten = export_state.sector != NO_SECTOR && first_times[export_state.sector] != header.first_time_us;
+            if (overwritten || (export_state.sector == NO_SECTOR && !next_export_sector()))
+            {
+                if (records > 0)
+                    send_export_packet(packet, records, framing);
+                send_export_packet(packet, 0, framing);
+                export_state.active = false;
+                return;
+            }
+
+            const auto page_slot = export_state.slot - export_state.slot % SLOTS_PER_PAGE;
+            if (!flash->read(header_offset(export_state.sector) + page_slot * SLOT_SIZE, page.data(), Flash::PAGE_SIZE))
+            {
+                export_state.sector = NO_SECTOR;
+                continue;
+            }
+            for (; export_state.slot < page_slot + SLOTS_PER_PAGE && remaining > 0; export_state.slot++)
+            {
+                const auto &record = page[export_state.slot - page_slot];
+                if (static_cast<uint8_t>(record.type) == ERASED_TYPE)
+                {
+                    export_state.sector = NO_SECTOR;
+                    break;
+                }
+                const auto time = header.first_time_us + static_cast<int32_t>(record.timestamp - header.first_timestamp);
+                if (time < export_state.from_us || time > export_state.to_us)
+                    continue;
+
+                // Each packet carries the recorder time of its first record; the decoder extends the
+                // others' timestamps from it.
+                if (records == 0)
+                    put_time(&packet[BinaryLog::LIVE_PACKET_HEADER_SIZE], time);
+                memcpy(&packet[BinaryLog::EXPORT_PACKET_HEADER_SIZE + records * SLOT_SIZE], &record, SLOT_SIZE);
+                remaining--;
+                if (++records == BinaryLog::RECORDS_PER_PACKET)
+                {
+                    send_export_packet(packet, records, framing);
+                    records = 0;
+                }
+            }
+            if (export_state.slot == SLOTS_PER_SECTOR)
+                export_state.sector = NO_SECTOR;
+        }
+        if (records > 0)
+            send_export_packet(packet, records, framing);
+    }
+
+    Metrics Recorder::metrics() const
+    {
+        auto metrics = counters;
+        metrics.programs = (flash != nullptr) ? flash->statistics().programs : 0;
+        return metrics;
+    }
+
+    bool CommandParser::feed(const uint8_t byte)
+    {
+        if (length == 0 && byte != 'X' && byte != 'R')
+            return false; // not the start of a command
+        buffer[length++] = byte;
+
+        if (buffer[0] == 'X')
+        {
+            from_us = INT64_MIN;
+            to_us = INT64_MAX;
+        }
+        else if (length == buffer.size())
+        {
+            from_us = get_time(&buffer[1]);
+            to_us = get_time(&buffer[1 + sizeof(int64_t)]);
+        }
+        else
+        {
+            return false;
+        }
+        length = 0;
+        return true;
+    }
+}
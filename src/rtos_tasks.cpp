@@ -1,174 +1,334 @@
 
-#include <Arduino.h>
+#include "platform.hpp"
+
+#include <algorithm>
 
 #include "rtos_tasks.hpp"
 #include "task_params.hpp"
 #include "tasks.hpp"
 #include "common.hpp"
+#include "background.hpp"
+#include "benchmark.hpp"
+#include "binary_log.hpp"
+#include "block_pool.hpp"
+#include "digital_input.hpp"
+#include "hal.hpp"
+#include "instrumentation.hpp"
+#include "memory_profiler.hpp"
+#include "periodic.hpp"
+#include "power.hpp"
+#include "signals.hpp"
+#include "pins.hpp"
+#include "recorder.hpp"
+#include "task_registry.hpp"
+#include "waveform.hpp"
 namespace RtosTasks
 {
 
-    static auto data_to_log = ProtectedTypes::DataToLog();
+    // Task 4 -> Task 5 -> Task 7. Blocks travel by pointer; consumers always see the latest one.
+    static BlockPool::BlockPool<SampleBlock, SAMPLE_BLOCKS> sample_blocks;
+    static BlockPool::Channel<SampleBlock, SAMPLE_BLOCKS> analogue_readings_channel(sample_blocks);
+    static BlockPool::Channel<SampleBlock, SAMPLE_BLOCKS> filtered_analogue_channel(sample_blocks);
 
-    static constexpr size_t QUEUE_SIZE = 5;
-    static QueueHandle_t avg_analogue_readings = xQueueCreate(QUEUE_SIZE,
-                                                              sizeof(double));
-    static QueueHandle_t analogue_readings_queue = xQueueCreate(1,
-                                                                sizeof(std::array<uint16_t, Tasks::NUMBER_OF_ANALOGUE_READINGS>));
+    // Packs the readings four to a record, as AnalogueReadings records carry up to four uint16_t values.
+    template <size_t NUMBER_OF_READINGS>
+    static void log_analogue_readings(const std::array<uint16_t, NUMBER_OF_READINGS> &readings)
+    {
+        for (size_t i = 0; i < NUMBER_OF_READINGS; i += 4)
+        {
+            std::array<uint16_t, 4> packed = {};
+            size_t count = 0;
+            for (; count < 4 && i + count < NUMBER_OF_READINGS; count++)
+                packed[count] = readings[i + count];
+            BinaryLog::log(BinaryLog::RecordType::AnalogueReadings,
+                           4,
+                           static_cast<int32_t>(packed[0] | (static_cast<uint32_t>(packed[1]) << 16)),
+                           static_cast<int32_t>(packed[2] | (static_cast<uint32_t>(packed[3]) << 16)),
+                           static_cast<uint16_t>(count));
+        }
+    }
 
     void transmit_watchdog_waveform(void *params)
     {
         const auto p = *(TaskParams::TaskParamsWithPulseDuration *)params;
 
+        // Once the hardware generator is running the waveform needs no CPU time, so the task exits.
+        if (Waveform::create_generator().start(p.pin_id, p.task_period_us, p.pulse_duration))
+            TaskRegistry::exit_current_task();
+
+        // Software fallback.
+        const auto pulse_duration_us = static_cast<int64_t>(p.pulse_duration.count());
+        Instrumentation::TaskProbe probe(1, p.task_period_us);
+        Power::Client power(1, true); // the pulse must not be stretched by a slow clock
+        Periodic::Schedule schedule(p.task_period, &power, Periodic::Precision::SubTick); // 24.4 ms is not whole ticks
+        Periodic::FineTimer pulse_timer;
+        schedule.start();
+
         for (;;)
         {
-            Tasks::start_pulse(p.pin_id);
-            delayMicroseconds(static_cast<uint32_t>(p.pulse_duration)); // investigate delaying for microseconds
-            Tasks::stop_pulse(p.pin_id);
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.begin(schedule.release_us());
+            Tasks::start_pulse<Pins::WatchdogOutputPin>();
+            pulse_timer.wait_until(schedule.release_us() + pulse_duration_us);
+            Tasks::stop_pulse<Pins::WatchdogOutputPin>();
+            probe.end();
+            schedule.wait_next_release();
         }
     }
     void digital_read(void *params)
     {
-        const auto p = *(TaskParams::TaskParams *)params;
-        constexpr auto WAIT_TIME = 10.0;
+        const auto p = *(TaskParams::TaskParamsWithDebounce *)params;
+        auto &hal = Hal::get();
+        auto &inputs = DigitalInput::dispatcher();
+
+        // Event driven: the task only wakes when the debounced input changes. The period is kept as
+        // the deadline for reacting to a change.
+        Instrumentation::TaskProbe probe(2, p.task_period_us);
+        const auto bit = inputs.watch(p.pin_id, p.debounce, xTaskGetCurrentTaskHandle());
+        Signals::digital_input.publish(Tasks::digital_read<Pins::DigitalInputPin>());
+
         for (;;)
         {
-            constexpr int8_t MONITOR_DISPLAY_PIN = 22;
-            digitalWrite(MONITOR_DISPLAY_PIN, HIGH);
-            const auto button_pressed = Tasks::digital_read(p.pin_id);
-            data_to_log.set_digital_input_state(button_pressed, period_to_number_of_ticks_to_sleep(WAIT_TIME));
+            uint32_t notified = 0;
+            DigitalInput::Event event;
+            if (!xTaskNotifyWait(0, bit, &notified, portMAX_DELAY) || !(notified & bit) || !inputs.latest(p.pin_id, event))
+                continue;
 
-            digitalWrite(MONITOR_DISPLAY_PIN, LOW);
+            const auto detection_latency = hal.micros().count() - event.timestamp;
+            probe.begin_event(Instrumentation::time_us() - detection_latency);
+            Pins::AnalogueMonitorDisplayPin::set();
 
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            Signals::digital_input.publish(event.level);
+            BinaryLog::log(BinaryLog::RecordType::DigitalInput,
+                           2,
+                           event.level,
+                           static_cast<int32_t>(detection_latency),
+                           static_cast<uint16_t>(event.edges));
+
+            Pins::AnalogueMonitorDisplayPin::clear();
+            probe.end();
         }
     }
 
     void measure_square_wave_frequency(void *params)
     {
-        const auto p = *(TaskParams::TaskParams *)params;
-        constexpr auto ticks_to_wait = period_to_number_of_ticks_to_sleep(1000.0);
+        const auto p = *(TaskParams::TaskParamsWithMeasurementWindow *)params;
+        static Tasks::SquareWaveCapture capture;
+        capture.attach(p.pin_id);
+
+        Instrumentation::TaskProbe probe(3, p.task_period_us);
+        Power::Client power(3, false);
+        Periodic::Schedule schedule(p.task_period, &power);
+        schedule.start();
 
         for (;;)
         {
-            const auto freq = Tasks::measure_square_wave_frequency(p.pin_id);
-            data_to_log.set_square_wave_frequency(freq, ticks_to_wait);
+            probe.begin(schedule.release_us());
+            const auto freq = Tasks::measure_square_wave_frequency(capture, p.number_of_periods);
+            Signals::square_wave_frequency.publish(freq);
+            BinaryLog::log(BinaryLog::RecordType::SquareWaveFrequency, 3, static_cast<int32_t>(freq.count()));
 
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.end();
+            schedule.wait_next_release();
         }
     }
     void analogue_read(void *params)
     {
-        const auto p = *(TaskParams::TaskParams *)params;
-        static size_t analogue_index = 0;
-        std::array<uint16_t, Tasks::NUMBER_OF_ANALOGUE_READINGS> analogue_readings = {0, 0, 0, 0};
+        const auto p = *(TaskParams::TaskParamsWithSampleRate *)params;
+        auto &source = AdcSampler::create_block_source(p.pin_id, p.sample_rate);
+        AdcSampler::Decimator<ADC_OVERSAMPLING> decimator;
+        static std::array<uint16_t, ADC_BLOCK_SIZE> block;
+        size_t analogue_index = 0;
+        SampleBlock *sample_block = nullptr;
+
+        const auto block_timeout = Units::ticks(Units::microseconds(p.task_period * 2.0));
+        Instrumentation::TaskProbe probe(4, p.task_period_us);
+        Power::Client power(4, true); // held awake from each release until the block is published
+        // Blocks evenly spaced to the microsecond, rather than 41 or 42 ticks apart.
+        Periodic::Schedule schedule(p.task_period, &power, Periodic::Precision::SubTick);
+        schedule.start();
 
         for (;;)
         {
-            analogue_readings[analogue_index] = Tasks::analogue_read(p.pin_id);
-            analogue_index = (analogue_index + 1) % Tasks::NUMBER_OF_ANALOGUE_READINGS; // circually increment counter
-            xQueueOverwrite(analogue_readings_queue, (void *)&analogue_readings);
-
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.begin(schedule.release_us());
+            const auto captured_us = Instrumentation::time_us();
+            const auto number_of_samples = Tasks::analogue_read(source,
+                                                                block.data(),
+                                                                block.size(),
+                                                                block_timeout);
+            decimator.process(block.data(), number_of_samples, [&](const uint16_t reading) {
+                if (sample_block == nullptr)
+                    sample_block = sample_blocks.acquire();
+                if (sample_block == nullptr)
+                    return; // every block is still held downstream; drop this reading
+                sample_block->readings[analogue_index] = reading;
+                if (++analogue_index == READINGS_PER_BLOCK)
+                {
+                    log_analogue_readings(sample_block->readings);
+                    sample_block->captured_us = captured_us;
+                    analogue_readings_channel.publish(sample_block);
+                    sample_block = nullptr;
+                    analogue_index = 0;
+                }
+            });
+            probe.end();
+            schedule.wait_next_release();
         }
     }
     void compute_filtered_analogue_signal(void *params)
     {
         const auto p = *(TaskParams::TaskParams *)params;
         constexpr auto ticks_to_wait = period_to_number_of_ticks_to_sleep(100.0);
-        bool isQueueFull = false;
+        static AnalogueFilter filter;
+        static AnalogueStatistics statistics;
+        Instrumentation::TaskProbe probe(5, p.task_period_us);
+        Power::Client power(5, false);
+        Periodic::Schedule schedule(p.task_period, &power);
+        schedule.start();
+
         for (;;)
         {
-            std::array<uint16_t, Tasks::NUMBER_OF_ANALOGUE_READINGS> analogue_readings;
-
-            if (xQueueReceive(analogue_readings_queue, (void *)&analogue_readings, ticks_to_wait))
+            probe.begin(schedule.release_us());
+            if (const auto sample_block = analogue_readings_channel.receive(ticks_to_wait))
             {
-                auto average_analogue_reading = Tasks::compute_filtered_analogue_signal(analogue_readings);
+                const auto average_analogue_reading = Tasks::compute_filtered_analogue_signal(filter, sample_block->readings);
+                sample_block->filtered = average_analogue_reading;
+                // Publishing hands the block's reference to the channel, after which it may be released
+                // and refilled at any time, so everything that reads it comes first.
+                for (const auto reading : sample_block->readings)
+                    statistics.push(reading);
                 /**
-                 * Circularly send data to queue (if full, remove oldest/front of queue and append element to back)
-                 * This decouples sending-receiving of data - does not require receiving task to pop the front of the queue,
-                 * the receiver only needs to know that the data exists, and shall not be responsible for managing it too.
+                 * The channel only keeps the latest block, releasing one the receiver never collected.
+                 * This decouples sending-receiving of data - the receiver only needs to know that the data
+                 * exists, and shall not be responsible for managing it too.
                  */
-                if (isQueueFull)
-                {
-                    double _ignored;
-                    xQueueReceive(avg_analogue_readings, (void *)&_ignored, 0);
-                    xQueueSend(avg_analogue_readings, (void *)&average_analogue_reading, 0);
-                }
-                else
-                {
-                    xQueueSend(avg_analogue_readings, (void *)&average_analogue_reading, 0);
-                    isQueueFull = static_cast<bool>(!uxQueueSpacesAvailable(avg_analogue_readings));
-                }
+                filtered_analogue_channel.publish(sample_block);
 
-                data_to_log.set_filtered_analogue_signal(average_analogue_reading, ticks_to_wait);
+                Signals::filtered_analogue.publish(average_analogue_reading);
+                Signals::analogue_statistics.publish(statistics.snapshot());
+                BinaryLog::log(BinaryLog::RecordType::FilteredAnalogue, 5, average_analogue_reading.hundredths());
             }
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.end();
+            schedule.wait_next_release();
         }
     }
 
     void execute_no_op_instruction(void *params)
     {
         const auto p = *(TaskParams::TaskParams *)params;
+        // One unit of background work; the executor decides how many run each period.
         constexpr auto NUMBER_OF_NOP_INSTRUCTIONS = 1000;
+        // Hold the core at 70 % and give way to the sampling, filtering and logging tasks.
+        constexpr Background::Settings SETTINGS = {7000, 1, 20000, {4, 5, 9, 0}};
+
+        Background::install_idle_hooks();
+        Background::Executor executor(SETTINGS, [](const uint32_t units) {
+            Tasks::execute_no_op_instruction(static_cast<size_t>(units) * NUMBER_OF_NOP_INSTRUCTIONS);
+        });
+        Instrumentation::TaskProbe probe(6, p.task_period_us);
+        Periodic::Schedule schedule(p.task_period);
+        schedule.start();
 
         for (;;)
         {
-            Tasks::execute_no_op_instruction(NUMBER_OF_NOP_INSTRUCTIONS);
+            probe.begin(schedule.release_us());
+            executor.run();
+            Signals::background_work.publish(executor.metrics());
 
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.end();
+            schedule.wait_next_release();
         }
     }
 
     void compute_error_code(void *params)
     {
-        auto p = *(TaskParams::TaskParamsWithMailbox *)params;
+        const auto p = *(TaskParams::TaskParams *)params;
+        SampleBlock *latest = nullptr; // held until a newer block arrives, as the filter runs faster than this task
+        static ErrorEvaluator evaluator;
+        bool published = false;
+        uint8_t published_error_code = 0;
+        Benchmark::SampleLatency latency = {};
+
+        Instrumentation::TaskProbe probe(7, p.task_period_us);
+        Power::Client power(7, false);
+        Periodic::Schedule schedule(p.task_period, &power);
+        schedule.start();
 
         for (;;)
         {
-            double filtered_analogue_signal_val;
-            if (xQueuePeek(avg_analogue_readings, (void *)&filtered_analogue_signal_val, 0))
+            probe.begin(schedule.release_us());
+            if (const auto sample_block = filtered_analogue_channel.receive(0))
             {
-                const auto err = Tasks::compute_error_code(filtered_analogue_signal_val);
-
-                for (const auto &task : p.tasks)
-                    xTaskNotify(task, static_cast<uint32_t>(err), eSetValueWithOverwrite);
+                if (latest != nullptr)
+                    sample_blocks.release(latest);
+                latest = sample_block;
+                latency.add(static_cast<uint32_t>(Instrumentation::time_us() - sample_block->captured_us));
+                Signals::sample_latency.publish(latency);
+            }
+            if (latest != nullptr)
+            {
+                Statistics::Snapshot statistics = {};
+                Signals::analogue_statistics.read(statistics);
+                const auto err = Tasks::compute_error_code(evaluator, latest->filtered, statistics);
+                // Only changes are passed on, so Task 8 wakes once per change rather than every period.
+                if (!published || err != published_error_code)
+                {
+                    BinaryLog::log(BinaryLog::RecordType::ErrorCode, 7, err);
+                    Signals::error_code.publish(err);
+                    published = true;
+                    published_error_code = err;
+                }
             }
 
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.end();
+            schedule.wait_next_release();
         }
     }
 
     void visualise_error_code(void *params)
     {
         const auto p = *(TaskParams::TaskParams *)params;
+        constexpr uint32_t ERROR_CODE_CHANGED = 1;
+        auto &indicator = Waveform::create_indicator_generator();
+
+        // Event driven: woken only when the code changes; the blinking itself needs no CPU time.
+        static SignalBus::OnChange<uint8_t> error_code_changes(xTaskGetCurrentTaskHandle(), ERROR_CODE_CHANGED);
+        Signals::error_code.subscribe(error_code_changes);
+        Instrumentation::TaskProbe probe(8, p.task_period_us);
 
         for (;;)
         {
-            uint32_t err_code;
-            if (xTaskNotifyWait(0, 0, &err_code, 0))
+            uint32_t notified = 0;
+            if (!xTaskNotifyWait(0, ERROR_CODE_CHANGED, &notified, portMAX_DELAY) || !(notified & ERROR_CODE_CHANGED))
+                continue;
+
+            probe.begin_event(Instrumentation::time_us()); // the change carries no timestamp; time from the wake
+            uint8_t err_code;
+            if (error_code_changes.take(err_code))
             {
-                Tasks::visualise_error_code(static_cast<uint8_t>(err_code), p.pin_id);
+                Tasks::visualise_error_code<Pins::ErrorCodeLedPin>(err_code, indicator);
             }
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.end();
         }
     }
 
     void log(void *params)
     {
         const auto p = *(TaskParams::TaskParams *)params;
-        constexpr auto WAIT_TIME = 10.0;
+        Instrumentation::TaskProbe probe(9, p.task_period_us);
+        Power::Client power(9, false);
+        Periodic::Schedule schedule(p.task_period, &power);
+        schedule.start();
+
         for (;;)
         {
+            probe.begin(schedule.release_us());
             bool digital_input_state;
-            Hertz square_wave_freq;
-            double filtered_analogue_signal_val;
+            Units::MilliHertz square_wave_freq;
+            Units::AdcCounts filtered_analogue_signal_val;
 
-            if (data_to_log.get_data(digital_input_state,
-                                     square_wave_freq,
-                                     filtered_analogue_signal_val,
-                                     period_to_number_of_ticks_to_sleep(WAIT_TIME)))
+            if (Signals::digital_input.read(digital_input_state) &&
+                Signals::square_wave_frequency.read(square_wave_freq) &&
+                Signals::filtered_analogue.read(filtered_analogue_signal_val))
             {
                 if (digital_input_state)
                     Tasks::log(digital_input_state,
@@ -177,10 +337,90 @@ namespace RtosTasks
             }
             else
             {
-                Serial.println("Unable to log, data not accessible.");
+                BinaryLog::log(BinaryLog::RecordType::DataUnavailable, 9);
+            }
+            Statistics::Snapshot analogue_statistics;
+            if (Signals::analogue_statistics.read(analogue_statistics))
+                Tasks::log_analogue_statistics(analogue_statistics);
+            Background::Metrics background_work;
+            if (Signals::background_work.read(background_work))
+                BinaryLog::log(BinaryLog::RecordType::BackgroundWork,
+                               6,
+                               static_cast<int32_t>(background_work.units_per_second),
+                               background_work.utilisation,
+                               static_cast<uint16_t>(std::min<uint32_t>(background_work.units_per_period, UINT16_MAX)));
+            Benchmark::SampleLatency sample_latency;
+            if (Signals::sample_latency.read(sample_latency))
+                BinaryLog::log(BinaryLog::RecordType::SampleLatency,
+                               7,
+                               static_cast<int32_t>(sample_latency.mean_us()),
+                               static_cast<int32_t>(sample_latency.maximum_us),
+                               static_cast<uint16_t>(sample_latency.blocks));
+            Recorder::Metrics recorder;
+            if (Signals::telemetry_recorder.read(recorder))
+            {
+                BinaryLog::log(BinaryLog::RecordType::RecorderThroughput,
+                               10,
+                               static_cast<int32_t>(recorder.records_stored),
+                               static_cast<int32_t>(recorder.records_lost),
+                               static_cast<uint16_t>(recorder.programs));
+                BinaryLog::log(BinaryLog::RecordType::RecorderWear,
+                               10,
+                               static_cast<int32_t>(recorder.highest_erase_count),
+                               static_cast<int32_t>(recorder.erases),
+                               static_cast<uint16_t>(recorder.sectors));
+                BinaryLog::log(BinaryLog::RecordType::RecorderStall,
+                               10,
+                               static_cast<int32_t>(recorder.longest_erase_us),
+                               static_cast<int32_t>(recorder.erases ? recorder.total_erase_us / recorder.erases : 0),
+                               static_cast<uint16_t>(recorder.records_shed));
+            }
+            Instrumentation::dump();
+            TaskRegistry::report_core_load();
+            MemoryProfiler::report();
+            Power::report();
+
+            probe.end();
+            schedule.wait_next_release();
+        }
+    }
+
+    void drain_log(void *params)
+    {
+        const auto p = *(TaskParams::TaskParamsWithFraming *)params;
+
+        auto &hal = Hal::get();
+        static Recorder::Recorder recorder(Flash::telemetry_flash());
+        recorder.mount(); // without a region, records_lost counts what would have been kept
+        Recorder::CommandParser commands;
+
+        Instrumentation::TaskProbe probe(10, p.task_period_us);
+        Periodic::Schedule schedule(p.task_period);
+        schedule.start();
+
+        for (;;)
+        {
+            probe.begin(schedule.release_us());
+            // Keep sending full packets until the ring is caught up, then sleep.
+            while (BinaryLog::drain(p.framing, &Recorder::Recorder::sink, &recorder) == BinaryLog::RECORDS_PER_PACKET)
+            {
+            }
+            recorder.flush_if_due();
+
+            char input[32];
+            const auto received = hal.read_serial(input, sizeof(input));
+            for (size_t i = 0; i < received; i++)
+            {
+                if (commands.feed(static_cast<uint8_t>(input[i])))
+                    recorder.begin_export(commands.from_us, commands.to_us);
             }
+            // An export goes out a bounded number of records per release, alongside the live log.
+            if (recorder.exporting())
+                recorder.export_step(p.framing, EXPORT_RECORDS_PER_PERIOD);
+            Signals::telemetry_recorder.publish(recorder.metrics());
 
-            vTaskDelay(period_to_number_of_ticks_to_sleep(p.task_period));
+            probe.end();
+            schedule.wait_next_release();
         }
     }
 
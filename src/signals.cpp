@@ -0,0 +1,13 @@
+#include "signals.hpp"
+
+namespace Signals
+{
+    SignalBus::Topic<bool> digital_input("digital_input");
+    SignalBus::Topic<Units::MilliHertz> square_wave_frequency("square_wave_frequency");
+    SignalBus::Topic<Units::AdcCounts> filtered_analogue("filtered_analogue");
+    SignalBus::Topic<Statistics::Snapshot> analogue_statistics("analogue_statistics");
+    SignalBus::Topic<uint8_t> error_code("error_code");
+    SignalBus::Topic<Benchmark::SampleLatency> sample_latency("sample_latency");
+    SignalBus::Topic<Background::Metrics> background_work("background_work");
+    SignalBus::Topic<Recorder::Metrics> telemetry_recorder("telemetry_recorder");
+}
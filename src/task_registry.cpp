@@ -0,0 +1,107 @@
+#include "task_registry.hpp"
+
+#include <atomic>
+
+#include "binary_log.hpp"
+#include "instrumentation.hpp"
+
+namespace TaskRegistry
+{
+    namespace
+    {
+        constexpr uint8_t UNPINNED = 0xFF; // the core reported for ANY_CORE tasks
+
+        std::array<RegisteredTask, Instrumentation::MAXIMUM_TASKS> created_tasks = {};
+        std::array<std::atomic<TaskHandle_t>, Instrumentation::MAXIMUM_TASKS> handles = {};
+        size_t number_of_created_tasks = 0;
+    }
+
+    size_t number_of_registered_tasks()
+    {
+        return number_of_created_tasks;
+    }
+
+    const RegisteredTask &registered_task(const size_t index)
+    {
+        return created_tasks[index];
+    }
+
+    TaskHandle_t handle(const size_t index)
+    {
+        return handles[index].load(std::memory_order_acquire);
+    }
+
+    void exit_current_task()
+    {
+        const auto self = xTaskGetCurrentTaskHandle();
+        for (size_t i = 0; i < number_of_created_tasks; i++)
+            if (handles[i].load(std::memory_order_relaxed) == self)
+                handles[i].store(nullptr, std::memory_order_release);
+        vTaskDelete(nullptr);
+    }
+
+    TaskHandle_t create_task(const TaskDefinition &task,
+                             const UBaseType_t priority,
+                             const BaseType_t core,
+                             StackType_t *stack,
+                             StaticTask_t *tcb)
+    {
+        // Parameters are read-only; the FreeRTOS signature just predates const.
+        const auto params = const_cast<void *>(task.params);
+        const auto depth = stack_depth(task.stack_size);
+#ifdef NATIVE
+        const auto handle = xTaskCreateStatic(task.function, task.name, depth, params, priority, stack, tcb);
+#else
+        const auto handle = xTaskCreateStaticPinnedToCore(task.function,
+                                                          task.name,
+                                                          depth,
+                                                          params,
+                                                          priority,
+                                                          stack,
+                                                          tcb,
+                                                          (core == ANY_CORE) ? tskNO_AFFINITY : core);
+#endif
+        if (number_of_created_tasks < created_tasks.size())
+        {
+            handles[number_of_created_tasks].store(handle, std::memory_order_release);
+            created_tasks[number_of_created_tasks++] = {task.task_number,
+                                                        task.name,
+                                                        static_cast<uint32_t>(depth * sizeof(StackType_t)),
+                                                        task.period,
+                                                        utilisation(task),
+                                                        core};
+        }
+        return handle;
+    }
+
+    void report_core_load()
+    {
+        const auto rate = Instrumentation::cycles_per_microsecond();
+        for (BaseType_t core = ANY_CORE; core < NUMBER_OF_CORES; core++)
+        {
+            double measured = 0.0, budgeted = 0.0;
+            uint16_t tasks = 0;
+            for (size_t i = 0; i < number_of_created_tasks; i++)
+            {
+                const auto &task = created_tasks[i];
+                if (task.core != core || handle(i) == nullptr)
+                    continue;
+                tasks++;
+                budgeted += task.budgeted_utilisation;
+
+                Instrumentation::TaskStatistics statistics;
+                if (Instrumentation::query(task.task_number, statistics) && statistics.activations > 0)
+                    measured += statistics.mean_execution_cycles() / static_cast<double>(rate) / (task.period * 1000.0);
+            }
+            if (tasks == 0)
+                continue;
+
+            // Loads in hundredths of a percent.
+            BinaryLog::log(BinaryLog::RecordType::CoreLoad,
+                           core == ANY_CORE ? UNPINNED : static_cast<uint8_t>(core),
+                           static_cast<int32_t>(measured * 10000.0),
+                           static_cast<int32_t>(budgeted * 10000.0),
+                           tasks);
+        }
+    }
+}
@@ -0,0 +1,213 @@
+#include "waveform.hpp"
+
+#ifdef NATIVE
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "simulated_hal.hpp"
+#else
+#include <array>
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#endif
+
+namespace Waveform
+{
+#ifdef NATIVE
+    class SimulatedGenerator : public Generator
+    {
+    public:
+        ~SimulatedGenerator() override
+        {
+            stop();
+        }
+
+        using Generator::start;
+
+        bool start(const int8_t pin_id, const Pattern &pattern) override
+        {
+            if (pattern.pulses == 0 || pattern.pulse_width.count() == 0 || pattern.pulse_width >= pattern.period)
+                return false;
+            stop();
+
+            running = true;
+            thread = std::thread([pin_id, pattern, this]() {
+                using Clock = std::chrono::steady_clock;
+                const auto to_duration = [](const Units::Microseconds us) {
+                    return std::chrono::microseconds(us.count());
+                };
+                // Host sleeps overshoot by tens of microseconds, so sleep to just short of each edge
+                // and spin the rest of the way.
+                const auto wait_until = [&](const Clock::time_point edge) {
+                    std::this_thread::sleep_until(edge - to_duration(SPIN_MARGIN));
+                    while (Clock::now() < edge)
+                    {
+                    }
+                };
+                auto &hal = Hal::simulated();
+                const auto origin = Clock::now();
+                const auto burst = to_duration(pattern.period) * pattern.pulses + to_duration(pattern.pause);
+                for (uint64_t cycle = 0; running; cycle++)
+                {
+                    // Edges are placed from the cycle index, as the hardware would, so any lateness shows
+                    // up as jitter in the recorded edges but never as drift.
+                    const auto rising = origin + burst * (cycle / pattern.pulses) + to_duration(pattern.period) * (cycle % pattern.pulses);
+                    wait_until(rising);
+                    hal.digital_write(pin_id, true);
+                    wait_until(rising + to_duration(pattern.pulse_width));
+                    hal.digital_write(pin_id, false);
+                }
+            });
+            return true;
+        }
+
+        void stop() override
+        {
+            running = false;
+            if (thread.joinable())
+                thread.join();
+        }
+
+    private:
+        static constexpr Units::Microseconds SPIN_MARGIN = Units::Microseconds(500);
+
+        std::atomic<bool> running{false};
+        std::thread thread;
+    };
+
+    Generator &create_generator()
+    {
+        static SimulatedGenerator generator;
+        return generator;
+    }
+
+    Generator &create_indicator_generator()
+    {
+        static SimulatedGenerator generator;
+        return generator;
+    }
+#else
+    /**
+     * RMT channel in loop mode, replaying a list of items indefinitely. Each item holds two phases
+     * (level and duration); phases longer than an item half's 15 bits are split over several halves.
+     * The channel counts ticks of the 80 MHz APB clock divided by clock_divider.
+     */
+    class RmtGenerator : public Generator
+    {
+    public:
+        RmtGenerator(const rmt_channel_t channel, const uint8_t clock_divider) : channel(channel), clock_divider(clock_divider) {}
+
+        using Generator::start;
+
+        bool start(const int8_t pin_id, const Pattern &pattern) override
+        {
+            const auto high = ticks(pattern.pulse_width);
+            const auto period = ticks(pattern.period);
+            if (pattern.pulses == 0 || high == 0 || high >= period)
+                return false;
+
+            ItemList items;
+            for (uint8_t pulse = 0; pulse < pattern.pulses; pulse++)
+            {
+                const auto pause = (pulse + 1 == pattern.pulses) ? ticks(pattern.pause) : 0;
+                if (!items.append(1, high) || !items.append(0, period - high + pause))
+                    return false;
+            }
+
+            stop();
+            rmt_config_t config = RMT_DEFAULT_CONFIG_TX(static_cast<gpio_num_t>(pin_id), channel);
+            config.clk_div = clock_divider;
+            config.tx_config.loop_en = true;
+            if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel, 0, 0) != ESP_OK)
+                return false;
+            attached_pin = pin_id;
+            return rmt_write_items(channel, items.data(), items.size(), false) == ESP_OK;
+        }
+
+        // Leaves the pin low and hands it back to the GPIO output register.
+        void stop() override
+        {
+            if (attached_pin < 0)
+                return;
+            rmt_tx_stop(channel);
+            rmt_driver_uninstall(channel);
+            pinMatrixOutDetach(static_cast<uint8_t>(attached_pin), false, false);
+            attached_pin = -1;
+        }
+
+    private:
+        static constexpr uint32_t APB_CLOCK_MHZ = 80;
+        static constexpr uint32_t MAXIMUM_DURATION = 32767;
+        static constexpr size_t MAXIMUM_ITEMS = 63; // one RMT memory block, less the end marker
+
+        // Phases packed two to an item. A zero duration marks the end of the list, which is where the
+        // empty half of an odd final item falls.
+        class ItemList
+        {
+        public:
+            bool append(const uint32_t level, uint32_t duration)
+            {
+                while (duration > 0)
+                {
+                    if (halves == 2 * MAXIMUM_ITEMS)
+                        return false;
+                    const auto half = (duration > MAXIMUM_DURATION) ? MAXIMUM_DURATION : duration;
+                    duration -= half;
+                    auto &item = items[halves / 2];
+                    if (halves % 2 == 0)
+                    {
+                        item.level0 = level;
+                        item.duration0 = half;
+                    }
+                    else
+                    {
+                        item.level1 = level;
+                        item.duration1 = half;
+                    }
+                    halves++;
+                }
+                return true;
+            }
+
+            const rmt_item32_t *data() const
+            {
+                return items.data();
+            }
+
+            size_t size() const
+            {
+                return (halves + 1) / 2;
+            }
+
+        private:
+            std::array<rmt_item32_t, MAXIMUM_ITEMS> items = {};
+            size_t halves = 0;
+        };
+
+        uint32_t ticks(const Units::Microseconds duration) const
+        {
+            return static_cast<uint32_t>((static_cast<uint64_t>(duration.count()) * APB_CLOCK_MHZ + clock_divider / 2) / clock_divider);
+        }
+
+        const rmt_channel_t channel;
+        const uint8_t clock_divider;
+        int8_t attached_pin = -1;
+    };
+
+    // 1 us ticks, so Task 1's pulse is exact.
+    Generator &create_generator()
+    {
+        static RmtGenerator generator(RMT_CHANNEL_0, 80);
+        return generator;
+    }
+
+    // 2 us ticks: an item half lasts up to 65 ms, so a blink pattern of seconds fits in one block.
+    Generator &create_indicator_generator()
+    {
+        static RmtGenerator generator(RMT_CHANNEL_1, 160);
+        return generator;
+    }
+#endif
+}
@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <unity.h>
+
+#include "adc_sampler.hpp"
+#include "benchmark.hpp"
+#include "binary_log.hpp"
+#include "block_pool.hpp"
+#include "gpio_pin.hpp"
+#include "hal.hpp"
+#include "instrumentation.hpp"
+#include "platform.hpp"
+#include "rtos_tasks.hpp"
+#include "tasks.hpp"
+
+#ifdef NATIVE
+#include "simulated_hal.hpp"
+#else
+#include <Arduino.h>
+#endif
+
+using namespace RtosTasks;
+
+// Unclaimed by the firmware, so the GPIO kernels cannot disturb anything else.
+constexpr int8_t BENCHMARK_PIN = 23;
+using BenchmarkOutput = Gpio::Pin<BENCHMARK_PIN, Hal::PinMode::Output>;
+
+constexpr size_t BATCHES = 9;
+constexpr size_t SYNTHETIC_SAMPLES = 256;
+constexpr uint32_t SQUARE_WAVE_PERIOD_US = 1000000; // long enough that the wave stays live for the run
+
+#ifdef NATIVE
+// The simulated HAL records every output edge in a deque, which allocates; the ESP32's GPIO path does not.
+constexpr bool GPIO_ALLOCATION_FREE = false;
+#else
+constexpr bool GPIO_ALLOCATION_FREE = true;
+#endif
+
+// Used when BENCHMARK_BASELINE is not set; pio test runs from the project directory.
+constexpr const char *DEFAULT_BASELINE = "benchmarks/baseline-native.json";
+
+static std::atomic<uint32_t> allocation_count{0};
+
+// The tasks allocate nothing after start-up, so any allocation a kernel makes shows up here.
+void *operator new(const size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (const auto block = std::malloc(size ? size : 1))
+        return block;
+    std::abort();
+}
+
+void *operator new[](const size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void *block, size_t) noexcept
+{
+    std::free(block);
+}
+
+struct Result
+{
+    double ns_per_op;
+    double cycles_per_op;
+    uint32_t allocations;
+};
+
+static volatile uint32_t sink; // keeps results the compiler could otherwise discard
+
+// The same pseudo-random full-scale readings on every run and every platform.
+static std::array<uint16_t, SYNTHETIC_SAMPLES> synthetic_samples()
+{
+    std::array<uint16_t, SYNTHETIC_SAMPLES> samples;
+    uint32_t state = 12345;
+    for (auto &sample : samples)
+    {
+        state = state * 1103515245 + 12345;
+        sample = static_cast<uint16_t>((state >> 16) % 4096);
+    }
+    return samples;
+}
+
+static const std::array<uint16_t, SYNTHETIC_SAMPLES> samples = synthetic_samples();
+static size_t next_sample = 0;
+
+// Runs `operation` in BATCHES batches and keeps the fastest, which discards batches that were
+// preempted.
+template <typename Operation>
+static Result measure(const uint32_t operations, Operation &&operation)
+{
+    operation(); // warms the caches
+
+    uint32_t fastest = UINT32_MAX;
+    const auto allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (size_t batch = 0; batch < BATCHES; batch++)
+    {
+        const auto start = Instrumentation::cycle_count();
+        for (uint32_t i = 0; i < operations; i++)
+            operation();
+        fastest = std::min(fastest, Instrumentation::cycle_count() - start);
+    }
+
+    Result result;
+    result.allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+    result.cycles_per_op = static_cast<double>(fastest) / operations;
+    result.ns_per_op = result.cycles_per_op * 1000.0 / Instrumentation::cycles_per_microsecond();
+    return result;
+}
+
+// A fixed integer workload that uses nothing from the firmware. Kernels are compared by their time
+// relative to it, measured in the same run, so a baseline holds on a faster or slower host.
+static const Result &reference()
+{
+    static const auto result = measure(1000, [] {
+        uint32_t state = sink;
+        for (int round = 0; round < 16; round++)
+            state = (state ^ (state >> 7)) * 1664525 + 1013904223;
+        sink = state;
+    });
+    return result;
+}
+
+#ifdef NATIVE
+// The baseline's ratio for `kernel`, or a negative value if it has none. Reads only the flat layout
+// of benchmarks/baseline-native.json.
+static double baseline_ratio(const char *baseline, const char *kernel)
+{
+    char key[48];
+    snprintf(key, sizeof(key), "\"%s\"", kernel);
+    const auto entry = strstr(baseline, key);
+    const auto field = entry ? strstr(entry, "\"ratio\":") : nullptr;
+    if (field == nullptr)
+        return -1.0;
+    char *end = nullptr;
+    const auto value = strtod(field + strlen("\"ratio\":"), &end);
+    return (end != field + strlen("\"ratio\":")) ? value : -1.0;
+}
+
+static double baseline_tolerance_percent(const char *baseline)
+{
+    const auto field = strstr(baseline, "\"tolerance_percent\":");
+    return field ? strtod(field + strlen("\"tolerance_percent\":"), nullptr) : 0.0;
+}
+
+static const char *load_baseline()
+{
+    static char baseline[4096];
+    static bool loaded = false;
+    if (loaded)
+        return baseline[0] ? baseline : nullptr;
+    loaded = true;
+
+    const auto configured = getenv("BENCHMARK_BASELINE");
+    const auto file = fopen(configured ? configured : DEFAULT_BASELINE, "r");
+    if (file == nullptr)
+        return nullptr;
+    const auto length = fread(baseline, 1, sizeof(baseline) - 1, file);
+    fclose(file);
+    baseline[length] = '\0';
+    return baseline;
+}
+#endif
+
+// Prints one machine-readable line per kernel, checks it allocated nothing and, on the host, that its
+// ratio to the reference kernel is no higher than the baseline allows.
+static void report(const char *kernel, const Result &result, const bool allocation_free = true)
+{
+    const auto ratio = result.ns_per_op / reference().ns_per_op;
+    char message[192];
+    snprintf(message, sizeof(message),
+             "{\"kernel\": \"%s\", \"ns_per_op\": %.2f, \"cycles_per_op\": %.2f, \"ratio\": %.3f, \"allocations\": %u}",
+             kernel, result.ns_per_op, result.cycles_per_op, ratio, static_cast<unsigned>(result.allocations));
+    TEST_MESSAGE(message);
+    if (allocation_free)
+        TEST_ASSERT_EQUAL_UINT32(0, result.allocations);
+
+#ifdef NATIVE
+    const auto baseline = load_baseline();
+    if (baseline == nullptr)
+    {
+        // A configured baseline must exist; the default one may not, e.g. when run from elsewhere.
+        TEST_ASSERT_TRUE_MESSAGE(getenv("BENCHMARK_BASELINE") == nullptr, "BENCHMARK_BASELINE names a file that cannot be read.");
+        TEST_MESSAGE("No baseline; not compared.");
+        return;
+    }
+    const auto expected = baseline_ratio(baseline, kernel);
+    if (expected < 0.0)
+        return;
+    const auto limit = expected * (1.0 + baseline_tolerance_percent(baseline) / 100.0);
+    snprintf(message, sizeof(message), "%s: %.3f times the reference kernel against a limit of %.3f", kernel, ratio, limit);
+    TEST_ASSERT_TRUE_MESSAGE(ratio <= limit, message);
+#endif
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_reference()
+{
+    report("reference", reference());
+}
+
+// Tasks::compute_filtered_analogue_signal, one block.
+static void test_filter()
+{
+    std::array<uint16_t, READINGS_PER_BLOCK> readings;
+    std::copy_n(samples.begin(), readings.size(), readings.begin());
+    static AnalogueFilter filter;
+    report("filter", measure(1000, [&] {
+               const auto index = next_sample++;
+               readings[index % readings.size()] = samples[index % samples.size()];
+               sink = Tasks::compute_filtered_analogue_signal(filter, readings).hundredths();
+           }));
+}
+
+// The Task 5 rolling statistics, one block and a snapshot.
+static void test_statistics()
+{
+    static AnalogueStatistics statistics;
+    report("statistics", measure(200, [&] {
+               for (size_t i = 0; i < READINGS_PER_BLOCK; i++)
+                   statistics.push(samples[next_sample++ % samples.size()]);
+               sink = statistics.snapshot().mean.hundredths();
+           }));
+}
+
+// Tasks::compute_error_code.
+static void test_error_code()
+{
+    static AnalogueStatistics statistics;
+    for (const auto sample : samples)
+        statistics.push(sample);
+    const auto snapshot = statistics.snapshot();
+    static ErrorEvaluator evaluator;
+    report("error_code", measure(1000, [&] {
+               const auto level = Units::AdcCounts::from_counts(samples[next_sample++ % samples.size()]);
+               sink = Tasks::compute_error_code(evaluator, level, snapshot);
+           }));
+}
+
+// Tasks::measure_square_wave_frequency over 8 periods.
+static void test_square_wave_frequency()
+{
+    static Tasks::SquareWaveCapture capture;
+    const auto now = Hal::get().micros().count();
+    for (uint32_t edge = 32; edge > 0; edge--)
+        capture.push(now - (edge - 1) * SQUARE_WAVE_PERIOD_US);
+    report("square_wave_frequency", measure(1000, [&] {
+               sink = static_cast<uint32_t>(Tasks::measure_square_wave_frequency(capture, 8).count());
+           }));
+}
+
+// Task 4 oversampling, one ADC block.
+static void test_decimation()
+{
+    AdcSampler::Decimator<ADC_OVERSAMPLING> decimator;
+    report("decimation", measure(200, [&] {
+               const auto block = &samples[(next_sample++ * ADC_BLOCK_SIZE) % SYNTHETIC_SAMPLES];
+               decimator.process(block, ADC_BLOCK_SIZE, [](const uint16_t reading) { sink = reading; });
+           }));
+}
+
+// CRC and COBS framing of a full log packet, the format every record leaves the board in.
+static void test_packet_encoding()
+{
+    static std::array<uint8_t, BinaryLog::MAXIMUM_PACKET_SIZE> packet;
+    static std::array<uint8_t, BinaryLog::MAXIMUM_PACKET_SIZE * 2> frame;
+    for (size_t i = 0; i < packet.size(); i++)
+        packet[i] = static_cast<uint8_t>(samples[i % samples.size()]);
+    report("packet_encoding", measure(50, [&] {
+               const auto length = packet.size() - BinaryLog::PACKET_CRC_SIZE;
+               const auto crc = BinaryLog::crc16(packet.data(), length);
+               packet[length] = static_cast<uint8_t>(crc);
+               packet[length + 1] = static_cast<uint8_t>(crc >> 8);
+               sink = static_cast<uint32_t>(BinaryLog::cobs_encode(packet.data(), packet.size(), frame.data()));
+           }));
+}
+
+// A private copy of the Task 4 -> Task 5 -> Task 7 plumbing: block acquire -> channel -> filter ->
+// channel -> release.
+static BlockPool::BlockPool<SampleBlock, 4> chain_blocks;
+static BlockPool::Channel<SampleBlock, 4> chain_readings(chain_blocks);
+static BlockPool::Channel<SampleBlock, 4> chain_filtered(chain_blocks);
+
+static void test_sample_chain()
+{
+    static AnalogueFilter filter;
+    report("sample_chain", measure(200, [&] {
+               const auto block = chain_blocks.acquire();
+               std::copy_n(&samples[(next_sample++ * READINGS_PER_BLOCK) % SYNTHETIC_SAMPLES], READINGS_PER_BLOCK, block->readings.begin());
+               chain_readings.publish(block);
+
+               const auto filtered = chain_readings.receive(0);
+               filtered->filtered = Tasks::compute_filtered_analogue_signal(filter, filtered->readings);
+               chain_filtered.publish(filtered);
+
+               const auto consumed = chain_filtered.receive(0);
+               sink = consumed->filtered.hundredths();
+               chain_blocks.release(consumed);
+           }));
+}
+
+/**
+ * End to end, from an ADC block to its records framed for the serial port: Task 4's decimation, the
+ * channel to Task 5, the filter and statistics, the channel to Task 7, the error code, and the log
+ * drain's packet. A private ring stands in for BinaryLog's and the frame is not sent, so nothing goes
+ * out on the port the results are read from. Also reports the slowest single block.
+ */
+static void test_sample_to_log()
+{
+    static AdcSampler::Decimator<ADC_OVERSAMPLING> decimator;
+    static AnalogueFilter filter;
+    static AnalogueStatistics statistics;
+    static ErrorEvaluator evaluator;
+    static BinaryLog::RecordRing<BinaryLog::RECORDS_PER_PACKET> ring;
+    static std::array<uint8_t, BinaryLog::MAXIMUM_PACKET_SIZE> packet;
+    static std::array<uint8_t, BinaryLog::MAXIMUM_PACKET_SIZE * 2> frame;
+    uint32_t slowest_cycles = 0;
+    const auto result = measure(200, [&] {
+        const auto captured = Instrumentation::cycle_count();
+
+        const auto block = chain_blocks.acquire();
+        size_t reading = 0;
+        decimator.process(&samples[(next_sample++ * ADC_BLOCK_SIZE) % SYNTHETIC_SAMPLES], ADC_BLOCK_SIZE,
+                          [&](const uint16_t value) { block->readings[reading++] = value; });
+        chain_readings.publish(block);
+
+        const auto filtered = chain_readings.receive(0);
+        filtered->filtered = Tasks::compute_filtered_analogue_signal(filter, filtered->readings);
+        for (const auto value : filtered->readings)
+            statistics.push(value);
+        ring.push({Hal::get().micros().count(), BinaryLog::RecordType::FilteredAnalogue, 5, 0, filtered->filtered.hundredths(), 0});
+        chain_filtered.publish(filtered);
+
+        const auto consumed = chain_filtered.receive(0);
+        const auto code = Tasks::compute_error_code(evaluator, consumed->filtered, statistics.snapshot());
+        chain_blocks.release(consumed);
+        ring.push({Hal::get().micros().count(), BinaryLog::RecordType::ErrorCode, 7, 0, code, 0});
+
+        size_t length = BinaryLog::LIVE_PACKET_HEADER_SIZE;
+        size_t records = 0;
+        BinaryLog::Record record;
+        while (ring.pop(record))
+        {
+            memcpy(&packet[length], &record, sizeof(record));
+            length += sizeof(record);
+            records++;
+        }
+        packet[0] = BinaryLog::LIVE_PACKET_VERSION;
+        packet[1] = static_cast<uint8_t>(records);
+        const auto crc = BinaryLog::crc16(packet.data(), length);
+        packet[length++] = static_cast<uint8_t>(crc);
+        packet[length++] = static_cast<uint8_t>(crc >> 8);
+        sink = static_cast<uint32_t>(BinaryLog::cobs_encode(packet.data(), length, frame.data()));
+
+        slowest_cycles = std::max(slowest_cycles, Instrumentation::cycle_count() - captured);
+    });
+    report("sample_to_log", result);
+
+    char message[96];
+    snprintf(message, sizeof(message), "{\"kernel\": \"sample_to_log\", \"slowest_ns\": %.2f}",
+             slowest_cycles * 1000.0 / Instrumentation::cycles_per_microsecond());
+    TEST_MESSAGE(message);
+}
+
+// One toggle through Hal::digital_write, then through a typed Gpio::Pin.
+static void test_gpio()
+{
+    BenchmarkOutput::configure();
+    bool level = false;
+    report("gpio_hal", measure(1000, [&] {
+               level = !level;
+               Hal::get().digital_write(BENCHMARK_PIN, level);
+           }),
+           GPIO_ALLOCATION_FREE);
+    report("gpio_pin", measure(1000, [&] {
+               level = !level;
+               BenchmarkOutput::write(level);
+           }),
+           GPIO_ALLOCATION_FREE);
+    BenchmarkOutput::clear();
+}
+
+static void run_benchmarks()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_reference);
+    RUN_TEST(test_filter);
+    RUN_TEST(test_statistics);
+    RUN_TEST(test_error_code);
+    RUN_TEST(test_square_wave_frequency);
+    RUN_TEST(test_decimation);
+    RUN_TEST(test_packet_encoding);
+    RUN_TEST(test_sample_chain);
+    RUN_TEST(test_sample_to_log);
+    RUN_TEST(test_gpio);
+}
+
+#ifdef NATIVE
+static void run_tests(void *)
+{
+    run_benchmarks();
+    exit(UNITY_END());
+}
+
+int main()
+{
+    // The channels' queues need the scheduler, so the benchmarks run in a task.
+    static StaticTask_t tcb;
+    static StackType_t stack[configMINIMAL_STACK_SIZE * 4];
+    xTaskCreateStatic(run_tests, "benchmarks", configMINIMAL_STACK_SIZE * 4, nullptr, 2, stack, &tcb);
+    vTaskStartScheduler();
+    return 1;
+}
+#else
+void setup()
+{
+    delay(2000); // lets the test runner open the port
+    run_benchmarks();
+    UNITY_END();
+}
+
+void loop() {}
+#endif
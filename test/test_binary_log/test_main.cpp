@@ -0,0 +1,243 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <unity.h>
+
+#include "binary_log.hpp"
+#include "simulated_hal.hpp"
+
+using BinaryLog::Record;
+using BinaryLog::RecordType;
+
+// The inverse of BinaryLog::cobs_encode(), as tools/decode_log.py does it.
+static std::vector<uint8_t> cobs_decode(const std::vector<uint8_t> &frame)
+{
+    std::vector<uint8_t> output;
+    size_t i = 0;
+    while (i < frame.size())
+    {
+        const auto code = frame[i++];
+        for (uint8_t n = 1; n < code && i < frame.size(); n++)
+            output.push_back(frame[i++]);
+        if (code != 0xFF && i < frame.size())
+            output.push_back(0);
+    }
+    return output;
+}
+
+static std::vector<uint8_t> encode(const std::vector<uint8_t> &packet)
+{
+    std::vector<uint8_t> frame(packet.size() + packet.size() / 254 + 2);
+    frame.resize(BinaryLog::cobs_encode(packet.data(), packet.size(), frame.data()));
+    return frame;
+}
+
+// Everything the log drain task wrote to the serial port since the last call.
+static std::vector<uint8_t> serial_output()
+{
+    static FILE *const stream = []() {
+        const auto file = tmpfile();
+        Hal::simulated().set_serial_output(file);
+        return file;
+    }();
+    static long consumed = 0;
+    fflush(stream);
+    const auto end = ftell(stream);
+    std::vector<uint8_t> bytes(static_cast<size_t>(end - consumed));
+    fseek(stream, consumed, SEEK_SET);
+    bytes.resize(fread(bytes.data(), 1, bytes.size(), stream));
+    consumed = end;
+    return bytes;
+}
+
+static void discard_logged_records()
+{
+    serial_output();
+    while (BinaryLog::drain(BinaryLog::Framing::Cobs) > 0)
+    {
+    }
+    serial_output();
+}
+
+void setUp()
+{
+    discard_logged_records();
+}
+
+void tearDown() {}
+
+// The standard check value of CRC-16/CCITT-FALSE.
+static void test_crc16_matches_the_check_value()
+{
+    const char *check = "123456789";
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, BinaryLog::crc16(reinterpret_cast<const uint8_t *>(check), strlen(check)));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, BinaryLog::crc16(nullptr, 0));
+}
+
+static void test_cobs_encodes_the_reference_examples()
+{
+    const std::vector<uint8_t> zero = {0x00};
+    TEST_ASSERT_TRUE((encode(zero) == std::vector<uint8_t>{0x01, 0x01}));
+    const std::vector<uint8_t> mixed = {0x11, 0x22, 0x00, 0x33};
+    TEST_ASSERT_TRUE((encode(mixed) == std::vector<uint8_t>{0x03, 0x11, 0x22, 0x02, 0x33}));
+
+    // A run of 254 non-zero bytes fills one block; the next byte starts another.
+    std::vector<uint8_t> run(255);
+    for (size_t i = 0; i < run.size(); i++)
+        run[i] = static_cast<uint8_t>(i % 255 + 1);
+    const auto frame = encode(run);
+    TEST_ASSERT_EQUAL_UINT32(257, frame.size());
+    TEST_ASSERT_EQUAL_HEX8(0xFF, frame[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, frame[255]);
+}
+
+// Random packets of every length up to the largest, many of them zero-heavy, survive encoding with
+// their CRC intact and never contain the 0x00 delimiter.
+static void test_cobs_and_crc_round_trip()
+{
+    std::mt19937 generator(6);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (size_t length = 1; length <= BinaryLog::MAXIMUM_PACKET_SIZE - BinaryLog::PACKET_CRC_SIZE; length++)
+    {
+        std::vector<uint8_t> packet(length);
+        for (auto &value : packet)
+            value = (length % 3 == 0) ? static_cast<uint8_t>(byte(generator) & 0x01) : static_cast<uint8_t>(byte(generator));
+        const auto crc = BinaryLog::crc16(packet.data(), packet.size());
+        packet.push_back(static_cast<uint8_t>(crc));
+        packet.push_back(static_cast<uint8_t>(crc >> 8));
+
+        const auto frame = encode(packet);
+        TEST_ASSERT_TRUE(memchr(frame.data(), 0, frame.size()) == nullptr);
+        const auto decoded = cobs_decode(frame);
+        TEST_ASSERT_TRUE(decoded == packet);
+        const auto received = static_cast<uint16_t>(decoded[length] | (decoded[length + 1] << 8));
+        TEST_ASSERT_EQUAL_HEX16(BinaryLog::crc16(decoded.data(), length), received);
+    }
+}
+
+static void test_full_ring_counts_drops_and_refills_once_drained()
+{
+    BinaryLog::RecordRing<8> ring;
+    for (int lap = 0; lap < 3; lap++)
+    {
+        for (int32_t i = 0; i < 8; i++)
+            TEST_ASSERT_TRUE(ring.push({0, RecordType::ErrorCode, 0, 0, lap * 8 + i, 0}));
+        TEST_ASSERT_FALSE(ring.push({0, RecordType::ErrorCode, 0, 0, -1, 0}));
+        TEST_ASSERT_FALSE(ring.push({0, RecordType::ErrorCode, 0, 0, -1, 0}));
+        TEST_ASSERT_EQUAL_UINT32(2, ring.take_dropped());
+        TEST_ASSERT_EQUAL_UINT32(0, ring.take_dropped());
+
+        Record record;
+        for (int32_t i = 0; i < 8; i++)
+        {
+            TEST_ASSERT_TRUE(ring.pop(record));
+            TEST_ASSERT_EQUAL_INT32(lap * 8 + i, record.value0);
+        }
+        TEST_ASSERT_FALSE(ring.pop(record));
+    }
+}
+
+// Producers on several threads against a draining consumer: every record is either delivered once,
+// in each producer's order, or counted as dropped.
+static void test_ring_delivers_or_counts_every_record_under_contention()
+{
+    constexpr int PRODUCERS = 4;
+    constexpr int32_t RECORDS_PER_PRODUCER = 20000;
+    static BinaryLog::RecordRing<64> ring;
+    std::atomic<int> producing{PRODUCERS};
+    std::vector<std::thread> producers;
+    for (uint8_t task = 0; task < PRODUCERS; task++)
+    {
+        producers.emplace_back([&, task] {
+            for (int32_t i = 0; i < RECORDS_PER_PRODUCER; i++)
+                ring.push({0, RecordType::ErrorCode, task, 0, i, 0});
+            producing--;
+        });
+    }
+
+    int32_t last[PRODUCERS] = {-1, -1, -1, -1};
+    uint32_t delivered = 0;
+    uint32_t out_of_order = 0;
+    Record record;
+    for (;;)
+    {
+        const auto finished = producing.load() == 0;
+        while (ring.pop(record))
+        {
+            out_of_order += record.value0 <= last[record.task];
+            last[record.task] = record.value0;
+            delivered++;
+        }
+        if (finished)
+            break;
+        std::this_thread::yield();
+    }
+    for (auto &producer : producers)
+        producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * RECORDS_PER_PRODUCER, delivered + ring.take_dropped());
+}
+
+// log() -> drain() -> serial port -> COBS decode -> CRC check -> the same records, with the losses
+// from an overflowing ring reported first.
+static void test_drained_packets_carry_the_logged_records()
+{
+    constexpr size_t OVERFLOW = 5;
+    for (size_t i = 0; i < BinaryLog::RING_CAPACITY + OVERFLOW; i++)
+        BinaryLog::log(RecordType::FilteredAnalogue, 5, static_cast<int32_t>(i));
+
+    std::vector<Record> records;
+    uint16_t expected_sequence = 0;
+    bool first_packet = true;
+    while (BinaryLog::drain(BinaryLog::Framing::Cobs) > 0)
+    {
+        const auto bytes = serial_output();
+        TEST_ASSERT_EQUAL_HEX8(0x00, bytes.back());
+        const auto packet = cobs_decode(std::vector<uint8_t>(bytes.begin(), bytes.end() - 1));
+        const auto length = packet.size() - BinaryLog::PACKET_CRC_SIZE;
+        TEST_ASSERT_EQUAL_HEX16(BinaryLog::crc16(packet.data(), length),
+                                static_cast<uint16_t>(packet[length] | (packet[length + 1] << 8)));
+
+        TEST_ASSERT_EQUAL_UINT8(BinaryLog::LIVE_PACKET_VERSION, packet[0]);
+        const auto sequence = static_cast<uint16_t>(packet[2] | (packet[3] << 8));
+        if (!first_packet)
+            TEST_ASSERT_EQUAL_UINT16(expected_sequence, sequence);
+        first_packet = false;
+        expected_sequence = static_cast<uint16_t>(sequence + 1);
+
+        TEST_ASSERT_EQUAL_UINT32(BinaryLog::LIVE_PACKET_HEADER_SIZE + packet[1] * sizeof(Record), length);
+        for (size_t i = 0; i < packet[1]; i++)
+        {
+            Record record;
+            memcpy(&record, &packet[BinaryLog::LIVE_PACKET_HEADER_SIZE + i * sizeof(Record)], sizeof(record));
+            records.push_back(record);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(BinaryLog::RING_CAPACITY + 1, records.size());
+    TEST_ASSERT_TRUE(records[0].type == RecordType::RecordsDropped);
+    TEST_ASSERT_EQUAL_INT32(OVERFLOW, records[0].value0);
+    for (size_t i = 1; i < records.size(); i++)
+    {
+        TEST_ASSERT_TRUE(records[i].type == RecordType::FilteredAnalogue);
+        TEST_ASSERT_EQUAL_UINT8(5, records[i].task);
+        TEST_ASSERT_EQUAL_INT32(i - 1, records[i].value0);
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16_matches_the_check_value);
+    RUN_TEST(test_cobs_encodes_the_reference_examples);
+    RUN_TEST(test_cobs_and_crc_round_trip);
+    RUN_TEST(test_full_ring_counts_drops_and_refills_once_drained);
+    RUN_TEST(test_ring_delivers_or_counts_every_record_under_contention);
+    RUN_TEST(test_drained_packets_carry_the_logged_records);
+    return UNITY_END();
+}
@@ -0,0 +1,151 @@
+#include <array>
+#include <chrono>
+#include <cstdio>
+
+#include <unity.h>
+
+#include "block_pool.hpp"
+#include "platform.hpp"
+#include "rtos_tasks.hpp"
+
+using RtosTasks::SampleBlock;
+using Readings = std::array<uint16_t, RtosTasks::READINGS_PER_BLOCK>;
+using Pool = BlockPool::BlockPool<SampleBlock, RtosTasks::SAMPLE_BLOCKS>;
+using Channel = BlockPool::Channel<SampleBlock, RtosTasks::SAMPLE_BLOCKS>;
+
+constexpr uint32_t BLOCKS = 200000;
+
+static Readings make_readings(const uint32_t n)
+{
+    Readings readings;
+    for (size_t i = 0; i < readings.size(); i++)
+        readings[i] = static_cast<uint16_t>((n + i) & 0x0FFF);
+    return readings;
+}
+
+static double blocks_per_second(const std::chrono::steady_clock::time_point start)
+{
+    return BLOCKS / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_acquire_hands_out_every_block_once()
+{
+    Pool pool;
+    std::array<SampleBlock *, RtosTasks::SAMPLE_BLOCKS> blocks = {};
+    for (auto &block : blocks)
+    {
+        block = pool.acquire();
+        TEST_ASSERT_NOT_NULL(block);
+    }
+    for (size_t i = 0; i < blocks.size(); i++)
+        for (size_t j = 0; j < i; j++)
+            TEST_ASSERT_TRUE(blocks[i] != blocks[j]);
+    TEST_ASSERT_EQUAL_UINT32(0, pool.available());
+    TEST_ASSERT_NULL(pool.acquire());
+
+    pool.release(blocks[3]);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.available());
+    TEST_ASSERT_EQUAL_PTR(blocks[3], pool.acquire());
+}
+
+static void test_block_returns_on_the_last_release()
+{
+    Pool pool;
+    const auto block = pool.acquire();
+    pool.retain(block, 2); // three consumers
+    pool.release(block);
+    pool.release(block);
+    TEST_ASSERT_EQUAL_UINT32(RtosTasks::SAMPLE_BLOCKS - 1, pool.available());
+    pool.release(block);
+    TEST_ASSERT_EQUAL_UINT32(RtosTasks::SAMPLE_BLOCKS, pool.available());
+}
+
+static void test_channel_keeps_the_latest_block_and_releases_the_stale_one()
+{
+    Pool pool;
+    Channel channel(pool);
+    const auto stale = pool.acquire();
+    const auto latest = pool.acquire();
+    channel.publish(stale);
+    channel.publish(latest);
+    TEST_ASSERT_EQUAL_UINT32(RtosTasks::SAMPLE_BLOCKS - 1, pool.available());
+
+    TEST_ASSERT_EQUAL_PTR(latest, channel.receive(0));
+    TEST_ASSERT_NULL(channel.receive(0));
+    pool.release(latest);
+    TEST_ASSERT_EQUAL_UINT32(RtosTasks::SAMPLE_BLOCKS, pool.available());
+}
+
+// Tasks 4 -> 5 -> 7 run in turn on one thread, so both pipelines do the same work per block.
+static void test_pipeline_throughput_against_queue_copies()
+{
+    // Before the pool: the readings were copied into Task 5's queue, out again, forwarded as a double
+    // and peeked by Task 7, a copy at every stage.
+    const auto readings_queue = xQueueCreate(1, sizeof(Readings));
+    const auto average_queue = xQueueCreate(1, sizeof(double));
+    uint32_t copied_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < BLOCKS; n++)
+    {
+        const auto produced = make_readings(n);
+        xQueueSend(readings_queue, &produced, 0);
+
+        Readings filtering;
+        xQueueReceive(readings_queue, &filtering, 0);
+        double average = 0.0;
+        for (const auto reading : filtering)
+            average += reading;
+        average /= filtering.size();
+        xQueueOverwrite(average_queue, &average);
+
+        double evaluated;
+        xQueuePeek(average_queue, &evaluated, 0);
+        copied_sum += static_cast<uint32_t>(evaluated);
+    }
+    const auto copied_rate = blocks_per_second(start);
+
+    Pool pool;
+    Channel readings_channel(pool);
+    Channel filtered_channel(pool);
+    uint32_t pooled_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < BLOCKS; n++)
+    {
+        const auto produced = pool.acquire();
+        produced->readings = make_readings(n);
+        readings_channel.publish(produced);
+
+        const auto filtering = readings_channel.receive(0);
+        uint32_t sum = 0;
+        for (const auto reading : filtering->readings)
+            sum += reading;
+        filtering->filtered = Units::AdcCounts::from_counts(static_cast<int32_t>(sum / filtering->readings.size()));
+        filtered_channel.publish(filtering);
+
+        const auto evaluated = filtered_channel.receive(0);
+        pooled_sum += static_cast<uint32_t>(evaluated->filtered.whole_counts());
+        pool.release(evaluated);
+    }
+    const auto pooled_rate = blocks_per_second(start);
+
+    char message[128];
+    snprintf(message, sizeof(message), "blocks/s: queue copies %.0f, block pool %.0f", copied_rate, pooled_rate);
+    TEST_MESSAGE(message);
+
+    // Every block went back to the pool and both pipelines saw the same data.
+    TEST_ASSERT_EQUAL_UINT32(RtosTasks::SAMPLE_BLOCKS, pool.available());
+    TEST_ASSERT_EQUAL_UINT32(copied_sum, pooled_sum);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_acquire_hands_out_every_block_once);
+    RUN_TEST(test_block_returns_on_the_last_release);
+    RUN_TEST(test_channel_keeps_the_latest_block_and_releases_the_stale_one);
+    RUN_TEST(test_pipeline_throughput_against_queue_copies);
+    return UNITY_END();
+}
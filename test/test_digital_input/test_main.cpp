@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unity.h>
+
+#include "digital_input.hpp"
+#include "platform.hpp"
+#include "simulated_hal.hpp"
+
+// Unclaimed by the firmware, so the presses here cannot disturb anything else.
+constexpr int8_t TEST_PIN = 23;
+constexpr Milliseconds DEBOUNCE = 20.0;
+
+// Ten presses, 100 ms apart and held for 50 ms; every press and release bounces four times before
+// settling, so each debounced change arrives as five raw edges.
+constexpr uint32_t PRESSES = 10;
+constexpr uint32_t PRESS_PERIOD_US = 100000;
+constexpr uint32_t HELD_US = 50000;
+constexpr uint32_t EDGES_PER_TRANSITION = 5;
+constexpr uint32_t BOUNCE_US = 300;
+constexpr uint32_t POLL_PERIOD_US = 200000; // the 5 Hz polling Task 2 did before the dispatcher
+
+// The simulated interrupt controller polls every 10 us, but the host may preempt it; this is the
+// slack allowed between an edge and its timestamp.
+constexpr uint32_t TIMESTAMP_TOLERANCE_US = 2000;
+// Simulated interrupts reach the kernel from a one-tick timer on the host; on the ESP32 the ISR
+// notifies directly. Either way, far inside the old 200 ms polling period.
+constexpr uint32_t LATENCY_LIMIT_US = 10000;
+
+static uint32_t start_us = 0;
+
+// Level at `elapsed` microseconds into the sequence, bounces included.
+static bool bouncing_button(const uint32_t elapsed)
+{
+    const auto press = elapsed / PRESS_PERIOD_US;
+    if (press >= PRESSES)
+        return false;
+    const auto within = elapsed % PRESS_PERIOD_US;
+    const auto pressed = within < HELD_US;
+    const auto since_transition = pressed ? within : within - HELD_US;
+    const auto edges_so_far = std::min(EDGES_PER_TRANSITION, since_transition / BOUNCE_US + 1);
+    // An odd number of edges leaves the pin at the new level.
+    return (edges_so_far % 2 == 1) == pressed;
+}
+
+// When the transition the n-th debounced change belongs to began.
+static uint32_t transition_us(const uint32_t change)
+{
+    const auto press = (change - 1) / 2;
+    return start_us + press * PRESS_PERIOD_US + ((change % 2 == 1) ? 0 : HELD_US);
+}
+
+static uint32_t now_us()
+{
+    return Hal::simulated().micros().count();
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_bouncing_presses_wake_the_subscriber_once_per_change()
+{
+    auto &hal = Hal::simulated();
+    auto &inputs = DigitalInput::dispatcher();
+    hal.set_digital_source(TEST_PIN, [](const Microseconds) { return false; });
+    const auto bit = inputs.watch(TEST_PIN, DEBOUNCE, xTaskGetCurrentTaskHandle());
+    TEST_ASSERT_NOT_EQUAL(0, bit);
+
+    start_us = now_us() + 10000;
+    // Sources see the host clock; reduce it to micros()'s wrapping count to compare with start_us.
+    hal.set_digital_source(TEST_PIN, [](const Microseconds now) {
+        const auto elapsed = static_cast<uint32_t>(static_cast<uint64_t>(now)) - start_us;
+        return static_cast<int32_t>(elapsed) >= 0 && bouncing_button(elapsed);
+    });
+
+    uint32_t wake_ups = 0, worst_latency_us = 0, worst_timestamp_error_us = 0;
+    uint64_t total_latency_us = 0;
+    DigitalInput::Event event = {};
+    const auto end_ticks = pdMS_TO_TICKS((PRESSES * PRESS_PERIOD_US) / 1000 + 100);
+    const auto started = xTaskGetTickCount();
+    while (xTaskGetTickCount() - started < end_ticks)
+    {
+        uint32_t notified = 0;
+        if (!xTaskNotifyWait(0, bit, &notified, pdMS_TO_TICKS(10)) || !(notified & bit))
+            continue;
+        const auto woken_us = now_us();
+        wake_ups++;
+        TEST_ASSERT_TRUE(inputs.latest(TEST_PIN, event));
+        TEST_ASSERT_EQUAL(event.changes % 2 == 1, event.level);
+
+        const auto latency_us = woken_us - event.timestamp;
+        total_latency_us += latency_us;
+        worst_latency_us = std::max(worst_latency_us, latency_us);
+        const auto timestamp_error_us = event.timestamp - transition_us(event.changes);
+        worst_timestamp_error_us = std::max(worst_timestamp_error_us, timestamp_error_us);
+    }
+
+    const auto raw_edges = PRESSES * 2 * EDGES_PER_TRANSITION;
+    const auto polls = PRESSES * PRESS_PERIOD_US / POLL_PERIOD_US;
+    char message[192];
+    snprintf(message, sizeof(message),
+             "wake-ups: %u (one per raw edge: %u, 5 Hz polling: %u), latency mean %u us, worst %u us",
+             static_cast<unsigned>(wake_ups), static_cast<unsigned>(raw_edges), static_cast<unsigned>(polls),
+             static_cast<unsigned>(wake_ups ? total_latency_us / wake_ups : 0), static_cast<unsigned>(worst_latency_us));
+    TEST_MESSAGE(message);
+
+    // Every press and release was seen exactly once, and the bounces were counted but swallowed. The
+    // event's edge count is taken when the last release is accepted, before its bounces. A preempted
+    // interrupt poller can merge bounces, but every change is at least one edge.
+    TEST_ASSERT_EQUAL_UINT32(PRESSES * 2, event.changes);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(raw_edges - (EDGES_PER_TRANSITION - 1), event.edges);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(event.changes, event.edges);
+    TEST_ASSERT_EQUAL_UINT32(PRESSES * 2, wake_ups);
+    TEST_ASSERT_FALSE(event.level);
+    TEST_ASSERT_LESS_THAN_UINT32(TIMESTAMP_TOLERANCE_US, worst_timestamp_error_us);
+    TEST_ASSERT_LESS_THAN_UINT32(LATENCY_LIMIT_US, worst_latency_us);
+}
+
+static void run_tests(void *)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bouncing_presses_wake_the_subscriber_once_per_change);
+    exit(UNITY_END());
+}
+
+int main()
+{
+    // The dispatcher needs the timer service and task notifications, so the tests run in a task.
+    static StaticTask_t tcb;
+    static StackType_t stack[configMINIMAL_STACK_SIZE];
+    xTaskCreateStatic(run_tests, "tests", configMINIMAL_STACK_SIZE, nullptr, 2, stack, &tcb);
+    vTaskStartScheduler();
+    return 1;
+}
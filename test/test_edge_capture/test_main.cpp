@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include <unity.h>
+
+#include "edge_capture.hpp"
+#include "simulated_hal.hpp"
+
+// Unclaimed by the firmware, so the simulated square wave here cannot disturb anything else.
+constexpr int8_t TEST_PIN = 23;
+constexpr uint32_t PERIOD_US = 2000; // 500 Hz
+constexpr size_t WINDOW = 8;
+
+using Capture = EdgeCapture::EdgeCapture<32>;
+
+static void push_edges(Capture &capture, uint32_t first, const size_t count, const uint32_t period)
+{
+    for (size_t i = 0; i < count; i++, first += period)
+        capture.push(first);
+}
+
+// What Task 3 did before edge capture: half a period from one pulseIn() of the high phase.
+static uint32_t nanoseconds_since(const std::chrono::steady_clock::time_point start, const int calls)
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / calls);
+}
+
+static uint32_t pulse_in_millihertz(Hal::Hal &hal)
+{
+    const auto high_time = hal.pulse_in(TEST_PIN, true, Units::Microseconds(2 * PERIOD_US)).count();
+    return (high_time == 0) ? 0 : static_cast<uint32_t>((UINT64_C(1000000000) + high_time) / (2 * high_time));
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_reports_nothing_until_a_full_window_is_captured()
+{
+    Capture capture;
+    push_edges(capture, 1000, WINDOW, PERIOD_US);
+    TEST_ASSERT_EQUAL_UINT32(0, capture.frequency(WINDOW, 1000 + WINDOW * PERIOD_US).count());
+
+    capture.push(1000 + WINDOW * PERIOD_US);
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(WINDOW, 1000 + WINDOW * PERIOD_US).count());
+}
+
+static void test_averages_jittered_edges_over_the_window()
+{
+    // +-20 us of edge jitter; the window mean only sees the jitter of its two end edges.
+    constexpr int32_t JITTER[] = {0, 17, -20, 5, 11, -9, 20, -14, 3, -6, 19, -18, 8};
+    Capture capture;
+    uint32_t newest = 0;
+    for (size_t i = 0; i < sizeof(JITTER) / sizeof(JITTER[0]); i++)
+    {
+        newest = 5000 + static_cast<uint32_t>(i) * PERIOD_US + JITTER[i];
+        capture.push(newest);
+    }
+    // Two end edges up to 20 us off over a 16 ms window: within 0.25 %.
+    TEST_ASSERT_UINT32_WITHIN(1250, 500000, capture.frequency(WINDOW, newest).count());
+}
+
+static void test_handles_microsecond_counter_wrap_around()
+{
+    constexpr uint32_t FIRST = UINT32_MAX - 5 * PERIOD_US;
+    Capture capture;
+    push_edges(capture, FIRST, WINDOW + 1, PERIOD_US);
+    const uint32_t newest = FIRST + static_cast<uint32_t>(WINDOW) * PERIOD_US; // wrapped
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(WINDOW, newest).count());
+}
+
+static void test_reports_zero_once_the_signal_stops()
+{
+    Capture capture;
+    push_edges(capture, 0, WINDOW + 1, PERIOD_US);
+    const uint32_t newest = WINDOW * PERIOD_US;
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(WINDOW, newest + 2 * PERIOD_US).count());
+    TEST_ASSERT_EQUAL_UINT32(0, capture.frequency(WINDOW, newest + 2 * PERIOD_US + 1).count());
+}
+
+// Task 3 reads the clock before it calls frequency(), so an edge can land in between.
+static void test_edge_newer_than_now_counts_as_live()
+{
+    Capture capture;
+    push_edges(capture, 1000, WINDOW + 1, PERIOD_US);
+    const uint32_t newest = 1000 + WINDOW * PERIOD_US;
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(WINDOW, newest - 1).count());
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(WINDOW, newest - 3 * PERIOD_US).count());
+}
+
+// The smallest ring, read while another thread pushes with gaps of varying length: the writer laps
+// the reader often, and any torn window would show up as a frequency other than 500 Hz.
+static void test_lapped_reader_never_sees_a_torn_window()
+{
+    constexpr uint32_t EDGES = 500000; // timestamps stay below 2^31, so now = 0 is never stale
+    EdgeCapture::EdgeCapture<4> capture;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (uint32_t i = 0; i < EDGES; i++)
+        {
+            capture.push(i * PERIOD_US);
+            for (volatile uint32_t gap = 0; gap < i % 64; gap++)
+            {
+            }
+        }
+        done = true;
+    });
+
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    while (!done)
+    {
+        const auto frequency = capture.frequency(2, 0).count();
+        reads += frequency != 0;
+        torn += frequency != 0 && frequency != 500000;
+    }
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, reads);
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(2, 0).count());
+}
+
+static void test_window_is_clamped_to_the_ring_capacity()
+{
+    Capture capture;
+    push_edges(capture, 0, 64, PERIOD_US);
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(1000, 63 * PERIOD_US).count());
+    TEST_ASSERT_EQUAL_UINT32(500000, capture.frequency(0, 63 * PERIOD_US).count());
+}
+
+static void test_costs_less_per_call_than_pulse_in()
+{
+    constexpr int CALLS = 10000;
+    constexpr int PULSE_IN_CALLS = 20;
+
+    Capture capture;
+    push_edges(capture, 0, 64, PERIOD_US);
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++)
+        sink += capture.frequency(WINDOW, 63 * PERIOD_US).count();
+    const auto capture_ns = nanoseconds_since(start, CALLS);
+    TEST_ASSERT_EQUAL_UINT32(CALLS * 500000u, sink);
+
+    auto &hal = Hal::simulated();
+    hal.set_square_wave(TEST_PIN, 1e6 / PERIOD_US);
+    uint32_t pulse_in_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < PULSE_IN_CALLS; i++)
+        pulse_in_sum += pulse_in_millihertz(hal) / PULSE_IN_CALLS;
+    const auto pulse_in_ns = nanoseconds_since(start, PULSE_IN_CALLS);
+
+    char message[128];
+    snprintf(message, sizeof(message), "frequency(): %u ns/call, pulseIn: %u ns/call (%u mHz)",
+             static_cast<unsigned>(capture_ns), static_cast<unsigned>(pulse_in_ns), static_cast<unsigned>(pulse_in_sum));
+    TEST_MESSAGE(message);
+
+    // pulseIn() waits for a rising edge and then the whole high phase: at least half a period per call,
+    // and a period on average.
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(PERIOD_US * 1000u / 2, pulse_in_ns);
+    TEST_ASSERT_LESS_THAN_UINT32(pulse_in_ns / 100, capture_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_reports_nothing_until_a_full_window_is_captured);
+    RUN_TEST(test_averages_jittered_edges_over_the_window);
+    RUN_TEST(test_handles_microsecond_counter_wrap_around);
+    RUN_TEST(test_reports_zero_once_the_signal_stops);
+    RUN_TEST(test_edge_newer_than_now_counts_as_live);
+    RUN_TEST(test_lapped_reader_never_sees_a_torn_window);
+    RUN_TEST(test_window_is_clamped_to_the_ring_capacity);
+    RUN_TEST(test_costs_less_per_call_than_pulse_in);
+    return UNITY_END();
+}
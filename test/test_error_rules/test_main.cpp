@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <random>
+
+#include <unity.h>
+
+#include "rtos_tasks.hpp"
+
+using RtosTasks::ErrorEvaluator;
+using Units::AdcCounts;
+
+constexpr uint32_t EVALUATIONS = 3000; // over 16 minutes of Task 7 periods
+constexpr int32_t HALF_SCALE = 4095 / 2;
+
+// A steady window: no noise and no drift, so only the level rules can act.
+static ErrorRules::Inputs steady(const int32_t level)
+{
+    ErrorRules::Inputs inputs = {};
+    inputs.level = AdcCounts::from_counts(level);
+    inputs.statistics.samples = RtosTasks::ANALOGUE_STATISTICS_WINDOW;
+    inputs.statistics.mean = inputs.level;
+    inputs.statistics.standard_deviation = AdcCounts::from_counts(0);
+    return inputs;
+}
+
+// Changes of the code over a run of the evaluator against `level`, and the same for the single
+// threshold Task 7 used before the rules.
+struct Transitions
+{
+    uint32_t evaluator = 0;
+    uint32_t single_threshold = 0;
+};
+
+template <typename Level>
+static Transitions count_transitions(Level &&level)
+{
+    ErrorEvaluator evaluator;
+    Transitions transitions;
+    uint8_t code = 0;
+    bool above = false;
+    for (uint32_t n = 0; n < EVALUATIONS; n++)
+    {
+        const auto counts = level(n);
+        const auto next_code = evaluator.evaluate(steady(counts));
+        transitions.evaluator += next_code != code;
+        code = next_code;
+        const auto next_above = counts > HALF_SCALE;
+        transitions.single_threshold += next_above != above;
+        above = next_above;
+    }
+    return transitions;
+}
+
+static void report(const char *name, const Transitions &transitions)
+{
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %u code changes, single threshold %u", name,
+             static_cast<unsigned>(transitions.evaluator), static_cast<unsigned>(transitions.single_threshold));
+    TEST_MESSAGE(message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_code_needs_persistence_to_raise_and_to_clear()
+{
+    ErrorEvaluator evaluator;
+    TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(steady(2500)));
+    TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(steady(2500)));
+    TEST_ASSERT_EQUAL_UINT8(1, evaluator.evaluate(steady(2500)));
+
+    // Back inside the band holds the code; below it, the code clears after as many evaluations.
+    TEST_ASSERT_EQUAL_UINT8(1, evaluator.evaluate(steady(2000)));
+    TEST_ASSERT_EQUAL_UINT8(1, evaluator.evaluate(steady(1900)));
+    TEST_ASSERT_EQUAL_UINT8(1, evaluator.evaluate(steady(1900)));
+    TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(steady(1900)));
+}
+
+static void test_an_interrupted_run_starts_the_count_again()
+{
+    ErrorEvaluator evaluator;
+    for (int repeat = 0; repeat < 10; repeat++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(steady(2500)));
+        TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(steady(2500)));
+        TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(steady(2100)));
+    }
+}
+
+static void test_first_active_rule_sets_the_code()
+{
+    ErrorEvaluator evaluator;
+    uint8_t code = 0;
+    for (int n = 0; n < 3; n++)
+        code = evaluator.evaluate(steady(4000));
+    TEST_ASSERT_EQUAL_UINT8(4, code); // rules 4 and 1 are both active
+
+    auto noisy = steady(1900);
+    noisy.statistics.standard_deviation = AdcCounts::from_counts(300);
+    for (int n = 0; n < 5; n++)
+        code = evaluator.evaluate(noisy);
+    TEST_ASSERT_EQUAL_UINT8(3, code); // 4 and 1 have cleared, noise persists
+}
+
+static void test_window_rules_wait_for_statistics()
+{
+    ErrorEvaluator evaluator;
+    auto inputs = steady(1000);
+    inputs.statistics = {};
+    inputs.statistics.standard_deviation = AdcCounts::from_counts(1000);
+    for (int n = 0; n < 10; n++)
+        TEST_ASSERT_EQUAL_UINT8(0, evaluator.evaluate(inputs));
+}
+
+// The input hovers around half scale with uniform noise narrower than the band.
+static void test_noise_around_a_threshold_does_not_flap()
+{
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<int32_t> noise(-150, 150);
+    const auto transitions = count_transitions([&](uint32_t) { return HALF_SCALE + 50 + noise(generator); });
+    report("noise around the raise threshold", transitions);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, transitions.evaluator);
+    TEST_ASSERT_GREATER_THAN_UINT32(100, transitions.single_threshold);
+}
+
+// Noise wider than the band does move the code, but only on runs that persist.
+static void test_noise_wider_than_the_band_changes_the_code_rarely()
+{
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<int32_t> noise(-300, 300);
+    const auto transitions = count_transitions([&](uint32_t) { return HALF_SCALE - 50 + noise(generator); });
+    report("noise across the band", transitions);
+    TEST_ASSERT_LESS_THAN_UINT32(transitions.single_threshold / 10, transitions.evaluator);
+}
+
+// A slow ramp through the band with noise on it: one raise on the way up, one clear on the way down.
+static void test_noisy_ramp_changes_the_code_once_each_way()
+{
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<int32_t> noise(-60, 60);
+    const auto transitions = count_transitions([&](const uint32_t n) {
+        const auto half = EVALUATIONS / 2;
+        const auto position = static_cast<int32_t>(n < half ? n : EVALUATIONS - n);
+        return 1700 + position * 700 / static_cast<int32_t>(half) + noise(generator);
+    });
+    report("noisy ramp", transitions);
+    TEST_ASSERT_EQUAL_UINT32(2, transitions.evaluator);
+    TEST_ASSERT_GREATER_THAN_UINT32(2, transitions.single_threshold);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_code_needs_persistence_to_raise_and_to_clear);
+    RUN_TEST(test_an_interrupted_run_starts_the_count_again);
+    RUN_TEST(test_first_active_rule_sets_the_code);
+    RUN_TEST(test_window_rules_wait_for_statistics);
+    RUN_TEST(test_noise_around_a_threshold_does_not_flap);
+    RUN_TEST(test_noise_wider_than_the_band_changes_the_code_rarely);
+    RUN_TEST(test_noisy_ramp_changes_the_code_once_each_way);
+    return UNITY_END();
+}
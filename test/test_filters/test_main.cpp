@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <unity.h>
+
+#include "filters.hpp"
+#include "units.hpp"
+
+constexpr size_t SAMPLES = 20000;
+constexpr double SAMPLE_RATE = 96.0; // Task 5 sees four readings per 24 Hz block
+
+// A slow sweep across the ADC range with noise, as the analogue input sees it.
+static std::vector<uint16_t> make_signal()
+{
+    std::mt19937 generator(5);
+    std::normal_distribution<double> noise(0.0, 40.0);
+    std::vector<uint16_t> signal(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        const double value = 2047.5 + 1800.0 * std::sin(2.0 * M_PI * 0.5 * i / SAMPLE_RATE) + noise(generator);
+        signal[i] = static_cast<uint16_t>(std::min(4095.0, std::max(0.0, std::round(value))));
+    }
+    return signal;
+}
+
+// What compute_filtered_analogue_signal() did before the filter library: a double average of the
+// last four readings, recomputed in full for every output.
+static double reference_moving_average(const std::array<uint16_t, 4> &readings)
+{
+    return std::accumulate(readings.begin(), readings.end(), 0.0) / readings.size();
+}
+
+template <size_t TAPS>
+static std::vector<double> reference_fir(const std::vector<uint16_t> &signal, const std::array<double, TAPS> &taps)
+{
+    std::vector<double> output(signal.size());
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        double acc = 0.0;
+        for (size_t k = 0; k < TAPS && k <= i; k++)
+            acc += taps[k] * signal[i - k];
+        output[i] = acc;
+    }
+    return output;
+}
+
+static std::vector<double> reference_biquad(const std::vector<uint16_t> &signal, const Filters::Biquad<>::Coefficients &c)
+{
+    std::vector<double> output(signal.size());
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        const double y = c.b0 * signal[i] + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+        x2 = x1;
+        x1 = signal[i];
+        y2 = y1;
+        y1 = y;
+        output[i] = y;
+    }
+    return output;
+}
+
+// RBJ cookbook low-pass, normalised so a0 == 1.
+template <typename Coefficient = float>
+static typename Filters::Biquad<Coefficient>::Coefficients low_pass(const double cutoff, const double q)
+{
+    const double w0 = 2.0 * M_PI * cutoff / SAMPLE_RATE;
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a0 = 1.0 + alpha;
+    const double b1 = (1.0 - std::cos(w0)) / a0;
+    return {b1 / 2.0, b1, b1 / 2.0, -2.0 * std::cos(w0) / a0, (1.0 - alpha) / a0};
+}
+
+constexpr std::array<double, 8> FIR_TAPS = {0.02, 0.08, 0.15, 0.25, 0.25, 0.15, 0.08, 0.02};
+
+template <typename Filter>
+static double worst_error(Filter &filter, const std::vector<uint16_t> &signal, const std::vector<double> &reference)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        filter.push(signal[i]);
+        worst = std::max(worst, std::fabs(static_cast<double>(filter.output()) - reference[i]));
+    }
+    return worst;
+}
+
+template <typename Step>
+static double nanoseconds_per_sample(Step &&step)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < SAMPLES; i++)
+        step(i);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / SAMPLES;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_moving_average_matches_the_double_reference()
+{
+    const auto signal = make_signal();
+    Filters::MovingAverage<4> filter;
+    std::array<uint16_t, 4> window = {};
+    for (size_t i = 0; i < signal.size(); i++)
+    {
+        filter.push(signal[i]);
+        window[i % 4] = signal[i];
+        const double expected = reference_moving_average(window);
+        // mean<8>() truncates to 1/256 of a count.
+        const double actual = filter.mean<Units::AdcCounts::FRACTIONAL_BITS>() / 256.0;
+        TEST_ASSERT_TRUE(actual <= expected && expected - actual < 1.0 / 256.0);
+    }
+}
+
+static void test_fixed_point_fir_tracks_the_double_reference()
+{
+    const auto signal = make_signal();
+    const auto reference = reference_fir(signal, FIR_TAPS);
+
+    Filters::Fir<8, Filters::Q15> q15(FIR_TAPS);
+    Filters::Fir<8, Filters::Q31> q31(FIR_TAPS);
+    Filters::Fir<8, float> single(FIR_TAPS);
+    // Q15 coefficients are within 2^-16 of the design; eight taps of up to 4095 counts plus output
+    // rounding bound the error at 1 count.
+    TEST_ASSERT_TRUE(worst_error(q15, signal, reference) <= 1.0);
+    TEST_ASSERT_TRUE(worst_error(q31, signal, reference) <= 0.5 + 1e-6);
+    TEST_ASSERT_TRUE(worst_error(single, signal, reference) < 0.01);
+}
+
+static void test_fixed_point_biquad_tracks_the_double_reference()
+{
+    const auto signal = make_signal();
+    const auto reference = reference_biquad(signal, low_pass(8.0, M_SQRT1_2));
+
+    Filters::Biquad<Filters::Q2_29> q2_29(low_pass<Filters::Q2_29>(8.0, M_SQRT1_2));
+    Filters::Biquad<float> single(low_pass(8.0, M_SQRT1_2));
+    // The fixed-point output is rounded to whole counts and fed back, so its half-count rounding error is
+    // amplified by the sum of the feedback path's impulse response: 5.6 for this design, or 2.8 counts.
+    const double fixed_error = worst_error(q2_29, signal, reference);
+    const double float_error = worst_error(single, signal, reference);
+    char message[96];
+    snprintf(message, sizeof(message), "biquad worst error: Q2.29 %.3f counts, float %.4f counts", fixed_error, float_error);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(fixed_error <= 2.8);
+    TEST_ASSERT_TRUE(float_error < 0.05);
+}
+
+static void test_coefficients_saturate_instead_of_wrapping()
+{
+    using Maths = Filters::Arithmetic<Filters::Q15>;
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, Maths::coefficient(1.0));
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, Maths::coefficient(-1.5));
+    TEST_ASSERT_EQUAL_INT16(16384, Maths::coefficient(0.5));
+}
+
+static void test_cost_per_sample_against_the_double_reference()
+{
+    const auto signal = make_signal();
+    volatile double double_sink = 0.0;
+    volatile int32_t integer_sink = 0;
+
+    std::array<uint16_t, 4> window = {};
+    const double reference_ns = nanoseconds_per_sample([&](const size_t i) {
+        window[i % 4] = signal[i];
+        double_sink = reference_moving_average(window);
+    });
+    Filters::MovingAverage<4> moving_average;
+    const double moving_average_ns = nanoseconds_per_sample([&](const size_t i) {
+        moving_average.push(signal[i]);
+        integer_sink = moving_average.mean<Units::AdcCounts::FRACTIONAL_BITS>();
+    });
+    Filters::Fir<8, Filters::Q15> fir(FIR_TAPS);
+    const double fir_ns = nanoseconds_per_sample([&](const size_t i) {
+        fir.push(signal[i]);
+        integer_sink = fir.output();
+    });
+    Filters::Biquad<Filters::Q2_29> biquad(low_pass<Filters::Q2_29>(8.0, M_SQRT1_2));
+    const double biquad_ns = nanoseconds_per_sample([&](const size_t i) {
+        biquad.push(signal[i]);
+        integer_sink = biquad.output();
+    });
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "ns/sample: double average %.1f, MovingAverage<4> %.1f, Fir<8, Q15> %.1f, Biquad<Q2_29> %.1f",
+             reference_ns, moving_average_ns, fir_ns, biquad_ns);
+    TEST_MESSAGE(message);
+    (void)double_sink;
+    (void)integer_sink;
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_moving_average_matches_the_double_reference);
+    RUN_TEST(test_fixed_point_fir_tracks_the_double_reference);
+    RUN_TEST(test_fixed_point_biquad_tracks_the_double_reference);
+    RUN_TEST(test_coefficients_saturate_instead_of_wrapping);
+    RUN_TEST(test_cost_per_sample_against_the_double_reference);
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdio>
+
+#include <unity.h>
+
+#include "gpio_pin.hpp"
+#include "simulated_hal.hpp"
+
+// Unclaimed by the firmware, so the writes here cannot disturb anything else.
+constexpr int8_t TEST_PIN = 23;
+using TestOutput = Gpio::Pin<TEST_PIN, Hal::PinMode::Output>;
+using TestInput = Gpio::Pin<TEST_PIN, Hal::PinMode::Input>;
+
+constexpr uint32_t WRITES = 1000000;
+
+static_assert(TestOutput::number == TEST_PIN && TestOutput::mode == Hal::PinMode::Output, "Pins carry their number and mode.");
+static_assert(Gpio::exists(23) && !Gpio::exists(24) && !Gpio::exists(6) && !Gpio::exists(40), "Unbonded and flash pins do not exist.");
+static_assert(Gpio::can_drive(33) && !Gpio::can_drive(34), "GPIOs 34-39 are input only.");
+
+void setUp()
+{
+    Hal::simulated().set_digital_source(TEST_PIN, nullptr);
+    Hal::simulated().clear_recorded_edges();
+}
+
+void tearDown() {}
+
+static void test_writes_go_through_the_simulated_hal()
+{
+    auto &hal = Hal::simulated();
+    TestOutput::configure();
+    const auto writes_before = hal.write_count(TEST_PIN);
+
+    TestOutput::set();
+    TEST_ASSERT_TRUE(hal.output_level(TEST_PIN));
+    TestOutput::clear();
+    TEST_ASSERT_FALSE(hal.output_level(TEST_PIN));
+    TestOutput::write(true);
+    TEST_ASSERT_TRUE(hal.output_level(TEST_PIN));
+    TestOutput::write(true); // a write, but not an edge
+    TestOutput::write(false);
+
+    TEST_ASSERT_EQUAL_UINT32(writes_before + 5, hal.write_count(TEST_PIN));
+    const auto edges = hal.recorded_edges();
+    TEST_ASSERT_EQUAL_UINT32(4, edges.size());
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_INT8(TEST_PIN, edges[i].pin_id);
+        TEST_ASSERT_EQUAL(i % 2 == 0, edges[i].level);
+    }
+}
+
+static void test_read_follows_the_pin_source()
+{
+    auto &hal = Hal::simulated();
+    TestInput::configure();
+    hal.set_digital_source(TEST_PIN, [](const Microseconds) { return true; });
+    TEST_ASSERT_TRUE(TestInput::read());
+    hal.set_digital_source(TEST_PIN, [](const Microseconds) { return false; });
+    TEST_ASSERT_FALSE(TestInput::read());
+}
+
+template <typename Write>
+static double nanoseconds_per_write(Write &&write)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < WRITES; n++)
+        write(n & 1);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / WRITES;
+}
+
+// On the host both paths end in SimulatedHal::digital_write(), so this bounds the cost Pin adds; on
+// the ESP32 Pin is a single register store instead of digitalWrite()'s lookup and checks.
+static void test_pin_write_cost_against_the_hal()
+{
+    auto &hal = Hal::simulated();
+    TestOutput::configure();
+    const auto writes_before = hal.write_count(TEST_PIN);
+
+    const auto hal_ns = nanoseconds_per_write([](const bool level) { Hal::get().digital_write(TEST_PIN, level); });
+    const auto pin_ns = nanoseconds_per_write([](const bool level) { TestOutput::write(level); });
+
+    char message[96];
+    snprintf(message, sizeof(message), "ns/write: Hal::digital_write %.1f, Pin::write %.1f", hal_ns, pin_ns);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(writes_before + 2 * WRITES, hal.write_count(TEST_PIN));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_writes_go_through_the_simulated_hal);
+    RUN_TEST(test_read_follows_the_pin_source);
+    RUN_TEST(test_pin_write_cost_against_the_hal);
+    return UNITY_END();
+}
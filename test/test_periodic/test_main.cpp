@@ -0,0 +1,114 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unity.h>
+
+#include "common.hpp"
+#include "periodic.hpp"
+
+constexpr uint64_t HOURS = 10;
+
+static uint64_t releases_in(const uint64_t hours, const Periodic::Period &period)
+{
+    return hours * 3600000000ull * period.denominator() / period.numerator_us();
+}
+
+// Every release over the run must be within half a microsecond of the exact multiple of the period,
+// and every tick wait must land in the tick the release falls in.
+static void check_drift_free(const Milliseconds milliseconds, const int64_t numerator_us, const int64_t denominator)
+{
+    const Periodic::Period period(milliseconds);
+    TEST_ASSERT_EQUAL_INT64(numerator_us, period.numerator_us());
+    TEST_ASSERT_EQUAL_INT64(denominator, period.denominator());
+
+    const auto releases = releases_in(HOURS, period);
+    int64_t worst_error_halves = 0; // in half microseconds, so the bound is exact in integers
+    for (uint64_t n = 0; n <= releases; n++)
+    {
+        const auto offset = period.offset_us(n);
+        const auto exact_times_denominator = static_cast<int64_t>(n) * numerator_us;
+        const auto error_halves = std::llabs(2 * (offset * denominator - exact_times_denominator));
+        if (error_halves > worst_error_halves)
+            worst_error_halves = error_halves;
+
+        const auto tick = static_cast<int64_t>(Periodic::release_ticks(offset, Periodic::Precision::Tick));
+        const auto coarse = static_cast<int64_t>(Periodic::release_ticks(offset, Periodic::Precision::SubTick));
+        if (tick * Periodic::TICK_US < offset || tick * Periodic::TICK_US >= offset + Periodic::TICK_US ||
+            coarse * Periodic::TICK_US > offset || coarse * Periodic::TICK_US <= offset - Periodic::TICK_US)
+        {
+            TEST_FAIL_MESSAGE("Tick wait outside the tick the release falls in.");
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(denominator, worst_error_halves);
+
+    // The last release, hours in, is where the old relative delays had drifted furthest.
+    const auto last = period.offset_us(releases);
+    const auto exact = static_cast<double>(releases) * numerator_us / denominator;
+    TEST_ASSERT_TRUE(std::llabs(last - static_cast<int64_t>(exact + 0.5)) <= 1);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_task_4_period_is_held_exactly()
+{
+    check_drift_free(calculateCyclePeriodMs(24.0), 125000, 3);
+}
+
+static void test_task_1_period_is_held_exactly()
+{
+    check_drift_free(24.4, 24400, 1);
+}
+
+static void test_thirds_of_a_second_are_held_exactly()
+{
+    check_drift_free(calculateCyclePeriodMs(3.0), 1000000, 3);
+}
+
+static void test_arbitrary_periods_stay_within_a_part_per_billion()
+{
+    const Milliseconds milliseconds = 41.66671234;
+    const Periodic::Period period(milliseconds);
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(Periodic::Period::MAXIMUM_DENOMINATOR, period.denominator());
+    const double held = static_cast<double>(period.numerator_us()) / period.denominator();
+    TEST_ASSERT_TRUE(std::abs(held - milliseconds * 1000.0) / (milliseconds * 1000.0) < 1e-9);
+}
+
+static void test_index_at_inverts_offset()
+{
+    const Periodic::Period period(calculateCyclePeriodMs(24.0));
+    for (int64_t offset = 0; offset < 2000000; offset += 997)
+    {
+        const auto index = period.index_at(offset);
+        TEST_ASSERT_TRUE(period.offset_us(index) <= offset);
+        TEST_ASSERT_TRUE(period.offset_us(index + 1) > offset);
+    }
+}
+
+static void test_truncated_tick_delays_drift()
+{
+    // What the tasks did before: a relative delay of the period truncated to whole ticks.
+    const auto period = Periodic::Period(calculateCyclePeriodMs(24.0));
+    const auto ticks = period_to_number_of_ticks_to_sleep(calculateCyclePeriodMs(24.0));
+    const auto releases = releases_in(HOURS, period);
+    const auto drift_us = period.offset_us(releases) - static_cast<int64_t>(releases * ticks) * Periodic::TICK_US;
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u-tick delays run %lld s ahead of a 41.67 ms schedule after %u hours",
+             static_cast<unsigned>(ticks), static_cast<long long>(drift_us / 1000000), static_cast<unsigned>(HOURS));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN_INT64(0, drift_us);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_task_4_period_is_held_exactly);
+    RUN_TEST(test_task_1_period_is_held_exactly);
+    RUN_TEST(test_thirds_of_a_second_are_held_exactly);
+    RUN_TEST(test_arbitrary_periods_stay_within_a_part_per_billion);
+    RUN_TEST(test_index_at_inverts_offset);
+    RUN_TEST(test_truncated_tick_delays_drift);
+    return UNITY_END();
+}
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unity.h>
+
+#include "binary_log.hpp"
+#include "instrumentation.hpp"
+#include "platform.hpp"
+#include "power.hpp"
+#include "simulated_hal.hpp"
+
+using BinaryLog::Record;
+using BinaryLog::RecordType;
+
+constexpr Power::Settings LIGHT_SLEEP = {240, 80, true, 2000};
+constexpr uint32_t TOGGLES = 2000;
+
+// Clients register for good, as tasks' clients do, so they outlive every test.
+static Power::Client sensitive(1, true);
+static Power::Client insensitive(9, false);
+static Power::Client contender(4, true);
+
+static void collect(void *context, const Record &record)
+{
+    static_cast<std::vector<Record> *>(context)->push_back(record);
+}
+
+// Runs report() and returns what it logged.
+static std::vector<Record> report()
+{
+    std::vector<Record> records;
+    while (BinaryLog::drain(BinaryLog::Framing::Cobs, collect, &records) > 0)
+    {
+    }
+    records.clear();
+    Power::report();
+    while (BinaryLog::drain(BinaryLog::Framing::Cobs, collect, &records) > 0)
+    {
+    }
+    return records;
+}
+
+static const Record *find(const std::vector<Record> &records, const RecordType type, const uint8_t task)
+{
+    for (const auto &record : records)
+        if (record.type == type && record.task == task)
+            return &record;
+    return nullptr;
+}
+
+// Share of the time since begin() spent at full speed, in 0.01 %.
+static int32_t full_speed_share()
+{
+    const auto records = report();
+    const auto levels = find(records, RecordType::PowerLevels, 0);
+    return levels ? levels->value0 : -1;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_policy()
+{
+    TEST_ASSERT_TRUE(Power::level(Power::DEFAULT_SETTINGS, 2, 0, 0) == Power::Level::FullSpeed);
+    TEST_ASSERT_TRUE(Power::level(Power::DEFAULT_SETTINGS, 0, 0, INT64_MAX) == Power::Level::Scaled);
+    TEST_ASSERT_TRUE(Power::level(LIGHT_SLEEP, 0, 1000, 2999) == Power::Level::Scaled);
+    TEST_ASSERT_TRUE(Power::level(LIGHT_SLEEP, 0, 1000, INT64_MAX) == Power::Level::LightSleep);
+    TEST_ASSERT_TRUE(Power::level(LIGHT_SLEEP, 1, 1000, INT64_MAX) == Power::Level::FullSpeed);
+}
+
+static void test_report_says_power_management_is_off_before_begin()
+{
+    TEST_ASSERT_FALSE(Power::active());
+    const auto records = report();
+    const auto levels = find(records, RecordType::PowerLevels, 0);
+    TEST_ASSERT_NOT_NULL(levels);
+    TEST_ASSERT_EQUAL_UINT16(0, levels->aux);
+    TEST_ASSERT_EQUAL_INT32(0, levels->value0);
+}
+
+// Busy for one period, idle for the next: half the time at full speed.
+static void test_latency_sensitive_client_holds_full_speed_while_busy()
+{
+    TEST_ASSERT_TRUE(Power::begin());
+    TEST_ASSERT_TRUE(Power::active());
+
+    for (int cycle = 0; cycle < 5; cycle++)
+    {
+        const auto release = Instrumentation::time_us();
+        sensitive.awake(release);
+        vTaskDelay(pdMS_TO_TICKS(20));
+        sensitive.sleep_until(release + 40000);
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    const auto share = full_speed_share();
+    TEST_ASSERT_INT32_WITHIN(1000, 5000, share);
+
+    // Only latency-sensitive clients raise the level.
+    for (int cycle = 0; cycle < 5; cycle++)
+    {
+        const auto release = Instrumentation::time_us();
+        insensitive.awake(release);
+        vTaskDelay(pdMS_TO_TICKS(20));
+        insensitive.sleep_until(release + 40000);
+    }
+    TEST_ASSERT_LESS_THAN_INT32(share, full_speed_share());
+}
+
+static void test_wake_latency_is_measured_against_the_release()
+{
+    Power::WakeLatency latency;
+    TEST_ASSERT_FALSE(contender.wake_latency(latency));
+
+    contender.awake(Instrumentation::time_us() - 3000);
+    contender.sleep_until(INT64_MAX);
+    TEST_ASSERT_TRUE(contender.wake_latency(latency));
+    TEST_ASSERT_EQUAL_UINT32(1, latency.wakes);
+    TEST_ASSERT_UINT32_WITHIN(1000, 3500, latency.maximum_us);
+
+    const auto records = report();
+    const auto logged = find(records, RecordType::WakeLatency, 4);
+    TEST_ASSERT_NOT_NULL(logged);
+    TEST_ASSERT_EQUAL_UINT16(1, logged->aux);
+    TEST_ASSERT_EQUAL_INT32(static_cast<int32_t>(latency.maximum_us), logged->value0);
+    TEST_ASSERT_NOT_NULL(find(records, RecordType::WakeLatency, 1));
+}
+
+static volatile bool contender_done = false;
+
+static void contend(void *)
+{
+    for (uint32_t n = 0; n < TOGGLES; n++)
+    {
+        contender.awake(Instrumentation::time_us());
+        taskYIELD();
+        contender.sleep_until(Instrumentation::time_us() + 1000);
+        taskYIELD();
+    }
+    contender_done = true;
+    vTaskDelete(nullptr);
+}
+
+// Two tasks wake and sleep against each other. Once both are asleep the level must be back down, so
+// the full-speed share falls as time passes.
+static void test_level_follows_clients_changing_concurrently()
+{
+    static StaticTask_t tcb;
+    static StackType_t stack[configMINIMAL_STACK_SIZE];
+    xTaskCreateStatic(contend, "contender", configMINIMAL_STACK_SIZE, nullptr, 2, stack, &tcb);
+    for (uint32_t n = 0; n < TOGGLES; n++)
+    {
+        sensitive.awake(Instrumentation::time_us());
+        taskYIELD();
+        sensitive.sleep_until(Instrumentation::time_us() + 1000);
+        taskYIELD();
+    }
+    while (!contender_done)
+        vTaskDelay(1);
+
+    const auto before = full_speed_share();
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_LESS_THAN_INT32(before, full_speed_share());
+}
+
+static void run_tests(void *)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_policy);
+    RUN_TEST(test_report_says_power_management_is_off_before_begin);
+    RUN_TEST(test_latency_sensitive_client_holds_full_speed_while_busy);
+    RUN_TEST(test_wake_latency_is_measured_against_the_release);
+    RUN_TEST(test_level_follows_clients_changing_concurrently);
+    exit(UNITY_END());
+}
+
+int main()
+{
+    // The drained packets are binary; keep them out of the test output.
+    Hal::simulated().set_serial_output(fopen("/dev/null", "wb"));
+    // The policy's mutex and the contending client need the scheduler, so the tests run in a task.
+    static StaticTask_t tcb;
+    static StackType_t stack[configMINIMAL_STACK_SIZE];
+    xTaskCreateStatic(run_tests, "tests", configMINIMAL_STACK_SIZE, nullptr, 2, stack, &tcb);
+    vTaskStartScheduler();
+    return 1;
+}
@@ -0,0 +1,398 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+#include <unity.h>
+
+#include "recorder.hpp"
+#include "simulated_hal.hpp"
+
+using BinaryLog::Record;
+using BinaryLog::RecordType;
+
+constexpr size_t RECORDS_PER_SECTOR = Recorder::SLOTS_PER_SECTOR - Recorder::HEADER_SLOTS;
+constexpr size_t SECTORS = Flash::FileFlash::IMAGE_SIZE / Flash::SECTOR_SIZE;
+constexpr uint32_t RECORD_INTERVAL = 10; // microseconds between records
+
+// Pages are programmed once full, and erases are never rate limited.
+constexpr Recorder::Settings KEEP_EVERYTHING = {INT64_C(1000000000000), 0, 0};
+// Not a divisor of a page or a packet, so steps stop part way through both.
+constexpr size_t EXPORT_RECORDS_PER_STEP = 7;
+
+struct Exported
+{
+    int64_t time_us;
+    Record record;
+};
+
+static char image_path[64];
+
+// Record n carries n and is stamped n record intervals after boot, which on a fresh image is also its
+// recorder time.
+static Record record(const uint32_t n)
+{
+    return {n * RECORD_INTERVAL, RecordType::ErrorCode, 0, 0, static_cast<int32_t>(n), 0};
+}
+
+static void append(Recorder::Recorder &recorder, const uint32_t first, const uint32_t end)
+{
+    for (auto n = first; n < end; n++)
+        recorder.append(record(n));
+}
+
+// Everything export_step() wrote to the serial port since the last call.
+static std::vector<uint8_t> serial_output()
+{
+    static FILE *const stream = []() {
+        const auto file = tmpfile();
+        Hal::simulated().set_serial_output(file);
+        return file;
+    }();
+    static long consumed = 0;
+    fflush(stream);
+    const auto end = ftell(stream);
+    std::vector<uint8_t> bytes(static_cast<size_t>(end - consumed));
+    fseek(stream, consumed, SEEK_SET);
+    bytes.resize(fread(bytes.data(), 1, bytes.size(), stream));
+    consumed = end;
+    return bytes;
+}
+
+static std::vector<uint8_t> cobs_decode(const std::vector<uint8_t> &frame)
+{
+    std::vector<uint8_t> output;
+    size_t i = 0;
+    while (i < frame.size())
+    {
+        const auto code = frame[i++];
+        for (uint8_t n = 1; n < code && i < frame.size(); n++)
+            output.push_back(frame[i++]);
+        if (code != 0xFF && i < frame.size())
+            output.push_back(0);
+    }
+    return output;
+}
+
+static int64_t get_time(const uint8_t *source)
+{
+    uint64_t time = 0;
+    for (size_t i = 0; i < sizeof(time); i++)
+        time |= static_cast<uint64_t>(source[i]) << (8 * i);
+    return static_cast<int64_t>(time);
+}
+
+// Decodes export packets as tools/decode_log.py does, extending each record's timestamp to recorder
+// time from the first record of its packet. Counts the packets that failed their CRC and the end
+// markers seen.
+static std::vector<Exported> decode_export(size_t &corrupt, size_t &ends)
+{
+    std::vector<Exported> records;
+    corrupt = 0;
+    ends = 0;
+    const auto bytes = serial_output();
+    std::vector<uint8_t> frame;
+    for (const auto byte : bytes)
+    {
+        if (byte != 0)
+        {
+            frame.push_back(byte);
+            continue;
+        }
+        const auto packet = cobs_decode(frame);
+        frame.clear();
+        const auto length = packet.size() - BinaryLog::PACKET_CRC_SIZE;
+        if (packet.size() < BinaryLog::EXPORT_PACKET_HEADER_SIZE + BinaryLog::PACKET_CRC_SIZE ||
+            packet[0] != BinaryLog::EXPORT_PACKET_VERSION ||
+            BinaryLog::crc16(packet.data(), length) != static_cast<uint16_t>(packet[length] | (packet[length + 1] << 8)))
+        {
+            corrupt++;
+            continue;
+        }
+        if (packet[1] == 0)
+        {
+            ends++;
+            continue;
+        }
+        const auto base_us = get_time(&packet[BinaryLog::LIVE_PACKET_HEADER_SIZE]);
+        Record first;
+        memcpy(&first, &packet[BinaryLog::EXPORT_PACKET_HEADER_SIZE], sizeof(first));
+        for (size_t i = 0; i < packet[1]; i++)
+        {
+            Exported exported;
+            memcpy(&exported.record, &packet[BinaryLog::EXPORT_PACKET_HEADER_SIZE + i * sizeof(Record)], sizeof(Record));
+            exported.time_us = base_us + static_cast<int32_t>(exported.record.timestamp - first.timestamp);
+            records.push_back(exported);
+        }
+    }
+    return records;
+}
+
+// Runs one export step, checking it kept to its budget.
+static std::vector<Exported> export_step(Recorder::Recorder &recorder, size_t &ends)
+{
+    recorder.export_step(BinaryLog::Framing::Cobs, EXPORT_RECORDS_PER_STEP);
+    size_t corrupt;
+    const auto records = decode_export(corrupt, ends);
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+    TEST_ASSERT_LESS_OR_EQUAL(EXPORT_RECORDS_PER_STEP, records.size());
+    return records;
+}
+
+static std::vector<Exported> export_range(Recorder::Recorder &recorder, const int64_t from_us, const int64_t to_us)
+{
+    recorder.begin_export(from_us, to_us);
+    std::vector<Exported> records;
+    size_t ends = 0;
+    while (recorder.exporting())
+    {
+        size_t step_ends;
+        const auto step = export_step(recorder, step_ends);
+        records.insert(records.end(), step.begin(), step.end());
+        ends += step_ends;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, ends);
+    return records;
+}
+
+static std::vector<Exported> export_everything(Recorder::Recorder &recorder)
+{
+    return export_range(recorder, INT64_MIN, INT64_MAX);
+}
+
+// The values of records [first, end) in order, oldest first.
+static std::vector<int32_t> values(const uint32_t first, const uint32_t end)
+{
+    std::vector<int32_t> result;
+    for (auto n = first; n < end; n++)
+        result.push_back(static_cast<int32_t>(n));
+    return result;
+}
+
+static std::vector<int32_t> values_of(const std::vector<Exported> &records)
+{
+    std::vector<int32_t> result;
+    for (const auto &exported : records)
+        result.push_back(exported.record.value0);
+    return result;
+}
+
+void setUp()
+{
+    const auto directory = getenv("TMPDIR");
+    snprintf(image_path, sizeof(image_path), "%s/test_recorder_XXXXXX", directory != nullptr ? directory : "/tmp");
+    const auto descriptor = mkstemp(image_path);
+    TEST_ASSERT_NOT_EQUAL(-1, descriptor);
+    close(descriptor);
+    serial_output();
+}
+
+void tearDown()
+{
+    remove(image_path);
+}
+
+// Records from the previous boot stay exportable, and recorder time carries on past them even though
+// the new boot's timestamps start again from zero.
+static void test_remount_continues_the_log()
+{
+    constexpr uint32_t FIRST_BOOT = 300;
+    constexpr uint32_t SECOND_BOOT = 100;
+    {
+        Flash::FileFlash flash;
+        TEST_ASSERT_TRUE(flash.open(image_path));
+        Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+        TEST_ASSERT_TRUE(recorder.mount());
+        append(recorder, 0, FIRST_BOOT);
+        recorder.flush();
+        TEST_ASSERT_EQUAL_UINT32(FIRST_BOOT, recorder.metrics().records_stored);
+    }
+
+    Flash::FileFlash flash;
+    TEST_ASSERT_TRUE(flash.open(image_path));
+    Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+    TEST_ASSERT_TRUE(recorder.mount());
+    for (uint32_t n = 0; n < SECOND_BOOT; n++)
+        recorder.append({n * RECORD_INTERVAL, RecordType::ErrorCode, 0, 0, static_cast<int32_t>(FIRST_BOOT + n), 0});
+
+    const auto records = export_everything(recorder);
+    TEST_ASSERT_TRUE(values_of(records) == values(0, FIRST_BOOT + SECOND_BOOT));
+    for (size_t i = 1; i < records.size(); i++)
+        TEST_ASSERT_TRUE(records[i].time_us > records[i - 1].time_us);
+    TEST_ASSERT_EQUAL_INT64((FIRST_BOOT - 1) * RECORD_INTERVAL, records[FIRST_BOOT - 1].time_us);
+
+    // Every boot starts a new sector.
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.metrics().erases);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.statistics().overwrites);
+}
+
+// Three sectors past a full pass, the three oldest have been erased a second time for the newest.
+static void test_ring_wraps_round_to_the_oldest_sector()
+{
+    constexpr uint32_t TOTAL = (SECTORS + 3) * RECORDS_PER_SECTOR;
+    Flash::FileFlash flash;
+    TEST_ASSERT_TRUE(flash.open(image_path));
+    Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+    TEST_ASSERT_TRUE(recorder.mount());
+    append(recorder, 0, TOTAL);
+
+    const auto metrics = recorder.metrics();
+    TEST_ASSERT_EQUAL_UINT32(TOTAL, metrics.records_stored);
+    TEST_ASSERT_EQUAL_UINT32(0, metrics.records_lost);
+    TEST_ASSERT_EQUAL_UINT32(SECTORS + 3, metrics.erases);
+    TEST_ASSERT_EQUAL_UINT32(2, metrics.highest_erase_count);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.statistics().overwrites);
+
+    TEST_ASSERT_TRUE(values_of(export_everything(recorder)) == values(3 * RECORDS_PER_SECTOR, TOTAL));
+
+    // A range starting in the sector just written after the wrap.
+    const auto from = TOTAL - RECORDS_PER_SECTOR - 7;
+    TEST_ASSERT_TRUE(values_of(export_range(recorder, from * RECORD_INTERVAL, INT64_MAX)) == values(from, TOTAL));
+}
+
+// An export of the oldest sector, interrupted by the writer erasing it, ends where it was rather than
+// sending records from the new pass.
+static void test_export_ends_when_the_writer_overwrites_it()
+{
+    constexpr uint32_t TOTAL = SECTORS * RECORDS_PER_SECTOR;
+    Flash::FileFlash flash;
+    TEST_ASSERT_TRUE(flash.open(image_path));
+    Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+    TEST_ASSERT_TRUE(recorder.mount());
+    append(recorder, 0, TOTAL);
+
+    recorder.begin_export(INT64_MIN, INT64_MAX);
+    size_t ends;
+    const auto first = export_step(recorder, ends);
+    TEST_ASSERT_TRUE(values_of(first) == values(0, EXPORT_RECORDS_PER_STEP));
+    append(recorder, TOTAL, TOTAL + 1);
+    const auto rest = export_step(recorder, ends);
+    TEST_ASSERT_EQUAL_UINT32(0, rest.size());
+    TEST_ASSERT_EQUAL_UINT32(1, ends);
+    TEST_ASSERT_FALSE(recorder.exporting());
+}
+
+// 'R' and 'X' commands fed byte by byte, after noise, export the range asked for and everything.
+static void test_range_export_through_the_command_parser()
+{
+    constexpr uint32_t TOTAL = 5 * RECORDS_PER_SECTOR;
+    Flash::FileFlash flash;
+    TEST_ASSERT_TRUE(flash.open(image_path));
+    Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+    TEST_ASSERT_TRUE(recorder.mount());
+    append(recorder, 0, TOTAL);
+
+    constexpr uint32_t FROM = 301;
+    constexpr uint32_t TO = 900;
+    std::vector<uint8_t> command = {'?', 0x00, 'R'};
+    for (const int64_t time : {int64_t{FROM * RECORD_INTERVAL - 5}, int64_t{TO * RECORD_INTERVAL}})
+    {
+        for (size_t i = 0; i < sizeof(time); i++)
+            command.push_back(static_cast<uint8_t>(static_cast<uint64_t>(time) >> (8 * i)));
+    }
+    Recorder::CommandParser commands;
+    size_t completed = 0;
+    for (size_t i = 0; i < command.size(); i++)
+    {
+        const auto done = commands.feed(command[i]);
+        completed += done;
+        TEST_ASSERT_EQUAL(i == command.size() - 1, done);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, completed);
+    TEST_ASSERT_TRUE(values_of(export_range(recorder, commands.from_us, commands.to_us)) == values(FROM, TO + 1));
+
+    TEST_ASSERT_TRUE(commands.feed('X'));
+    TEST_ASSERT_TRUE(values_of(export_range(recorder, commands.from_us, commands.to_us)) == values(0, TOTAL));
+
+    // A range before the first record, or ending before it, exports nothing.
+    TEST_ASSERT_EQUAL_UINT32(0, export_range(recorder, INT64_MIN, -1).size());
+}
+
+// Records that would need an erase within minimum_erase_interval_us of the last are shed and counted,
+// and a RecordsShed record ahead of the next one kept says how many and for how long.
+static void test_records_are_shed_under_the_erase_rate_limit()
+{
+    constexpr int64_t MINIMUM_ERASE_INTERVAL = 1000000;
+    constexpr uint32_t RESUMED = MINIMUM_ERASE_INTERVAL / RECORD_INTERVAL;
+    constexpr uint32_t SHED = RESUMED - RECORDS_PER_SECTOR;
+    constexpr uint32_t TOTAL = RESUMED + 10;
+    Flash::FileFlash flash;
+    TEST_ASSERT_TRUE(flash.open(image_path));
+    Recorder::Recorder recorder(&flash, {INT64_C(1000000000000), 0, MINIMUM_ERASE_INTERVAL});
+    TEST_ASSERT_TRUE(recorder.mount());
+    append(recorder, 0, TOTAL);
+
+    const auto metrics = recorder.metrics();
+    TEST_ASSERT_EQUAL_UINT32(SHED, metrics.records_shed);
+    TEST_ASSERT_EQUAL_UINT32(SHED, metrics.records_lost);
+    TEST_ASSERT_EQUAL_UINT32(2, metrics.erases);
+
+    const auto records = export_everything(recorder);
+    TEST_ASSERT_EQUAL_UINT32(TOTAL - SHED + 1, records.size());
+    for (uint32_t n = 0; n < RECORDS_PER_SECTOR; n++)
+        TEST_ASSERT_EQUAL_INT32(n, records[n].record.value0);
+    const auto &shed = records[RECORDS_PER_SECTOR];
+    TEST_ASSERT_TRUE(shed.record.type == RecordType::RecordsShed);
+    TEST_ASSERT_EQUAL_INT32(SHED, shed.record.value0);
+    TEST_ASSERT_EQUAL_INT32(SHED * RECORD_INTERVAL, shed.record.value1);
+    TEST_ASSERT_EQUAL_INT64(RESUMED * RECORD_INTERVAL, shed.time_us);
+    for (uint32_t n = RESUMED; n < TOTAL; n++)
+        TEST_ASSERT_EQUAL_INT32(n, records[n - SHED + 1].record.value0);
+}
+
+// A sector whose erase fails keeps its stale contents from the last pass. It is left as a hole: the
+// record that needed it is lost, the next sector is used instead, and exports, range searches and a
+// remount all step over it.
+static void test_failed_erase_leaves_a_hole_that_is_skipped()
+{
+    constexpr uint32_t BEFORE = (SECTORS + 3) * RECORDS_PER_SECTOR; // a full pass and three sectors
+    constexpr uint32_t LOST = BEFORE;
+    constexpr uint32_t AFTER = 3 * RECORDS_PER_SECTOR;
+    constexpr uint32_t TOTAL = LOST + 1 + AFTER;
+    std::vector<int32_t> expected = values(7 * RECORDS_PER_SECTOR, LOST);
+    const auto kept_after = values(LOST + 1, TOTAL);
+    expected.insert(expected.end(), kept_after.begin(), kept_after.end());
+
+    constexpr uint32_t FROM = LOST - 5;
+    constexpr uint32_t TO = LOST + 10;
+    std::vector<int32_t> expected_range = values(FROM, LOST);
+    const auto range_after = values(LOST + 1, TO + 1);
+    expected_range.insert(expected_range.end(), range_after.begin(), range_after.end());
+    {
+        Flash::FileFlash flash;
+        TEST_ASSERT_TRUE(flash.open(image_path));
+        Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+        TEST_ASSERT_TRUE(recorder.mount());
+        append(recorder, 0, BEFORE);
+        flash.fail_erases(1);
+        append(recorder, LOST, TOTAL);
+
+        TEST_ASSERT_EQUAL_UINT32(1, recorder.metrics().records_lost);
+        TEST_ASSERT_EQUAL_UINT32(TOTAL - 1, recorder.metrics().records_stored);
+        TEST_ASSERT_TRUE(values_of(export_everything(recorder)) == expected);
+        TEST_ASSERT_TRUE(values_of(export_range(recorder, FROM * RECORD_INTERVAL, TO * RECORD_INTERVAL)) == expected_range);
+        // Starting in the sector before the hole and in the one after it.
+        TEST_ASSERT_EQUAL_INT32(LOST - 1, export_range(recorder, (LOST - 1) * RECORD_INTERVAL, INT64_MAX)[0].record.value0);
+        TEST_ASSERT_EQUAL_INT32(LOST + 1, export_range(recorder, LOST * RECORD_INTERVAL, INT64_MAX)[0].record.value0);
+    }
+
+    Flash::FileFlash flash;
+    TEST_ASSERT_TRUE(flash.open(image_path));
+    Recorder::Recorder recorder(&flash, KEEP_EVERYTHING);
+    TEST_ASSERT_TRUE(recorder.mount());
+    TEST_ASSERT_TRUE(values_of(export_everything(recorder)) == expected);
+    TEST_ASSERT_TRUE(values_of(export_range(recorder, FROM * RECORD_INTERVAL, TO * RECORD_INTERVAL)) == expected_range);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_remount_continues_the_log);
+    RUN_TEST(test_ring_wraps_round_to_the_oldest_sector);
+    RUN_TEST(test_export_ends_when_the_writer_overwrites_it);
+    RUN_TEST(test_range_export_through_the_command_parser);
+    RUN_TEST(test_records_are_shed_under_the_erase_rate_limit);
+    RUN_TEST(test_failed_erase_leaves_a_hole_that_is_skipped);
+    return UNITY_END();
+}
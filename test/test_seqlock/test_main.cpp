@@ -0,0 +1,223 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unity.h>
+
+#include "protected_types.hpp"
+
+// Three fields that must always be seen together, as DataToLog's triple was.
+struct Triple
+{
+    uint32_t value;
+    uint32_t inverted;
+    uint32_t scaled;
+};
+
+static Triple make_triple(const uint32_t n)
+{
+    return {n, ~n, n * 2654435761u};
+}
+
+static bool consistent(const Triple &triple)
+{
+    return triple.inverted == ~triple.value && triple.scaled == triple.value * 2654435761u;
+}
+
+// The mutex-protected baseline the seqlock replaced, on a host mutex.
+class MutexTriple
+{
+public:
+    void write(const Triple &triple)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        value = triple;
+    }
+
+    Triple read() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return value;
+    }
+
+private:
+    mutable std::mutex mutex;
+    Triple value = make_triple(0);
+};
+
+struct Result
+{
+    uint64_t reads = 0;
+    uint64_t torn_reads = 0;
+    uint64_t retries = 0;
+    uint64_t unvalidated_torn_reads = 0;
+    double write_ns = 0.0;
+    double read_ns = 0.0;
+};
+
+constexpr uint32_t WRITES = 200000;
+constexpr size_t READERS = 3;
+
+static double nanoseconds(const std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::nano>(duration).count();
+}
+
+// Readers copy as SignalBus::read_consistent() does, minus the yield, which needs a scheduler.
+static Result run_seqlock()
+{
+    ProtectedTypes::SeqLocked<Triple> shared(make_triple(0));
+    std::atomic<bool> writing{true};
+    std::atomic<size_t> started{0};
+    std::vector<Result> results(READERS);
+    std::vector<std::thread> readers;
+
+    for (size_t r = 0; r < READERS; r++)
+        readers.emplace_back([&, r]() {
+            auto &result = results[r];
+            started++;
+            const auto start = std::chrono::steady_clock::now();
+            do
+            {
+                Triple copy;
+                for (;;)
+                {
+                    const auto seq = shared.begin_read();
+                    copy = shared.read_unchecked();
+                    if (shared.validate(seq))
+                        break;
+                    result.retries++;
+                    if (!consistent(copy))
+                        result.unvalidated_torn_reads++;
+                }
+                if (!consistent(copy))
+                    result.torn_reads++;
+                result.reads++;
+            } while (writing.load(std::memory_order_relaxed));
+            result.read_ns = nanoseconds(std::chrono::steady_clock::now() - start) / result.reads;
+        });
+
+    while (started < READERS)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 1; n <= WRITES; n++)
+        shared.write(make_triple(n));
+    const auto write_ns = nanoseconds(std::chrono::steady_clock::now() - start) / WRITES;
+    writing = false;
+    for (auto &reader : readers)
+        reader.join();
+
+    Result total;
+    total.write_ns = write_ns;
+    for (const auto &result : results)
+    {
+        total.reads += result.reads;
+        total.torn_reads += result.torn_reads;
+        total.retries += result.retries;
+        total.unvalidated_torn_reads += result.unvalidated_torn_reads;
+        total.read_ns += result.read_ns / READERS;
+    }
+    return total;
+}
+
+static Result run_mutex()
+{
+    MutexTriple shared;
+    std::atomic<bool> writing{true};
+    std::atomic<size_t> started{0};
+    std::vector<Result> results(READERS);
+    std::vector<std::thread> readers;
+
+    for (size_t r = 0; r < READERS; r++)
+        readers.emplace_back([&, r]() {
+            auto &result = results[r];
+            started++;
+            const auto start = std::chrono::steady_clock::now();
+            do
+            {
+                if (!consistent(shared.read()))
+                    result.torn_reads++;
+                result.reads++;
+            } while (writing.load(std::memory_order_relaxed));
+            result.read_ns = nanoseconds(std::chrono::steady_clock::now() - start) / result.reads;
+        });
+
+    while (started < READERS)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 1; n <= WRITES; n++)
+        shared.write(make_triple(n));
+    const auto write_ns = nanoseconds(std::chrono::steady_clock::now() - start) / WRITES;
+    writing = false;
+    for (auto &reader : readers)
+        reader.join();
+
+    Result total;
+    total.write_ns = write_ns;
+    for (const auto &result : results)
+    {
+        total.reads += result.reads;
+        total.torn_reads += result.torn_reads;
+        total.read_ns += result.read_ns / READERS;
+    }
+    return total;
+}
+
+static void report(const char *name, const Result &result)
+{
+    char message[200];
+    snprintf(message, sizeof(message),
+             "%s: %.0f ns/write, %.0f ns/read, %llu reads, %llu torn, %llu retries (%llu would have been torn)",
+             name, result.write_ns, result.read_ns,
+             static_cast<unsigned long long>(result.reads),
+             static_cast<unsigned long long>(result.torn_reads),
+             static_cast<unsigned long long>(result.retries),
+             static_cast<unsigned long long>(result.unvalidated_torn_reads));
+    TEST_MESSAGE(message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_single_thread_round_trip()
+{
+    ProtectedTypes::SeqLocked<Triple> shared;
+    TEST_ASSERT_EQUAL_UINT32(0, shared.begin_read());
+
+    shared.write(make_triple(42));
+    const auto seq = shared.begin_read();
+    const auto copy = shared.read_unchecked();
+    TEST_ASSERT_TRUE(shared.validate(seq));
+    TEST_ASSERT_EQUAL_UINT32(42, copy.value);
+    TEST_ASSERT_TRUE(consistent(copy));
+
+    shared.write(make_triple(43));
+    TEST_ASSERT_FALSE(shared.validate(seq));
+}
+
+static void test_concurrent_readers_never_see_a_torn_value()
+{
+    const auto seqlock = run_seqlock();
+    report("seqlock", seqlock);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, static_cast<uint32_t>(seqlock.reads));
+    TEST_ASSERT_EQUAL_UINT32(0, static_cast<uint32_t>(seqlock.torn_reads));
+}
+
+static void test_mutex_baseline()
+{
+    const auto mutex = run_mutex();
+    report("mutex", mutex);
+    TEST_ASSERT_EQUAL_UINT32(0, static_cast<uint32_t>(mutex.torn_reads));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_single_thread_round_trip);
+    RUN_TEST(test_concurrent_readers_never_see_a_torn_value);
+    RUN_TEST(test_mutex_baseline);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <unity.h>
+
+#include "signal_bus.hpp"
+
+using Topic = SignalBus::Topic<uint32_t>;
+
+// Records every delivery, in order.
+class Recording : public SignalBus::Subscriber<uint32_t>
+{
+public:
+    void deliver(const uint32_t &value) override
+    {
+        values.push_back(value);
+    }
+
+    std::vector<uint32_t> values;
+};
+
+// Publishes again from inside its first delivery, as a publisher preempting a subscribe() would.
+class Interrupting : public Recording
+{
+public:
+    explicit Interrupting(Topic &topic) : topic(topic) {}
+
+    void deliver(const uint32_t &value) override
+    {
+        Recording::deliver(value);
+        if (values.size() == 1)
+            topic.publish(value + 1);
+    }
+
+private:
+    Topic &topic;
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_read_is_false_until_the_first_publication()
+{
+    Topic topic("test");
+    uint32_t value = 0, sequence = 0;
+    TEST_ASSERT_FALSE(topic.read(value));
+
+    topic.publish(7);
+    TEST_ASSERT_TRUE(topic.read(value, &sequence));
+    TEST_ASSERT_EQUAL_UINT32(7, value);
+    const auto first = sequence;
+    topic.publish(8);
+    TEST_ASSERT_TRUE(topic.read(value, &sequence));
+    TEST_ASSERT_TRUE(sequence > first);
+}
+
+static void test_early_subscriber_gets_each_publication_once()
+{
+    Topic topic("test");
+    Recording subscriber;
+    TEST_ASSERT_TRUE(topic.subscribe(subscriber));
+    TEST_ASSERT_EQUAL_UINT32(0, subscriber.values.size());
+
+    topic.publish(1);
+    topic.publish(2);
+    TEST_ASSERT_EQUAL_UINT32(2, subscriber.values.size());
+    TEST_ASSERT_EQUAL_UINT32(1, subscriber.values[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, subscriber.values[1]);
+}
+
+// Task 8 subscribing after Task 7 has already published its error code.
+static void test_late_subscriber_gets_the_latest_value()
+{
+    Topic topic("test");
+    topic.publish(1);
+    topic.publish(2);
+
+    SignalBus::OnChange<uint32_t> changes;
+    TEST_ASSERT_TRUE(topic.subscribe(changes));
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(changes.take(value));
+    TEST_ASSERT_EQUAL_UINT32(2, value);
+    TEST_ASSERT_FALSE(changes.take(value));
+
+    topic.publish(2);
+    TEST_ASSERT_FALSE(changes.take(value));
+    topic.publish(3);
+    TEST_ASSERT_TRUE(changes.take(value));
+    TEST_ASSERT_EQUAL_UINT32(3, value);
+}
+
+static void test_publication_during_subscribe_is_delivered_after_the_hand_over()
+{
+    Topic topic("test");
+    topic.publish(10);
+    Interrupting subscriber(topic);
+    TEST_ASSERT_TRUE(topic.subscribe(subscriber));
+    TEST_ASSERT_EQUAL_UINT32(2, subscriber.values.size());
+    TEST_ASSERT_EQUAL_UINT32(10, subscriber.values[0]);
+    TEST_ASSERT_EQUAL_UINT32(11, subscriber.values[1]);
+
+    topic.publish(12);
+    TEST_ASSERT_EQUAL_UINT32(3, subscriber.values.size());
+    TEST_ASSERT_EQUAL_UINT32(12, subscriber.values[2]);
+}
+
+static void test_fifo_keeps_order_and_counts_overflow()
+{
+    Topic topic("test");
+    SignalBus::Fifo<uint32_t, 4> fifo;
+    TEST_ASSERT_TRUE(topic.subscribe(fifo));
+    for (uint32_t n = 1; n <= 6; n++)
+        topic.publish(n);
+
+    uint32_t value = 0;
+    for (uint32_t n = 1; n <= 4; n++)
+    {
+        TEST_ASSERT_TRUE(fifo.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(n, value);
+    }
+    TEST_ASSERT_FALSE(fifo.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(2, fifo.dropped());
+}
+
+static void test_subscribe_fails_when_the_slots_are_full()
+{
+    SignalBus::Topic<uint32_t, SignalBus::Producers::Single, 2> topic("test");
+    Recording first, second, third;
+    TEST_ASSERT_TRUE(topic.subscribe(first));
+    TEST_ASSERT_TRUE(topic.subscribe(second));
+    TEST_ASSERT_FALSE(topic.subscribe(third));
+}
+
+static void test_publish_cost()
+{
+    constexpr uint32_t PUBLICATIONS = 1000000;
+    Topic topic("test");
+    std::vector<SignalBus::OnChange<uint32_t>> subscribers(4);
+    char message[160];
+    int length = snprintf(message, sizeof(message), "ns/publish by subscribers:");
+
+    for (size_t count = 0; count <= subscribers.size(); count++)
+    {
+        if (count > 0)
+            TEST_ASSERT_TRUE(topic.subscribe(subscribers[count - 1]));
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < PUBLICATIONS; n++)
+            topic.publish(n);
+        const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / PUBLICATIONS;
+        length += snprintf(message + length, sizeof(message) - length, " %u: %.1f", static_cast<unsigned>(count), ns);
+    }
+    TEST_MESSAGE(message);
+
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(subscribers[0].take(value));
+    TEST_ASSERT_EQUAL_UINT32(PUBLICATIONS - 1, value);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_read_is_false_until_the_first_publication);
+    RUN_TEST(test_early_subscriber_gets_each_publication_once);
+    RUN_TEST(test_late_subscriber_gets_the_latest_value);
+    RUN_TEST(test_publication_during_subscribe_is_delivered_after_the_hand_over);
+    RUN_TEST(test_fifo_keeps_order_and_counts_overflow);
+    RUN_TEST(test_subscribe_fails_when_the_slots_are_full);
+    RUN_TEST(test_publish_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <unity.h>
+
+#include "statistics.hpp"
+
+using Units::AdcCounts;
+
+constexpr size_t WINDOW = 16;
+constexpr size_t BINS = 64;
+constexpr uint16_t MAXIMUM_SAMPLE = 4095;
+constexpr int32_t BIN_WIDTH = (MAXIMUM_SAMPLE + 1) / BINS;
+
+using Window = Statistics::RollingStatistics<WINDOW, BINS, MAXIMUM_SAMPLE>;
+
+static int32_t raw(const int32_t counts)
+{
+    return AdcCounts::from_counts(counts).count();
+}
+
+// The exact percentile of the window, by the rank percentile() uses.
+static int32_t exact_percentile(std::vector<uint16_t> samples, const uint8_t percent)
+{
+    std::sort(samples.begin(), samples.end());
+    const auto rank = (samples.size() * percent + 99) / 100;
+    return samples[rank - 1];
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_integer_square_root_rounds_down()
+{
+    for (uint64_t root = 0; root < 70000; root += 7)
+    {
+        TEST_ASSERT_EQUAL_UINT32(root, Statistics::integer_square_root(root * root));
+        TEST_ASSERT_EQUAL_UINT32(root, Statistics::integer_square_root(root * root + 2 * root));
+    }
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, Statistics::integer_square_root(UINT64_MAX));
+}
+
+// The extreme leaves with the sample that carried it, and the next one takes over.
+static void test_minimum_and_maximum_follow_the_window()
+{
+    Window statistics;
+    statistics.push(5);
+    statistics.push(3000);
+    for (size_t i = 2; i < WINDOW; i++)
+        statistics.push(static_cast<uint16_t>(100 + i));
+    TEST_ASSERT_EQUAL_INT32(raw(5), statistics.minimum().count());
+    TEST_ASSERT_EQUAL_INT32(raw(3000), statistics.maximum().count());
+
+    statistics.push(200); // evicts 5
+    TEST_ASSERT_EQUAL_INT32(raw(102), statistics.minimum().count());
+    TEST_ASSERT_EQUAL_INT32(raw(3000), statistics.maximum().count());
+
+    statistics.push(50); // evicts 3000
+    TEST_ASSERT_EQUAL_INT32(raw(50), statistics.minimum().count());
+    TEST_ASSERT_EQUAL_INT32(raw(200), statistics.maximum().count());
+    TEST_ASSERT_EQUAL_UINT32(WINDOW, statistics.size());
+}
+
+// Random runs, long enough for the 16-bit positions to wrap several times, against a brute-force
+// window: the extremes are exact, and the mean and standard deviation are within one raw unit (a 256th
+// of a count).
+static void test_window_matches_a_brute_force_reference()
+{
+    std::mt19937 generator(17);
+    std::uniform_int_distribution<int> sample(0, MAXIMUM_SAMPLE);
+    std::uniform_int_distribution<int> narrow(2000, 2010);
+    Window statistics;
+    std::deque<uint16_t> window;
+    for (uint32_t n = 0; n < 200000; n++)
+    {
+        // Runs of near-equal samples exercise ties in the deques, and a small variance the precision.
+        const auto value = static_cast<uint16_t>(((n / 1000) % 2) ? narrow(generator) : sample(generator));
+        statistics.push(value);
+        window.push_back(value);
+        if (window.size() > WINDOW)
+            window.pop_front();
+
+        TEST_ASSERT_EQUAL_INT32(raw(*std::min_element(window.begin(), window.end())), statistics.minimum().count());
+        TEST_ASSERT_EQUAL_INT32(raw(*std::max_element(window.begin(), window.end())), statistics.maximum().count());
+
+        double sum = 0.0;
+        for (const auto v : window)
+            sum += v;
+        const double mean = sum / window.size();
+        double squares = 0.0;
+        for (const auto v : window)
+            squares += (v - mean) * (v - mean);
+        const double deviation = (window.size() < 2) ? 0.0 : std::sqrt(squares / window.size());
+        TEST_ASSERT_DOUBLE_WITHIN(1.0, mean * 256.0, statistics.mean().count());
+        TEST_ASSERT_DOUBLE_WITHIN(1.0, deviation * 256.0, statistics.standard_deviation().count());
+    }
+}
+
+// Samples on either side of a bin edge land in different bins; each percentile is within a bin of
+// the exact one.
+static void test_percentiles_at_bin_edges()
+{
+    Window below;
+    Window above;
+    for (size_t i = 0; i < WINDOW; i++)
+    {
+        below.push(BIN_WIDTH - 1);
+        above.push(BIN_WIDTH);
+    }
+    for (const uint8_t percent : {1, 50, 95, 100})
+    {
+        const auto below_counts = below.percentile(percent).count();
+        const auto above_counts = above.percentile(percent).count();
+        TEST_ASSERT_GREATER_THAN(raw(0), below_counts);
+        TEST_ASSERT_LESS_OR_EQUAL(raw(BIN_WIDTH), below_counts);
+        TEST_ASSERT_GREATER_THAN(raw(BIN_WIDTH), above_counts);
+        TEST_ASSERT_LESS_OR_EQUAL(raw(2 * BIN_WIDTH), above_counts);
+    }
+
+    // Half the window at each end of the range: the median is the top of the first bin.
+    Window split;
+    for (size_t i = 0; i < WINDOW; i++)
+        split.push((i % 2) ? MAXIMUM_SAMPLE : 0);
+    TEST_ASSERT_EQUAL_INT32(raw(BIN_WIDTH), split.percentile(50).count());
+    TEST_ASSERT_GREATER_THAN(raw(MAXIMUM_SAMPLE + 1 - BIN_WIDTH), split.percentile(95).count());
+
+    std::mt19937 generator(17);
+    std::uniform_int_distribution<int> sample(0, MAXIMUM_SAMPLE);
+    Window statistics;
+    std::vector<uint16_t> window;
+    for (uint32_t n = 0; n < 5000; n++)
+    {
+        const auto value = static_cast<uint16_t>(sample(generator));
+        statistics.push(value);
+        window.push_back(value);
+        if (window.size() > WINDOW)
+            window.erase(window.begin());
+        for (const uint8_t percent : {1, 50, 95, 100})
+            TEST_ASSERT_INT32_WITHIN(raw(BIN_WIDTH), raw(exact_percentile(window, percent)), statistics.percentile(percent).count());
+    }
+}
+
+// Samples above MAXIMUM_SAMPLE are clamped to it, into the last bin, rather than indexing past the
+// histogram.
+static void test_samples_saturate_at_the_maximum()
+{
+    Window statistics;
+    for (size_t i = 0; i < WINDOW; i++)
+        statistics.push((i % 2) ? UINT16_MAX : MAXIMUM_SAMPLE + 1);
+    TEST_ASSERT_EQUAL_INT32(raw(MAXIMUM_SAMPLE), statistics.minimum().count());
+    TEST_ASSERT_EQUAL_INT32(raw(MAXIMUM_SAMPLE), statistics.maximum().count());
+    TEST_ASSERT_EQUAL_INT32(raw(MAXIMUM_SAMPLE), statistics.mean().count());
+    TEST_ASSERT_EQUAL_INT32(0, statistics.standard_deviation().count());
+    for (const uint8_t percent : {1, 50, 95, 100})
+    {
+        TEST_ASSERT_GREATER_THAN(raw(MAXIMUM_SAMPLE + 1 - BIN_WIDTH), statistics.percentile(percent).count());
+        TEST_ASSERT_LESS_OR_EQUAL(raw(MAXIMUM_SAMPLE + 1), statistics.percentile(percent).count());
+    }
+
+    // As the saturated samples leave, the window falls back to the new ones.
+    for (size_t i = 0; i < WINDOW; i++)
+        statistics.push(1000);
+    TEST_ASSERT_EQUAL_INT32(raw(1000), statistics.maximum().count());
+    TEST_ASSERT_INT32_WITHIN(raw(BIN_WIDTH), raw(1000), statistics.percentile(95).count());
+}
+
+static void test_empty_and_single_sample_windows()
+{
+    Window statistics;
+    const auto empty = statistics.snapshot();
+    TEST_ASSERT_EQUAL_UINT16(0, empty.samples);
+    TEST_ASSERT_EQUAL_INT32(0, empty.mean.count());
+    TEST_ASSERT_EQUAL_INT32(0, empty.median.count());
+
+    statistics.push(1234);
+    const auto one = statistics.snapshot();
+    TEST_ASSERT_EQUAL_UINT16(1, one.samples);
+    TEST_ASSERT_EQUAL_INT32(raw(1234), one.minimum.count());
+    TEST_ASSERT_EQUAL_INT32(raw(1234), one.mean.count());
+    TEST_ASSERT_EQUAL_INT32(0, one.standard_deviation.count());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_integer_square_root_rounds_down);
+    RUN_TEST(test_minimum_and_maximum_follow_the_window);
+    RUN_TEST(test_window_matches_a_brute_force_reference);
+    RUN_TEST(test_percentiles_at_bin_edges);
+    RUN_TEST(test_samples_saturate_at_the_maximum);
+    RUN_TEST(test_empty_and_single_sample_windows);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <unity.h>
+
+#include "common.hpp"
+#include "filters.hpp"
+#include "units.hpp"
+
+constexpr size_t ITERATIONS = 200000;
+constexpr uint32_t SQUARE_WAVE_PERIODS = 8;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_millisecond_configuration_rounds_to_whole_microseconds()
+{
+    TEST_ASSERT_EQUAL_UINT32(24400, Units::microseconds(24.4).count());
+    TEST_ASSERT_EQUAL_UINT32(41667, Units::microseconds(calculateCyclePeriodMs(24.0)).count());
+    TEST_ASSERT_EQUAL_UINT32(200000, Units::microseconds(calculateCyclePeriodMs(5.0)).count());
+    TEST_ASSERT_EQUAL_UINT32(41, Units::ticks(Units::microseconds(calculateCyclePeriodMs(24.0))));
+}
+
+// The 32-bit clock wraps every 71.6 minutes; differences across the wrap must stay exact.
+static void test_microsecond_differences_survive_the_wrap()
+{
+    const Units::Microseconds before(UINT32_MAX - 99);
+    const Units::Microseconds after(900);
+    TEST_ASSERT_EQUAL_UINT32(1000, (after - before).count());
+    TEST_ASSERT_TRUE(after - before < Units::Microseconds(1001));
+}
+
+// Millihertz from whole-microsecond windows against the double calculation it replaced, across the
+// range the square wave input covers.
+static void test_frequency_matches_the_double_calculation()
+{
+    uint32_t worst_error = 0;
+    for (uint32_t window = 800; window <= 8000000; window += 997)
+    {
+        const double reference = SQUARE_WAVE_PERIODS * 1e9 / window;
+        const auto measured = Units::frequency(SQUARE_WAVE_PERIODS, Units::Microseconds(window)).count();
+        const auto error = static_cast<uint32_t>(std::fabs(measured - reference) * 2.0 + 0.5); // half millihertz
+        worst_error = std::max(worst_error, error);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, worst_error); // rounded to nearest
+    TEST_ASSERT_EQUAL_UINT32(0, Units::frequency(SQUARE_WAVE_PERIODS, Units::Microseconds(0)).count());
+}
+
+static void test_adc_counts_keep_a_256th_of_a_count()
+{
+    for (int32_t raw = 0; raw <= 4095 * 256; raw += 37)
+    {
+        const double counts = raw / 256.0;
+        const auto hundredths = Units::AdcCounts::from_raw(raw).hundredths();
+        TEST_ASSERT_TRUE(std::fabs(hundredths - counts * 100.0) <= 0.5);
+    }
+    TEST_ASSERT_EQUAL_INT32(1, Units::AdcCounts::from_counts(0.004f).count());
+    TEST_ASSERT_EQUAL_INT32(-1, Units::AdcCounts::from_counts(-0.004f).count());
+}
+
+struct Inputs
+{
+    std::vector<std::array<uint16_t, 4>> readings;
+    std::vector<uint32_t> windows; // microseconds spanned by SQUARE_WAVE_PERIODS periods
+};
+
+static Inputs make_inputs()
+{
+    std::mt19937 generator(15);
+    std::uniform_int_distribution<uint16_t> reading(0, 4095);
+    std::uniform_int_distribution<uint32_t> window(8000, 16000);
+    Inputs inputs;
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        inputs.readings.push_back({reading(generator), reading(generator), reading(generator), reading(generator)});
+        inputs.windows.push_back(window(generator));
+    }
+    return inputs;
+}
+
+template <typename Step>
+static double nanoseconds_per_iteration(Step &&step)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS; i++)
+        step(i);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+}
+
+// One pass of the Task 3 -> 5 -> 7 chain: frequency from an edge window, average of four readings,
+// threshold check. Both versions must agree on every threshold decision. The host has a double-precision
+// FPU, so the timings here only bound the integer path; the ESP32's FPU is single precision and emulates
+// every double operation in software.
+static void test_pipeline_cost_before_and_after()
+{
+    const auto inputs = make_inputs();
+    constexpr double THRESHOLD_COUNTS = 4095.0 / 2.0;
+    constexpr auto THRESHOLD = Units::AdcCounts::from_raw(4095 * 128);
+
+    std::vector<uint8_t> double_decisions(ITERATIONS), integer_decisions(ITERATIONS);
+    volatile double double_sink = 0.0;
+    volatile uint32_t integer_sink = 0;
+
+    const auto double_ns = nanoseconds_per_iteration([&](const size_t i) {
+        const Microseconds window = inputs.windows[i];
+        const Hertz frequency = SQUARE_WAVE_PERIODS / microsecondsToSeconds(window);
+        double average = 0.0;
+        for (const auto reading : inputs.readings[i])
+            average += reading;
+        average /= 4.0;
+        double_decisions[i] = average > THRESHOLD_COUNTS;
+        double_sink = frequency;
+    });
+
+    Filters::MovingAverage<4> filter;
+    const auto integer_ns = nanoseconds_per_iteration([&](const size_t i) {
+        const auto frequency = Units::frequency(SQUARE_WAVE_PERIODS, Units::Microseconds(inputs.windows[i]));
+        for (const auto reading : inputs.readings[i])
+            filter.push(reading);
+        const auto average = Units::AdcCounts::from_raw(filter.mean<Units::AdcCounts::FRACTIONAL_BITS>());
+        integer_decisions[i] = average > THRESHOLD;
+        integer_sink = frequency.count();
+    });
+
+    char message[128];
+    snprintf(message, sizeof(message), "ns/iteration: double %.1f, integer %.1f", double_ns, integer_ns);
+    TEST_MESSAGE(message);
+    (void)double_sink;
+    (void)integer_sink;
+
+    size_t disagreements = 0;
+    for (size_t i = 0; i < ITERATIONS; i++)
+        disagreements += double_decisions[i] != integer_decisions[i];
+    TEST_ASSERT_EQUAL_UINT32(0, disagreements);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_millisecond_configuration_rounds_to_whole_microseconds);
+    RUN_TEST(test_microsecond_differences_survive_the_wrap);
+    RUN_TEST(test_frequency_matches_the_double_calculation);
+    RUN_TEST(test_adc_counts_keep_a_256th_of_a_count);
+    RUN_TEST(test_pipeline_cost_before_and_after);
+    return UNITY_END();
+}
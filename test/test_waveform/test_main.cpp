@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include <unity.h>
+
+#include "simulated_hal.hpp"
+#include "tasks.hpp"
+#include "waveform.hpp"
+
+// Unclaimed by the firmware, so the pulses here cannot disturb anything else.
+constexpr int8_t TEST_PIN = 23;
+constexpr uint32_t PERIOD_US = 5000;
+constexpr uint32_t PULSE_WIDTH_US = 50; // Task 1's pulse
+constexpr size_t CYCLES = 100;
+
+// The generator places every edge exactly, but the host may preempt its thread for a millisecond or
+// more now and then; such pulses are late (and cut short), never drifting. Most must be on time.
+constexpr Microseconds EDGE_TOLERANCE_US = 20.0;
+constexpr size_t ON_TIME_PERCENT = 90;
+
+using Edges = std::vector<Hal::SimulatedHal::Edge>;
+
+static Edges edges_on(const int8_t pin_id)
+{
+    Edges edges;
+    for (const auto &edge : Hal::simulated().recorded_edges())
+        if (edge.pin_id == pin_id)
+            edges.push_back(edge);
+    return edges;
+}
+
+static double thread_cpu_us()
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+struct Accuracy
+{
+    size_t pulses = 0;
+    size_t out_of_order = 0; // edges that do not alternate rising, falling
+    size_t on_time = 0;      // rising edge and width both within EDGE_TOLERANCE_US
+    double worst_period_error_us = 0.0; // of each rising edge against origin + n periods
+    double worst_width_error_us = 0.0;
+    double mean_width_us = 0.0;
+};
+
+static Accuracy measure(const Edges &edges)
+{
+    Accuracy accuracy;
+    size_t first = 0;
+    while (first < edges.size() && !edges[first].level)
+        first++;
+    for (size_t i = first; i + 1 < edges.size(); i += 2)
+    {
+        const auto &rising = edges[i];
+        const auto &falling = edges[i + 1];
+        if (!rising.level || falling.level)
+            accuracy.out_of_order++;
+
+        const auto expected = edges[first].time + static_cast<double>(PERIOD_US) * accuracy.pulses;
+        const auto width = falling.time - rising.time;
+        const auto period_error = std::abs(rising.time - expected);
+        const auto width_error = std::abs(width - static_cast<double>(PULSE_WIDTH_US));
+        if (period_error < EDGE_TOLERANCE_US && width_error < EDGE_TOLERANCE_US)
+            accuracy.on_time++;
+        accuracy.worst_period_error_us = std::max(accuracy.worst_period_error_us, period_error);
+        accuracy.worst_width_error_us = std::max(accuracy.worst_width_error_us, width_error);
+        accuracy.mean_width_us += width;
+        accuracy.pulses++;
+    }
+    if (accuracy.pulses > 0)
+        accuracy.mean_width_us /= accuracy.pulses;
+    return accuracy;
+}
+
+static void report(const char *name, const Accuracy &accuracy, const double cpu_us)
+{
+    char message[192];
+    snprintf(message, sizeof(message),
+             "%s: %u pulses, %u on time, worst edge %.1f us, worst width %.1f us, mean width %.2f us, caller CPU %.1f us/cycle",
+             name, static_cast<unsigned>(accuracy.pulses), static_cast<unsigned>(accuracy.on_time), accuracy.worst_period_error_us,
+             accuracy.worst_width_error_us, accuracy.mean_width_us, cpu_us / CYCLES);
+    TEST_MESSAGE(message);
+}
+
+void setUp()
+{
+    Hal::simulated().clear_recorded_edges();
+}
+
+void tearDown()
+{
+    Waveform::create_generator().stop();
+    Waveform::create_indicator_generator().stop();
+}
+
+static void test_rejects_pulses_that_do_not_fit_the_period()
+{
+    auto &generator = Waveform::create_generator();
+    TEST_ASSERT_FALSE(generator.start(TEST_PIN, Units::Microseconds(PERIOD_US), Units::Microseconds(0)));
+    TEST_ASSERT_FALSE(generator.start(TEST_PIN, Units::Microseconds(PERIOD_US), Units::Microseconds(PERIOD_US)));
+    TEST_ASSERT_EQUAL_UINT32(0, edges_on(TEST_PIN).size());
+}
+
+static void test_generator_holds_period_and_width_without_the_caller()
+{
+    auto &generator = Waveform::create_generator();
+    const auto cpu_before = thread_cpu_us();
+    TEST_ASSERT_TRUE(generator.start(TEST_PIN, Units::Microseconds(PERIOD_US), Units::Microseconds(PULSE_WIDTH_US)));
+    // The caller only sleeps; the generator's own thread drives the pin.
+    std::this_thread::sleep_for(std::chrono::microseconds(PERIOD_US * CYCLES));
+    generator.stop();
+    const auto cpu_us = thread_cpu_us() - cpu_before;
+
+    const auto accuracy = measure(edges_on(TEST_PIN));
+    report("generator", accuracy, cpu_us);
+    TEST_ASSERT_EQUAL_UINT32(0, accuracy.out_of_order);
+    // One pulse per period of the run, give or take the start-up and the pulse under way at stop().
+    TEST_ASSERT_UINT32_WITHIN(2, CYCLES, accuracy.pulses);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(accuracy.pulses * ON_TIME_PERCENT / 100, accuracy.on_time);
+    TEST_ASSERT_TRUE(cpu_us / CYCLES < PULSE_WIDTH_US / 10.0);
+}
+
+// What Task 1 did before the generator: write, busy-wait the pulse, write, then sleep out the period.
+static void test_busy_wait_loop_costs_the_pulse_width_every_cycle()
+{
+    auto &hal = Hal::simulated();
+    using Clock = std::chrono::steady_clock;
+    const auto origin = Clock::now();
+    const auto cpu_before = thread_cpu_us();
+    for (size_t cycle = 0; cycle < CYCLES; cycle++)
+    {
+        std::this_thread::sleep_until(origin + std::chrono::microseconds(PERIOD_US * cycle));
+        hal.digital_write(TEST_PIN, true);
+        hal.delay_microseconds(Units::Microseconds(PULSE_WIDTH_US));
+        hal.digital_write(TEST_PIN, false);
+    }
+    const auto cpu_us = thread_cpu_us() - cpu_before;
+
+    const auto accuracy = measure(edges_on(TEST_PIN));
+    report("busy-wait loop", accuracy, cpu_us);
+    TEST_ASSERT_EQUAL_UINT32(0, accuracy.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(CYCLES, accuracy.pulses);
+    TEST_ASSERT_TRUE(cpu_us / CYCLES >= PULSE_WIDTH_US * 0.9);
+}
+
+// The error code pattern, scaled down 100 times: bursts of N pulses separated by a pause long enough
+// to tell one burst from the next.
+static void test_pattern_repeats_bursts_of_pulses()
+{
+    constexpr uint8_t PULSES = 3;
+    constexpr uint32_t SCALE = 100;
+    constexpr auto blink = Tasks::blink_pattern(PULSES);
+    static_assert(blink.pulses == PULSES && blink.pause > blink.period, "The pause must stand out from the flashes.");
+    const Waveform::Pattern pattern = {Units::Microseconds(blink.period.count() / SCALE), Units::Microseconds(blink.pulse_width.count() / SCALE),
+                                       PULSES, Units::Microseconds(blink.pause.count() / SCALE)};
+    const auto burst_us = pattern.period.count() * PULSES + pattern.pause.count();
+    constexpr uint32_t BURSTS = 8;
+
+    auto &indicator = Waveform::create_indicator_generator();
+    TEST_ASSERT_FALSE(indicator.start(TEST_PIN, Waveform::Pattern{pattern.period, pattern.pulse_width, 0, pattern.pause}));
+    TEST_ASSERT_TRUE(indicator.start(TEST_PIN, pattern));
+    std::this_thread::sleep_for(std::chrono::microseconds(burst_us * BURSTS));
+    indicator.stop();
+
+    // Rising edges more than a period and half the pause apart start a new burst.
+    std::vector<Microseconds> rising;
+    for (const auto &edge : edges_on(TEST_PIN))
+        if (edge.level)
+            rising.push_back(edge.time);
+    const auto gap_threshold = pattern.period.count() + pattern.pause.count() / 2.0;
+    std::vector<uint32_t> bursts = {1};
+    for (size_t i = 1; i < rising.size(); i++)
+    {
+        if (rising[i] - rising[i - 1] > gap_threshold)
+            bursts.push_back(0);
+        bursts.back()++;
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u rising edges in %u bursts", static_cast<unsigned>(rising.size()), static_cast<unsigned>(bursts.size()));
+    TEST_MESSAGE(message);
+    // The burst under way at stop() may be cut short; every earlier one has all its pulses.
+    TEST_ASSERT_UINT32_WITHIN(1, BURSTS, bursts.size());
+    for (size_t i = 0; i + 1 < bursts.size(); i++)
+        TEST_ASSERT_EQUAL_UINT32(PULSES, bursts[i]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_pulses_that_do_not_fit_the_period);
+    RUN_TEST(test_generator_holds_period_and_width_without_the_caller);
+    RUN_TEST(test_busy_wait_loop_costs_the_pulse_width_every_cycle);
+    RUN_TEST(test_pattern_repeats_bursts_of_pulses);
+    return UNITY_END();
+}
@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+"""Decodes the binary log stream written by BinaryLog::drain() into CSV.
+
+Reads a capture file or a serial port (requires pyserial) and writes one CSV row per record:
+timestamp_us,task,type,value[,value...]. Packets with a bad CRC are skipped and reported on stderr.
+
+Packets exported from the telemetry recorder are decoded the same way, with timestamps in recorder
+time rather than time since boot. --export asks the device for them first, and --image decodes a
+recorder region directly: the host build's telemetry.bin, or the partition read back with esptool.
+
+    tools/decode_log.py capture.bin > log.csv
+    tools/decode_log.py --port /dev/ttyUSB0 --baud 115200
+    tools/decode_log.py --framing raw capture.bin
+    tools/decode_log.py --port /dev/ttyUSB0 --export 0:60000000 > first_minute.csv
+    tools/decode_log.py --image telemetry.bin > recorded.csv
+"""
+import argparse
+import csv
+import struct
+import sys
+
+RECORD = struct.Struct("<IBBHii")
+HEADER = struct.Struct("<BBH")
+EXPORT_TIME = struct.Struct("<q")
+SECTOR_HEADER = struct.Struct("<IIIIq8x")
+LIVE_PACKET_VERSION = 1
+EXPORT_PACKET_VERSION = 2
+SECTOR_MAGIC = 0x314D4C54
+SECTOR_SIZE = 4096
+
+RECORD_TYPES = {
+    1: "digital_input",
+    2: "square_wave_frequency",
+    3: "analogue_readings",
+    4: "filtered_analogue",
+    5: "error_code",
+    6: "snapshot",
+    7: "data_unavailable",
+    8: "records_dropped",
+    9: "task_timing",
+    10: "task_timing_mean",
+    11: "core_load",
+    12: "stack_usage",
+    13: "heap_usage",
+    14: "analogue_statistics",
+    15: "analogue_range",
+    16: "analogue_percentiles",
+    17: "background_work",
+    18: "power_levels",
+    19: "wake_latency",
+    20: "recorder_throughput",
+    21: "recorder_wear",
+    22: "sample_latency",
+    23: "recorder_stall",
+    24: "records_shed",
+}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    output = bytearray()
+    index = 0
+    while index < len(frame):
+        code = frame[index]
+        if code == 0 or index + code > len(frame):
+            return None
+        output += frame[index + 1:index + code]
+        index += code
+        if code < 0xFF and index < len(frame):
+            output.append(0)
+    return bytes(output)
+
+
+def cobs_frames(stream):
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        for byte in chunk:
+            if byte == 0:
+                if buffer:
+                    yield bytes(buffer)
+                buffer.clear()
+            else:
+                buffer.append(byte)
+
+
+def raw_frames(stream):
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        buffer += chunk
+        while True:
+            start = buffer.find(b"\xa5\x5a")
+            if start < 0 or len(buffer) < start + 4:
+                break
+            length = buffer[start + 2] | (buffer[start + 3] << 8)
+            if len(buffer) < start + 4 + length:
+                break
+            yield bytes(buffer[start + 4:start + 4 + length])
+            del buffer[:start + 4 + length]
+
+
+def decode_values(record_type, aux, value0, value1):
+    if record_type == 1:
+        return [value0, value1, aux]
+    if record_type == 2:
+        return [value0 / 1000.0]
+    if record_type == 3:
+        packed = [value0 & 0xFFFF, (value0 >> 16) & 0xFFFF, value1 & 0xFFFF, (value1 >> 16) & 0xFFFF]
+        return packed[:aux]
+    if record_type == 4:
+        return [value0 / 100.0]
+    if record_type == 6:
+        return [aux, value0 / 1000.0, value1 / 100.0]
+    if record_type in (7,):
+        return []
+    if record_type in (9, 10):
+        return [aux, value0, value1]
+    if record_type == 11:
+        return [aux, value0 / 100.0, value1 / 100.0]
+    if record_type == 12:
+        return [value0, value1, aux]
+    if record_type == 13:
+        return [value0, value1]
+    if record_type == 14:
+        return [aux, value0 / 100.0, value1 / 100.0]
+    if record_type in (15, 16):
+        return [value0 / 100.0, value1 / 100.0]
+    if record_type == 17:
+        return [aux, value0, value1 / 100.0]
+    if record_type == 18:
+        return [aux, value0 / 100.0, value1 / 100.0]
+    if record_type == 19:
+        return [aux, value0, value1]
+    if record_type in (20, 21):
+        return [aux, value0, value1]
+    if record_type in (22, 23):
+        return [aux, value0, value1]
+    if record_type == 24:
+        return [value0, value1]
+    return [value0]
+
+
+def signed32(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def write_records(data, offset, count, writer, base_time=None, first_timestamp=None):
+    """Writes count records starting at offset. With a base time, the recorder time of first_timestamp
+    (by default the first record's), timestamps are extended to recorder time."""
+    for i in range(count):
+        timestamp, record_type, task, aux, value0, value1 = RECORD.unpack_from(data, offset + i * RECORD.size)
+        if base_time is not None:
+            if first_timestamp is None:
+                first_timestamp = timestamp
+            timestamp = base_time + signed32((timestamp - first_timestamp) & 0xFFFFFFFF)
+        name = RECORD_TYPES.get(record_type, str(record_type))
+        writer.writerow([timestamp, task, name] + decode_values(record_type, aux, value0, value1))
+
+
+def decode_packet(packet, writer):
+    """Returns False for a corrupt packet, "end" for the packet closing an export, else True."""
+    if len(packet) < HEADER.size + 2 or crc16(packet[:-2]) != struct.unpack_from("<H", packet, len(packet) - 2)[0]:
+        return False
+    version, count, _sequence = HEADER.unpack_from(packet)
+    if version == LIVE_PACKET_VERSION and len(packet) == HEADER.size + count * RECORD.size + 2:
+        write_records(packet, HEADER.size, count, writer)
+        return True
+    header_size = HEADER.size + EXPORT_TIME.size
+    if version == EXPORT_PACKET_VERSION and len(packet) == header_size + count * RECORD.size + 2:
+        (base_time,) = EXPORT_TIME.unpack_from(packet, HEADER.size)
+        write_records(packet, header_size, count, writer, base_time)
+        return True if count else "end"
+    return False
+
+
+def decode_image(image, writer):
+    """Decodes a recorder region sector by sector, oldest first."""
+    sectors = []
+    for offset in range(0, len(image) - SECTOR_SIZE + 1, SECTOR_SIZE):
+        magic, sequence, erase_count, first_timestamp, first_time = SECTOR_HEADER.unpack_from(image, offset)
+        if magic == SECTOR_MAGIC:
+            sectors.append((sequence, offset, first_timestamp, first_time, erase_count))
+    for _sequence, offset, first_timestamp, first_time, _erase_count in sorted(sectors):
+        count = 0
+        for slot in range(offset + SECTOR_HEADER.size, offset + SECTOR_SIZE, RECORD.size):
+            if image[slot + 4] == 0xFF:
+                break
+            count += 1
+        write_records(image, offset + SECTOR_HEADER.size, count, writer, first_time, first_timestamp)
+    if sectors:
+        erase_counts = [sector[4] for sector in sectors]
+        print(f"{len(sectors)} sectors in use, erase counts {min(erase_counts)}-{max(erase_counts)}", file=sys.stderr)
+
+
+def export_command(span):
+    if span == "all":
+        return b"X"
+    start, _, end = span.partition(":")
+    return b"R" + struct.pack("<qq", int(start) if start else -(1 << 63), int(end) if end else (1 << 63) - 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="binary capture file (default: stdin)")
+    parser.add_argument("--port", help="read from this serial port instead of a file")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--framing", choices=("cobs", "raw"), default="cobs")
+    parser.add_argument("--export", metavar="FROM:TO", help="with --port: export recorded telemetry, 'all' or a "
+                        "range of recorder time in microseconds (either end may be left open), then exit")
+    parser.add_argument("--image", help="decode a telemetry recorder region instead of a stream")
+    args = parser.parse_args()
+
+    writer = csv.writer(sys.stdout)
+    writer.writerow(["timestamp_us", "task", "type", "values"])
+    if args.image:
+        with open(args.image, "rb") as image:
+            decode_image(image.read(), writer)
+        return
+
+    if args.port:
+        import serial  # pyserial
+
+        stream = serial.Serial(args.port, args.baud)
+        if args.export:
+            stream.write(export_command(args.export))
+    elif args.capture:
+        stream = open(args.capture, "rb")
+    else:
+        stream = sys.stdin.buffer
+
+    frames = cobs_frames(stream) if args.framing == "cobs" else raw_frames(stream)
+    bad_packets = 0
+    for frame in frames:
+        packet = cobs_decode(frame) if args.framing == "cobs" else frame
+        decoded = decode_packet(packet, writer) if packet is not None else False
+        if not decoded:
+            bad_packets += 1
+            print(f"skipped corrupt packet ({bad_packets} so far)", file=sys.stderr)
+        sys.stdout.flush()
+        if decoded == "end" and args.export:
+            return
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Simulates the task set on a dual-core ESP32 and reports worst-case response times with and without
+partitioning.
+
+The task set mirrors TASK_TABLE in src/main.cpp: periods, WCET budgets, rate-monotonic priorities and
+roles, plus the two kinds of interference the budgets leave out:
+  * interrupts a task brings onto the core it runs on (Task 3's edge-capture ISR), and
+  * non-preemptible sections at the start of a job (the UART driver fills the TX FIFO inside a critical
+    section while the log drain task writes).
+Without partitioning the scheduler places jobs freely and an ISR lands on whichever core first ran its
+task; with partitioning every task is pinned as TaskRegistry::partition() would pin it.
+
+    tools/partition_sim.py
+    tools/partition_sim.py --horizon 20 --square-wave-hz 1000 --trials 50
+
+The first trial releases every task together; later trials use random release offsets, since on two
+cores the synchronous release is not necessarily the worst case.
+"""
+import argparse
+import random
+from dataclasses import dataclass, field
+
+NUMBER_OF_CORES = 2
+BLOCKING_CORE = 0
+TIME_CRITICAL_CORE = NUMBER_OF_CORES - 1
+
+
+@dataclass
+class Task:
+    name: str
+    period_us: float
+    wcet_us: float
+    role: str  # "time_critical", "general" or "blocking"
+    background: bool = False
+    critical_us: float = 0.0  # non-preemptible section at the start of each job
+    isr_interval_us: float = 0.0  # interrupt load the task attaches to its core
+    isr_cost_us: float = 0.0
+    priority: int = 0
+    core: int = -1
+
+
+def task_set(square_wave_hz):
+    """Keep in step with TASK_TABLE in src/main.cpp. The drain task has no budget in the table (it is a
+    background task) but does real work, so it is given a nominal cost here."""
+    return [
+        Task("Task 1", 24400, 100, "time_critical"),
+        Task("Task 2", 200000, 50, "general"),
+        Task("Task 3", 1000000, 50, "blocking", isr_interval_us=1e6 / square_wave_hz, isr_cost_us=3),
+        Task("Task 4", 1e6 / 24, 2000, "time_critical"),
+        Task("Task 5", 1e6 / 24, 100, "general"),
+        Task("Task 6", 100000, 50, "general", background=True),  # sizes its work to the idle time
+        Task("Task 7", 1e6 / 3, 50, "general"),
+        Task("Task 8", 1e6 / 3, 50, "general"),
+        Task("Task 9", 5000000, 500, "blocking"),
+        Task("Log drain", 50000, 1500, "blocking", background=True, critical_us=150),
+    ]
+
+
+def utilisation(task):
+    return 0.0 if task.background else task.wcet_us / task.period_us
+
+
+def assign_priorities(tasks):
+    """Rate-monotonic ranks as in TaskRegistry::priority(); background tasks sit below all of them."""
+    periods = sorted({t.period_us for t in tasks if not t.background})
+    for task in tasks:
+        task.priority = 1 if task.background else 2 + (len(periods) - 1 - periods.index(task.period_us))
+
+
+def partition(tasks):
+    """Role first, then worst-fit decreasing by utilisation, as TaskRegistry::partition()."""
+    load = [0.0] * NUMBER_OF_CORES
+    for task in tasks:
+        if task.role == "time_critical":
+            task.core = TIME_CRITICAL_CORE
+        elif task.role == "blocking":
+            task.core = BLOCKING_CORE
+        else:
+            continue
+        load[task.core] += utilisation(task)
+    for task in sorted((t for t in tasks if t.role == "general"), key=utilisation, reverse=True):
+        task.core = min(range(NUMBER_OF_CORES), key=lambda core: load[core])
+        load[task.core] += utilisation(task)
+    return load
+
+
+@dataclass
+class Job:
+    task: Task
+    release: float
+    remaining: float
+    critical: float
+    core: int = -1  # pinned core, -1 for any
+    is_isr: bool = False
+    running_on: int = field(default=-1)
+
+    def rank(self):
+        return (1 if self.is_isr else 0, self.task.priority, -self.release)
+
+    def preemptible(self):
+        return not self.is_isr and self.critical <= 0
+
+
+def simulate(tasks, pinned, horizon_us, offsets):
+    """Event-driven fixed-priority simulation; returns the worst response time of each task in us."""
+    worst = {task.name: 0.0 for task in tasks}
+    next_release = {task.name: offsets[task.name] for task in tasks}
+    next_isr = {task.name: 0.0 for task in tasks if task.isr_interval_us}
+    isr_core = {}  # decided when the owning task first runs
+    ready = []
+    running = [None] * NUMBER_OF_CORES
+    now = 0.0
+
+    while now < horizon_us:
+        for task in tasks:
+            if next_release[task.name] <= now:
+                ready.append(Job(task, now, task.wcet_us, task.critical_us, task.core if pinned else -1))
+                next_release[task.name] += task.period_us
+            if task.name in isr_core and next_isr[task.name] <= now:
+                ready.append(Job(task, now, task.isr_cost_us, 0.0, isr_core[task.name], is_isr=True))
+                next_isr[task.name] += task.isr_interval_us
+
+        # Non-preemptible jobs keep their cores; the rest go to the highest-ranked ready jobs.
+        for core in range(NUMBER_OF_CORES):
+            if running[core] is not None and running[core].preemptible():
+                running[core].running_on = -1
+                running[core] = None
+        for job in sorted(ready, key=Job.rank, reverse=True):
+            if job.running_on >= 0:
+                continue
+            allowed = [job.core] if job.core >= 0 else range(NUMBER_OF_CORES)
+            free = [core for core in allowed if running[core] is None]
+            if free:
+                job.running_on = free[0]
+                running[free[0]] = job
+                if job.task.isr_interval_us and not job.is_isr and job.task.name not in isr_core:
+                    isr_core[job.task.name] = free[0]
+                    next_isr[job.task.name] = now
+
+        step = horizon_us - now
+        step = min([step] + [t - now for t in next_release.values()])
+        step = min([step] + [next_isr[name] - now for name in isr_core])
+        for job in running:
+            if job is not None:
+                step = min(step, job.critical if job.critical > 0 else job.remaining)
+        step = max(step, 0.0)
+        if step == 0.0 and all(job is None for job in running) and not any(
+            t <= now for t in list(next_release.values()) + [next_isr[n] for n in isr_core]
+        ):
+            break
+
+        now += step
+        for core, job in enumerate(running):
+            if job is None:
+                continue
+            job.remaining -= step
+            job.critical -= step
+            if job.remaining <= 1e-9:
+                if not job.is_isr:
+                    worst[job.task.name] = max(worst[job.task.name], now - job.release)
+                ready.remove(job)
+                running[core] = None
+    return worst
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--horizon", type=float, default=10.0, help="simulated time in seconds")
+    parser.add_argument("--square-wave-hz", type=float, default=1000.0, help="Task 3 input frequency")
+    parser.add_argument("--trials", type=int, default=20, help="release phasings to simulate")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    tasks = task_set(args.square_wave_hz)
+    assign_priorities(tasks)
+    load = partition(tasks)
+
+    horizon_us = args.horizon * 1e6
+    generator = random.Random(args.seed)
+    unpartitioned = {task.name: 0.0 for task in tasks}
+    partitioned = dict(unpartitioned)
+    for trial in range(args.trials):
+        offsets = {task.name: 0.0 if trial == 0 else generator.uniform(0, task.period_us) for task in tasks}
+        for worst, pinned in ((unpartitioned, False), (partitioned, True)):
+            for name, value in simulate(tasks, pinned, horizon_us, offsets).items():
+                worst[name] = max(worst[name], value)
+
+    print(f"{'task':<10} {'prio':>4} {'core':>4} {'period ms':>10} {'WCET us':>8} {'WCRT free us':>13} {'WCRT pinned us':>15}")
+    for task in tasks:
+        print(
+            f"{task.name:<10} {task.priority:>4} {task.core:>4} {task.period_us / 1000:>10.1f} {task.wcet_us:>8.0f}"
+            f" {unpartitioned[task.name]:>13.0f} {partitioned[task.name]:>15.0f}"
+        )
+    for core, value in enumerate(load):
+        print(f"core {core}: budgeted load {value * 100:.2f} %")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Checks TASK_TABLE in src/main.cpp for feasibility and finds the largest DEBUG_RATE_AMPLIFIER that keeps
+every deadline.
+
+The periods, budgets, roles and scheduling classes are read from src/main.cpp itself, with
+DEBUG_RATE_AMPLIFIER substituted, so the analysis follows the source. Tasks are placed on cores as
+TaskRegistry::partition() places them and given its rate-monotonic priorities; then, per core:
+  * response-time analysis for fixed-priority preemptive scheduling, R = C + B + sum ceil(R / Tj) Cj
+    over higher- and equal-priority tasks, plus the interrupt load the core carries, with deadlines
+    equal to periods;
+  * B, the blocking term, is the longest non-preemptible section of a lower-priority task on the core
+    (the UART driver's critical section in the log drain task). Tasks share data through the lock-free
+    signal bus and hand blocks over with non-blocking queue operations, so no mutex or queue wait adds
+    to it;
+  * the discrete-event simulator from partition_sim.py replays the set at the amplifier found, as a
+    cross-check of the analysis against the interleavings it abstracts.
+
+WCETs are the table's budgets unless a decoded log is given, in which case the largest measured
+execution time of each task (task_timing records) replaces its budget.
+
+    tools/schedulability.py
+    tools/decode_log.py capture.bin > log.csv && tools/schedulability.py --measured log.csv
+    tools/schedulability.py --amplifier 4
+"""
+import argparse
+import csv
+import math
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from partition_sim import NUMBER_OF_CORES, Task, assign_priorities, partition, simulate, task_set  # noqa: E402
+
+MAIN_CPP = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "main.cpp")
+CONSTANT = re.compile(r"constexpr\s+(?:Hertz|Milliseconds)\s+(\w+)\s*=\s*([^;]+);")
+TABLE_ROW = re.compile(
+    r"\{\s*(\d+),\s*[\w:]+,\s*\"([^\"]+)\",\s*&\w+,\s*(\w+),\s*(\d+),\s*\d+,\s*Scheduling::(\w+),\s*Role::(\w+),"
+)
+ROLES = {"TimeCritical": "time_critical", "General": "general", "Blocking": "blocking"}
+
+
+def evaluate_constants(source, amplifier):
+    """Milliseconds and hertz constants of main.cpp, in milliseconds and hertz."""
+    constants = {}
+    for name, expression in CONSTANT.findall(source):
+        if name == "DEBUG_RATE_AMPLIFIER":
+            constants[name] = amplifier
+            continue
+        python = re.sub(r"calculateCyclePeriodMs\(([^)]*)\)", r"(1000.0 / (\1))", expression)
+        try:
+            constants[name] = eval(python, {"__builtins__": {}}, dict(constants))
+        except (NameError, SyntaxError):
+            continue  # refers to something outside main.cpp; not a task period
+    return constants
+
+
+def read_task_table(source, amplifier, measured):
+    """Tasks of TASK_TABLE; interrupt load, critical sections and the drain task's nominal cost are taken
+    from partition_sim.task_set(), which models what the table cannot express."""
+    constants = evaluate_constants(source, amplifier)
+    interference = {task.name: task for task in task_set(square_wave_hz=1000.0)}
+    tasks = []
+    for number, name, period, wcet, scheduling, role in TABLE_ROW.findall(source):
+        modelled = interference.get(name, Task(name, 0, 0, ""))
+        background = scheduling == "Background"
+        wcet_us = float(measured.get(int(number), wcet))
+        if background and wcet_us == 0:
+            wcet_us = modelled.wcet_us
+        tasks.append(
+            Task(
+                name,
+                constants[period] * 1000.0,
+                wcet_us,
+                ROLES[role],
+                background=background,
+                critical_us=modelled.critical_us,
+                isr_interval_us=modelled.isr_interval_us,
+                isr_cost_us=modelled.isr_cost_us,
+            )
+        )
+    if not tasks:
+        sys.exit(f"no TASK_TABLE rows found in {MAIN_CPP}")
+    assign_priorities(tasks)
+    partition(tasks)
+    return tasks
+
+
+def read_measured_wcets(path):
+    """Largest max-execution value of each task's task_timing records in a decode_log.py CSV."""
+    measured = {}
+    with open(path, newline="") as stream:
+        for row in csv.reader(stream):
+            if len(row) >= 5 and row[2] == "task_timing":
+                task = int(row[1])
+                measured[task] = max(measured.get(task, 0), int(row[4]))
+    return measured
+
+
+def response_time(task, tasks):
+    """Worst-case response time in us, or None if it exceeds the deadline (the period)."""
+    same_core = [t for t in tasks if t.core == task.core and t is not task]
+    interfering = [t for t in same_core if not t.background and t.priority >= task.priority]
+    isrs = [t for t in tasks if t.core == task.core and t.isr_interval_us]
+    blocking = max([t.critical_us for t in same_core if t.priority < task.priority] + [0.0])
+
+    response = task.wcet_us + blocking
+    while True:
+        demand = task.wcet_us + blocking
+        demand += sum(math.ceil(response / t.period_us) * t.wcet_us for t in interfering)
+        demand += sum(math.ceil(response / t.isr_interval_us) * t.isr_cost_us for t in isrs)
+        if demand > task.period_us:
+            return None
+        if demand <= response:
+            return response
+        response = demand
+
+
+def analyse(tasks):
+    return {task.name: response_time(task, tasks) for task in tasks if not task.background}
+
+
+def feasible(source, amplifier, measured):
+    return all(r is not None for r in analyse(read_task_table(source, amplifier, measured)).values())
+
+
+def maximum_amplifier(source, measured, ceiling, resolution):
+    """Binary search; response times only grow as periods shrink, so feasibility is monotonic."""
+    if not feasible(source, resolution, measured):
+        return 0.0
+    low, high = resolution, ceiling
+    if feasible(source, high, measured):
+        return high
+    while high - low > resolution:
+        middle = (low + high) / 2
+        if feasible(source, middle, measured):
+            low = middle
+        else:
+            high = middle
+    return low
+
+
+def report(tasks, simulated_us):
+    responses = analyse(tasks)
+    worst = simulate(tasks, True, simulated_us, {task.name: 0.0 for task in tasks})
+    print(f"{'task':<10} {'prio':>4} {'core':>4} {'period us':>10} {'WCET us':>8} {'WCRT (RTA) us':>14} {'WCRT (sim) us':>14}")
+    for task in tasks:
+        analysed = "-" if task.background else ("MISS" if responses[task.name] is None else f"{responses[task.name]:.0f}")
+        print(
+            f"{task.name:<10} {task.priority:>4} {task.core:>4} {task.period_us:>10.0f} {task.wcet_us:>8.0f}"
+            f" {analysed:>14} {worst[task.name]:>14.0f}"
+        )
+    for core in range(NUMBER_OF_CORES):
+        load = sum(t.wcet_us / t.period_us for t in tasks if t.core == core and not t.background)
+        print(f"core {core}: utilisation {load * 100:.2f} %")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--source", default=MAIN_CPP, help="main.cpp holding TASK_TABLE")
+    parser.add_argument("--measured", help="decode_log.py CSV whose task_timing maxima replace the budgets")
+    parser.add_argument("--amplifier", type=float, default=1.0, help="DEBUG_RATE_AMPLIFIER to report on")
+    parser.add_argument("--ceiling", type=float, default=1000.0, help="largest amplifier to search")
+    parser.add_argument("--resolution", type=float, default=0.01)
+    parser.add_argument("--horizon", type=float, default=10.0, help="simulated seconds")
+    args = parser.parse_args()
+
+    with open(args.source) as stream:
+        source = stream.read()
+    measured = read_measured_wcets(args.measured) if args.measured else {}
+
+    print(f"DEBUG_RATE_AMPLIFIER = {args.amplifier:g}")
+    report(read_task_table(source, args.amplifier, measured), args.horizon * 1e6)
+
+    limit = maximum_amplifier(source, measured, args.ceiling, args.resolution)
+    print()
+    if limit == 0.0:
+        print("no amplifier keeps every deadline")
+        return
+    print(f"largest DEBUG_RATE_AMPLIFIER keeping every deadline: {limit:.2f}")
+    report(read_task_table(source, limit, measured), args.horizon * 1e6)
+
+
+if __name__ == "__main__":
+    main()
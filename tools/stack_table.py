@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Turns the stack_usage and heap_usage records in a decoded log into a stack-size table for TASK_TABLE.
+
+Reads the CSV written by tools/decode_log.py and keeps, per task, the largest peak seen over the run.
+Recommended sizes are the peak plus the margin, rounded up to 16 bytes, the same rule as
+MemoryProfiler::recommended_stack_bytes(); they are recomputed here so the margin can be changed
+without rebuilding.
+
+    tools/decode_log.py capture.bin | tools/stack_table.py
+    tools/stack_table.py --margin 40 log.csv
+
+Captures from the native build measure host stacks, which are larger than the ESP32's; use them to
+compare tasks with each other, not to size the target.
+"""
+import argparse
+import csv
+import sys
+
+STACK_GRANULARITY = 16
+
+
+def recommended_stack_bytes(peak_bytes, margin_percent):
+    with_margin = peak_bytes + (peak_bytes * margin_percent + 99) // 100
+    return (with_margin + STACK_GRANULARITY - 1) // STACK_GRANULARITY * STACK_GRANULARITY
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", nargs="?", help="CSV from decode_log.py (default: stdin)")
+    parser.add_argument("--margin", type=int, default=25, help="safety margin in percent (default: 25)")
+    args = parser.parse_args()
+
+    stream = open(args.log, newline="") if args.log else sys.stdin
+    stacks = {}  # task -> (peak, allocated)
+    heap = None  # (free, minimum free) of the last report
+    for row in csv.reader(stream):
+        if len(row) < 3:
+            continue
+        if row[2] == "stack_usage":
+            task, peak, allocated = int(row[1]), int(row[3]), int(row[4])
+            previous_peak = stacks.get(task, (0, 0))[0]
+            stacks[task] = (max(peak, previous_peak), allocated)
+        elif row[2] == "heap_usage":
+            heap = (int(row[3]), int(row[4]))
+
+    if not stacks:
+        sys.exit("no stack_usage records in the log")
+
+    print(f"{'task':>4} {'allocated':>9} {'peak':>6} {'recommended':>11} {'saving':>7}")
+    total_allocated = total_recommended = 0
+    for task in sorted(stacks):
+        peak, allocated = stacks[task]
+        recommended = recommended_stack_bytes(peak, args.margin)
+        total_allocated += allocated
+        total_recommended += recommended
+        print(f"{task:>4} {allocated:>9} {peak:>6} {recommended:>11} {allocated - recommended:>7}")
+    print(f"{'all':>4} {total_allocated:>9} {'':>6} {total_recommended:>11} {total_allocated - total_recommended:>7}")
+    if heap:
+        print(f"heap: {heap[0]} bytes free, {heap[1]} at the lowest")
+
+
+if __name__ == "__main__":
+    main()